@@ -38,12 +38,15 @@ enum AXERegister {
   AXE_REG_KSP
 };
 
+#define AXE_NUM_REGISTERS (AXE_REG_KSP + 1)
+
 enum AXEStopReason {
   AXE_STOP_BREAKPOINT,
   AXE_STOP_WATCHPOINT,
   AXE_STOP_TIMEOUT,
   AXE_STOP_EXIT,
-  AXE_STOP_NO_RUNNABLE_THREADS
+  AXE_STOP_NO_RUNNABLE_THREADS,
+  AXE_STOP_PREDICATE
 };
 
 enum AXEWatchpointType {
@@ -51,6 +54,22 @@ enum AXEWatchpointType {
   AXE_WATCHPOINT_WRITE
 };
 
+/// Unsigned comparisons for breakpoint conditions.
+enum AXECompareOp {
+  AXE_COMPARE_EQ,
+  AXE_COMPARE_NE,
+  AXE_COMPARE_LT,
+  AXE_COMPARE_LE,
+  AXE_COMPARE_GT,
+  AXE_COMPARE_GE
+};
+
+enum AXEChanendOutputType {
+  AXE_CHANEND_OUTPUT_TOKEN,
+  AXE_CHANEND_OUTPUT_CONTROL_TOKEN,
+  AXE_CHANEND_OUTPUT_WORD
+};
+
 enum AXENodeType {
   AXE_NODE_TYPE_XS1_L   = 0,
   AXE_NODE_TYPE_XS1_G   = 1,
@@ -61,6 +80,59 @@ typedef struct AXEOpaqueSystem *AXESystemRef;
 typedef struct AXEOpaqueCore *AXECoreRef;
 typedef struct AXEOpaqueThread *AXEThreadRef;
 
+/* Snapshot of the registers of a thread, indexed by AXERegister. */
+typedef struct {
+  AXECoreRef core;
+  AXEThreadRef thread;
+  int threadID;
+  unsigned regs[AXE_NUM_REGISTERS];
+} AXEThreadState;
+
+/* A region of memory to read with axeReadMemoryRegions(). */
+typedef struct {
+  unsigned address;
+  void *dst;
+  unsigned length;
+} AXEMemoryRegion;
+
+/* A range of memory returned by axeGetChangedMemory(). */
+typedef struct {
+  unsigned address;
+  unsigned length;
+} AXEMemoryRange;
+
+/* Traffic counters for a channel end or switch. Times are in cycles. */
+typedef struct {
+  unsigned long long tokensSent;
+  /* Packets sent, counted when the route is opened. */
+  unsigned long long packetsSent;
+  /* Packets that had to wait for the route to be opened. */
+  unsigned long long routeWaits;
+  /* Time output was blocked waiting for a route or buffer space. */
+  unsigned long long blockedTime;
+  unsigned long long tokensReceived;
+  unsigned long long packetsReceived;
+  /* Packets that had to wait for a packet from another source to finish. */
+  unsigned long long claimWaits;
+} AXEChanendStats;
+
+/* Traffic counters for one direction of an XLink. Tokens, busy time and
+ * contention time are only counted when XLink timing is modelled. */
+typedef struct {
+  unsigned long long packetsSent;
+  unsigned long long tokensSent;
+  unsigned long long busyTime;
+  unsigned long long contentionTime;
+} AXEXLinkStats;
+
+/* Callbacks return non zero to stop the simulation. */
+typedef int (*AXEBreakpointCallback)(void *data, AXEThreadRef thread);
+typedef int (*AXEPortCallback)(void *data, AXECoreRef core, unsigned portID,
+                               unsigned value);
+typedef int (*AXEChanendOutputCallback)(void *data, AXEThreadRef thread,
+                                        unsigned chanendID, unsigned value,
+                                        AXEChanendOutputType type);
+
 void axeRemoveThreadFromRunQueue(AXEThreadRef thread);
 void axeAddThreadToRunQueue(AXEThreadRef thread);
 
@@ -80,6 +152,31 @@ int axeWriteMemory(AXECoreRef core, unsigned address, const void *src,unsigned l
 int axeReadMemory(AXECoreRef core, unsigned address, void *dst, unsigned length);
 int axeSetBreakpoint(AXECoreRef core, unsigned address);
 void axeUnsetBreakpoint(AXECoreRef core, unsigned address);
+/* Breakpoint conditions are evaluated by the simulator each time the
+ * breakpoint at the address is hit. The simulation only stops if the thread
+ * matches the thread filter, all conditions are true and the breakpoint has
+ * been hit (with the conditions true) more times than the ignore count.
+ * These functions return 0 if there is no breakpoint at the address. */
+int axeAddBreakpointRegisterCondition(AXECoreRef core, unsigned address,
+                                      AXERegister reg, AXECompareOp op,
+                                      unsigned value);
+int axeAddBreakpointMemoryCondition(AXECoreRef core, unsigned address,
+                                    unsigned memAddress, unsigned size,
+                                    AXECompareOp op, unsigned value);
+/* threadNum is the number returned by axeGetThreadID or -1 for any thread. */
+int axeSetBreakpointThreadFilter(AXECoreRef core, unsigned address,
+                                 int threadNum);
+int axeSetBreakpointIgnoreCount(AXECoreRef core, unsigned address,
+                                unsigned count);
+unsigned axeGetBreakpointHitCount(AXECoreRef core, unsigned address);
+/* Clears the conditions, thread filter, ignore count and callback. */
+void axeClearBreakpointConditions(AXECoreRef core, unsigned address);
+/* Call the callback when the breakpoint is hit and its conditions are met
+ * instead of stopping. The simulation stops with AXE_STOP_BREAKPOINT if the
+ * callback returns non zero, otherwise the thread continues. For example a
+ * harness can handle system calls by setting a callback on _DoSyscall. */
+int axeSetBreakpointCallback(AXECoreRef core, unsigned address,
+                             AXEBreakpointCallback callback, void *data);
 void axeStepThreadOnce(AXEThreadRef thread);
 
 int  axeSetWatchpoint(AXECoreRef core, unsigned int startAddress, unsigned int endAddress, AXEWatchpointType type);
@@ -91,8 +188,71 @@ unsigned axeReadReg(AXEThreadRef thread, AXERegister reg);
 int axeWriteReg(AXEThreadRef thread, AXERegister reg, unsigned value);
 
 AXEStopReason axeRun(AXESystemRef system, unsigned maxCycles);
+
+/* Run predicates stop axeRun() with AXE_STOP_PREDICATE when they become
+ * true. They are checked when the state they depend on changes so the
+ * simulation otherwise runs at full speed. Each function returns an ID which
+ * is non zero on success. To stop when a symbol is reached set a breakpoint
+ * on its address. */
+/* Stop when a store makes (word & mask) == value for the aligned word. */
+unsigned axeAddMemoryPredicate(AXECoreRef core, unsigned address,
+                               unsigned mask, unsigned value);
+/* Stop when the pins of the port change such that (pins & mask) == value. */
+unsigned axeAddPortPredicate(AXECoreRef core, unsigned portID, unsigned mask,
+                             unsigned value);
+/* Stop when a thread is freed leaving count threads in use on the core. */
+unsigned axeAddThreadCountPredicate(AXECoreRef core, unsigned count);
+/* Call the callback each time the pins of the port change. */
+unsigned axeAddPortCallback(AXECoreRef core, unsigned portID,
+                            AXEPortCallback callback, void *data);
+/* Call the callback each time any chanend outputs data. This slows down
+ * channel communication while the callback is registered. */
+unsigned axeAddChanendOutputCallback(AXESystemRef system,
+                                     AXEChanendOutputCallback callback,
+                                     void *data);
+/* Remove a predicate or callback. Callbacks must not add or remove
+ * predicates. */
+void axeRemovePredicate(AXESystemRef system, unsigned id);
+/* The ID of the predicate or callback that caused the last
+ * AXE_STOP_PREDICATE stop. */
+unsigned axeGetLastPredicate(AXESystemRef system);
+
+/* Read the registers of all in-use threads on a core or in the whole system.
+ * At most maxThreads entries are written. Returns the number of in-use
+ * threads, which may be larger than maxThreads. */
+unsigned axeReadCoreThreadStates(AXECoreRef core, AXEThreadState *states,
+                                 unsigned maxThreads);
+unsigned axeReadSystemThreadStates(AXESystemRef system,
+                                   AXEThreadState *states,
+                                   unsigned maxThreads);
+/* Read a list of memory regions. Returns the number of regions read
+ * successfully. Regions that can't be read are left unchanged. */
+unsigned axeReadMemoryRegions(AXECoreRef core, const AXEMemoryRegion *regions,
+                              unsigned numRegions);
+/* When enabled, memory written between axeRun() being called and the
+ * simulation stopping can be queried with axeGetChangedMemory(). */
+void axeSetTrackMemoryChanges(AXESystemRef system, int enable);
+/* Get the ranges of the core's RAM that were written during the last call to
+ * axeRun(). Ranges are aligned to 64 bytes. At most maxRanges entries are
+ * written. Returns the number of changed ranges, which may be larger than
+ * maxRanges, or -1 if memory changes aren't tracked. */
+int axeGetChangedMemory(AXESystemRef system, AXECoreRef core,
+                        AXEMemoryRange *ranges, unsigned maxRanges);
 AXEThreadRef axeGetThreadForLastBreakpoint(AXESystemRef system);
 
+/* Traffic statistics. Each function returns 0 if the chanend, node or link
+ * doesn't exist. */
+int axeGetChanendStats(AXECoreRef core, unsigned chanendID,
+                       AXEChanendStats *stats);
+int axeGetSSwitchStats(AXESystemRef system, int jtagIndex,
+                       AXEChanendStats *stats);
+/* Counters for tokens sent from the node over the link. */
+int axeGetXLinkStats(AXESystemRef system, int jtagIndex, unsigned link,
+                     AXEXLinkStats *stats);
+/* Model the bandwidth of XLinks and contention between packets sharing them
+ * instead of delivering tokens between nodes without delay. */
+void axeSetXLinkTiming(AXESystemRef system, int enable);
+
 #ifdef __cplusplus
 }
 
@@ -0,0 +1,83 @@
+// Copyright (c) 2012, Richard Osborne, All rights reserved
+// This software is freely distributable under a derivative of the
+// University of Illinois/NCSA Open Source License posted in
+// LICENSE.txt and at <http://github.xcore.com/>
+
+#ifndef AXE_C_cosim_h_
+#define AXE_C_cosim_h_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Layout of the POSIX shared memory object used by the cosim peripheral to
+ * exchange pin changes with another process (the peer).
+ *
+ * AXE creates and initializes the object and sets magic last. The peer opens
+ * the object by name, waits for magic and then sets peerAttached. AXE stops
+ * with an error if the peer hasn't attached within the timeout property
+ * (10 seconds by default). A peer started by the command property is killed
+ * if it hasn't exited shortly after AXE sets axeTime to UINT64_MAX.
+ *
+ * Times are in AXE ticks (2.5ns). Each side publishes a time before which it
+ * has written all of its changes: AXE sets axeTime and the peer sets
+ * peerTime. AXE only simulates up to peerTime, so the peer must be able to
+ * set peerTime beyond axeTime for the simulation to make progress, for
+ * example by the delay between seeing an input and responding to it.
+ * Changes must be written before the time is published. A side that will
+ * make no more changes sets its time to UINT64_MAX.
+ *
+ * Each ring is written by one side and read by the other. The writer fills
+ * changes[tail % AXE_COSIM_RING_SIZE] and then increments tail. The reader
+ * consumes changes[head % AXE_COSIM_RING_SIZE] and then increments head.
+ * Indices, times and flags must be accessed with acquire loads and release
+ * stores.
+ *
+ * axePid is the process ID of AXE. A peer waiting for AXE should give up if
+ * the process no longer exists.
+ */
+
+#define AXE_COSIM_MAGIC 0x4158434dU
+#define AXE_COSIM_VERSION 1
+#define AXE_COSIM_RING_SIZE 4096
+#define AXE_COSIM_MAX_PORTS 8
+
+typedef struct AXECosimChange {
+  uint64_t time;
+  uint32_t port;
+  /* Half period of a clock signal or 0 if the signal is constant. */
+  uint32_t halfPeriod;
+  /* The value of a constant signal, otherwise the time modulo the period at
+   * which the clock falls. */
+  uint32_t value;
+  uint32_t reserved;
+} AXECosimChange;
+
+typedef struct AXECosimRing {
+  uint32_t head;
+  uint32_t tail;
+  AXECosimChange changes[AXE_COSIM_RING_SIZE];
+} AXECosimRing;
+
+typedef struct AXECosimShared {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t numPorts;
+  uint32_t peerAttached;
+  uint64_t axePid;
+  uint64_t axeTime;
+  uint64_t peerTime;
+  /* Changes driven by AXE. */
+  AXECosimRing toPeer;
+  /* Changes driven by the peer. */
+  AXECosimRing fromPeer;
+} AXECosimShared;
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // AXE_C_cosim_h_
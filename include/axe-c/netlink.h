@@ -0,0 +1,59 @@
+// Copyright (c) 2012, Richard Osborne, All rights reserved
+// This software is freely distributable under a derivative of the
+// University of Illinois/NCSA Open Source License posted in
+// LICENSE.txt and at <http://github.xcore.com/>
+
+#ifndef AXE_C_netlink_h_
+#define AXE_C_netlink_h_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Layout of the POSIX shared memory object used by the shm network link to
+ * exchange Ethernet frames between two processes.
+ *
+ * The first process to open the object creates it (with O_EXCL), initializes
+ * it and sets magic last. It sends frames on rings[0]. The second process
+ * waits for magic, sets attached and sends frames on rings[1]. The creator
+ * unlinks the object once attached is set.
+ *
+ * The writer of a ring fills frames[tail % AXE_NETLINK_RING_SIZE] and then
+ * increments tail. The reader consumes frames[head % AXE_NETLINK_RING_SIZE]
+ * and then increments head. A writer which finds the ring full drops the
+ * frame. Indices and flags must be accessed with acquire loads and release
+ * stores. Frames exclude the CRC.
+ */
+
+#define AXE_NETLINK_MAGIC 0x41584e4cU
+#define AXE_NETLINK_VERSION 1
+#define AXE_NETLINK_RING_SIZE 256
+#define AXE_NETLINK_MAX_FRAME_SIZE 1518
+
+typedef struct AXENetlinkFrame {
+  uint32_t size;
+  uint8_t data[AXE_NETLINK_MAX_FRAME_SIZE];
+} AXENetlinkFrame;
+
+typedef struct AXENetlinkRing {
+  uint32_t head;
+  uint32_t tail;
+  AXENetlinkFrame frames[AXE_NETLINK_RING_SIZE];
+} AXENetlinkRing;
+
+typedef struct AXENetlinkShared {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t attached;
+  uint32_t reserved;
+  AXENetlinkRing rings[2];
+} AXENetlinkShared;
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // AXE_C_netlink_h_
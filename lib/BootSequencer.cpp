@@ -89,12 +89,14 @@ namespace {
     BreakpointManager &breakpointManager;
     SyscallHandler &syscallHandler;
     ElfManager &elfManager;
+    bool predecode;
     ExecutionState(SystemState &s, BreakpointManager &BM, SyscallHandler &SH,
-                   ElfManager &EM) :
+                   ElfManager &EM, bool p) :
       sys(s),
       breakpointManager(BM),
       syscallHandler(SH),
-      elfManager(EM) { }
+      elfManager(EM),
+      predecode(p) { }
   };
 }
 
@@ -238,6 +240,8 @@ int BootSequenceStepElf::execute(ExecutionState &state)
       if (core->isValidRamAddress(phdr.p_paddr) &&
           core->isValidRamAddress(phdr.p_paddr + phdr.p_memsz)) {
         core->writeMemory(phdr.p_paddr, &buf[phdr.p_offset], phdr.p_filesz);
+        if (state.predecode && (phdr.p_flags & PF_X))
+          core->predecode(phdr.p_paddr, phdr.p_paddr + phdr.p_filesz);
       } else if (!hasValidVirtualAddress(phdr, *core)) {
         std::cerr << "Error data from ELF program header " << i;
         std::cerr << " does not fit in memory" << std::endl;
@@ -289,8 +293,16 @@ int BootSequenceStepRun::executeAux(ExecutionState &state)
   SyscallHandler &SH = state.syscallHandler;
   SH.setDoneSyscallsRequired(numDoneSyscalls);
   StopReason stopReason = sys.run();
-  while (stopReason.getType() == StopReason::BREAKPOINT) {
+  while (stopReason.getType() == StopReason::BREAKPOINT ||
+         stopReason.getType() == StopReason::WATCHPOINT) {
     Thread *thread = stopReason.getThread();
+    if (stopReason.getType() == StopReason::WATCHPOINT) {
+      // The access has completed. Report it and carry on.
+      std::cout << "Watchpoint hit by thread " << thread->getNum() << '\n';
+      thread->schedule();
+      stopReason = sys.run();
+      continue;
+    }
     Core &core = thread->getParent();
     uint32_t address = thread->getRealPc();
     int retval;
@@ -332,7 +344,8 @@ int BootSequenceStepRun::execute(ExecutionState &state)
 
 BootSequencer::BootSequencer(SystemState &s) :
   sys(s),
-  syscallHandler(new SyscallHandler)
+  syscallHandler(new SyscallHandler(s.getConsoleSink())),
+  predecode(false)
 {
 }
 
@@ -480,7 +493,7 @@ int BootSequencer::execute() {
   };
   syscallHandler->setDescribeExceptionCallback(describeExceptionCallback);
   ExecutionState executionState(sys, breakpointManager, *syscallHandler,
-                                elfManager);
+                                elfManager, predecode);
   for (BootSequenceStep *step : steps) {
     int status = step->execute(executionState);
     if (status != 0)
@@ -24,6 +24,7 @@ class BootSequencer {
   BreakpointManager breakpointManager;
   SyscallHandler *syscallHandler;
   std::vector<BootSequenceStep*> steps;
+  bool predecode;
   void setEntryPointToRom();
   void eraseAllButLastImage();
   void setLoadImages(bool value);
@@ -36,6 +37,9 @@ public:
   void addRun(unsigned numDoneSyscalls);
   void populateFromXE(XE &xe);
   void adjustForSPIBoot();
+  /// Decode executable ELF segments when they are loaded instead of on
+  /// their first execution.
+  void setPredecode(bool value) { predecode = value; }
   int execute();
   SyscallHandler* getSyscallHandler();
   /// Initialize ELF handling global state. Normally this state is initialized
@@ -0,0 +1,62 @@
+// Copyright (c) 2012, Richard Osborne, All rights reserved
+// This software is freely distributable under a derivative of the
+// University of Illinois/NCSA Open Source License posted in
+// LICENSE.txt and at <http://github.xcore.com/>
+
+#include "BreakpointCondition.h"
+#include "Thread.h"
+#include "Core.h"
+
+using namespace axe;
+
+static bool compare(BreakpointComparison::Op op, uint32_t a, uint32_t b)
+{
+  switch (op) {
+  case BreakpointComparison::EQ: return a == b;
+  case BreakpointComparison::NE: return a != b;
+  case BreakpointComparison::LT: return a < b;
+  case BreakpointComparison::LE: return a <= b;
+  case BreakpointComparison::GT: return a > b;
+  case BreakpointComparison::GE: return a >= b;
+  }
+  return false;
+}
+
+bool BreakpointComparison::evaluate(Thread &t) const
+{
+  uint32_t actual = 0;
+  switch (kind) {
+  case REGISTER:
+    actual = t.reg(reg);
+    break;
+  case PC:
+    actual = t.getRealPc();
+    break;
+  case SR:
+    actual = t.sr.to_ulong();
+    break;
+  case MEMORY:
+    {
+      uint8_t buf[4];
+      if (!t.getParent().readMemory(address, buf, size))
+        return false;
+      for (unsigned i = 0; i < size; i++)
+        actual |= buf[i] << (8 * i);
+    }
+    break;
+  }
+  return compare(op, actual, value);
+}
+
+bool BreakpointCondition::hit(Thread &t)
+{
+  if (threadNum >= 0 && t.getNum() != static_cast<unsigned>(threadNum))
+    return false;
+  for (const BreakpointComparison &comparison : comparisons) {
+    if (!comparison.evaluate(t))
+      return false;
+  }
+  if (++hitCount <= ignoreCount)
+    return false;
+  return !callback || callback(t);
+}
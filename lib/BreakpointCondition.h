@@ -0,0 +1,94 @@
+// Copyright (c) 2012, Richard Osborne, All rights reserved
+// This software is freely distributable under a derivative of the
+// University of Illinois/NCSA Open Source License posted in
+// LICENSE.txt and at <http://github.xcore.com/>
+
+#ifndef _BreakpointCondition_h
+#define _BreakpointCondition_h
+
+#include <functional>
+#include <vector>
+#include <stdint.h>
+#include "Register.h"
+
+namespace axe {
+
+class Thread;
+
+/// A comparison between a register or memory location and a constant.
+class BreakpointComparison {
+public:
+  enum Kind {
+    REGISTER,
+    PC,
+    SR,
+    MEMORY
+  };
+  /// Comparisons are unsigned.
+  enum Op {
+    EQ,
+    NE,
+    LT,
+    LE,
+    GT,
+    GE
+  };
+private:
+  Kind kind;
+  Register::Reg reg;
+  uint32_t address;
+  unsigned size;
+  Op op;
+  uint32_t value;
+  BreakpointComparison(Kind k, Register::Reg r, uint32_t a, unsigned s, Op o,
+                       uint32_t v) :
+    kind(k), reg(r), address(a), size(s), op(o), value(v) {}
+public:
+  static BreakpointComparison getRegister(Register::Reg reg, Op op,
+                                          uint32_t value) {
+    return BreakpointComparison(REGISTER, reg, 0, 0, op, value);
+  }
+  static BreakpointComparison get(Kind kind, Op op, uint32_t value) {
+    return BreakpointComparison(kind, Register::R0, 0, 0, op, value);
+  }
+  static BreakpointComparison getMemory(uint32_t address, unsigned size, Op op,
+                                        uint32_t value) {
+    return BreakpointComparison(MEMORY, Register::R0, address, size, op,
+                                value);
+  }
+  /// Evaluate the comparison for the specified thread. Comparisons against
+  /// memory that can't be read evaluate to false.
+  bool evaluate(Thread &t) const;
+};
+
+/// Conditions on stopping at a breakpoint. Each time the breakpoint is hit by
+/// a thread that matches the thread filter and all comparisons are true the
+/// hit count is incremented. Once the hit count exceeds the ignore count the
+/// callback, if any, decides whether the simulation stops.
+class BreakpointCondition {
+public:
+  typedef std::function<bool(Thread &t)> Callback;
+private:
+  std::vector<BreakpointComparison> comparisons;
+  Callback callback;
+  /// Thread number that the breakpoint applies to, -1 for all threads.
+  int threadNum;
+  uint32_t ignoreCount;
+  uint64_t hitCount;
+public:
+  BreakpointCondition() : threadNum(-1), ignoreCount(0), hitCount(0) {}
+  void addComparison(const BreakpointComparison &c) {
+    comparisons.push_back(c);
+  }
+  void setThreadFilter(int num) { threadNum = num; }
+  void setIgnoreCount(uint32_t count) { ignoreCount = count; }
+  void setCallback(const Callback &c) { callback = c; }
+  uint64_t getHitCount() const { return hitCount; }
+  /// Called when the breakpoint is hit. Returns whether the simulation
+  /// should stop.
+  bool hit(Thread &t);
+};
+
+} // End axe namespace
+
+#endif // _BreakpointCondition_h
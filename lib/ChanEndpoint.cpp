@@ -26,10 +26,12 @@ bool ChanEndpoint::claim(ChanEndpoint *newSource, bool &junkPacket)
   // Check if we are already in the middle of a packet.
   if (source) {
     queue.push(newSource);
+    ++stats.claimWaits;
     return false;
   }
   // Claim the channel
   source = newSource;
+  ++stats.packetsReceived;
   return true;
 }
 
@@ -41,5 +43,6 @@ void ChanEndpoint::release(ticks_t time)
   }
   source = queue.front();
   queue.pop();
+  ++stats.packetsReceived;
   source->notifyDestClaimed(time);
 }
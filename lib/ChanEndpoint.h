@@ -11,6 +11,30 @@
 
 namespace axe {
 
+/// Counters for the traffic passing through a channel endpoint.
+struct ChanEndpointStats {
+  uint64_t tokensSent;
+  /// Number of packets sent, counted when the route is opened.
+  uint64_t packetsSent;
+  /// Number of packets that had to wait for the route to be opened.
+  uint64_t routeWaits;
+  /// Total time output was blocked waiting for a route or for buffer space.
+  ticks_t blockedTime;
+  uint64_t tokensReceived;
+  uint64_t packetsReceived;
+  /// Number of packets that had to wait for a packet from another source to
+  /// this endpoint to finish.
+  uint64_t claimWaits;
+  ChanEndpointStats() :
+    tokensSent(0),
+    packetsSent(0),
+    routeWaits(0),
+    blockedTime(0),
+    tokensReceived(0),
+    packetsReceived(0),
+    claimWaits(0) {}
+};
+
 class ChanEndpoint {
 private:
   /// Should incoming packets be junked?
@@ -20,6 +44,7 @@ private:
   /// The source of the current packet, 0 if not receiving a packet.
   ChanEndpoint *source;
 protected:
+  ChanEndpointStats stats;
   void setJunkIncoming(bool value) { junkIncoming = value; }
   ChanEndpoint *getSource() const { return source; }  
   /// End the current packet being sent to the channel end.
@@ -32,6 +57,8 @@ protected:
   ChanEndpoint();
   ~ChanEndpoint() = default;
 public:
+  const ChanEndpointStats &getStats() const { return stats; }
+
   /// Give notification that a route to the destination has been opened.
   virtual void notifyDestClaimed(ticks_t time) = 0;
 
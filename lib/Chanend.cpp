@@ -5,6 +5,8 @@
 
 #include "Chanend.h"
 #include "Core.h"
+#include "ProcessorNode.h"
+#include "SystemState.h"
 #include <algorithm>
 
 using namespace axe;
@@ -21,12 +23,14 @@ bool Chanend::canAcceptTokens(unsigned tokens)
 
 void Chanend::receiveDataToken(ticks_t time, uint8_t value)
 {
+  ++stats.tokensReceived;
   buf.push_back(Token(value));
   update(time);
 }
 
 void Chanend::receiveDataTokens(ticks_t time, uint8_t *values, unsigned num)
 {
+  stats.tokensReceived += num;
   for (unsigned i = 0; i < num; i++) {
     buf.push_back(Token(values[i]));
   }
@@ -35,6 +39,7 @@ void Chanend::receiveDataTokens(ticks_t time, uint8_t *values, unsigned num)
 
 void Chanend::receiveCtrlToken(ticks_t time, uint8_t value)
 {
+  ++stats.tokensReceived;
   switch (value) {
   case CT_END:
     buf.push_back(Token(value, true));
@@ -51,36 +56,48 @@ void Chanend::receiveCtrlToken(ticks_t time, uint8_t value)
   }
 }
 
-void Chanend::notifyDestClaimed(ticks_t time)
+void Chanend::setPausedOut(Thread &t, ticks_t time)
+{
+  pausedOut = &t;
+  pausedOutTime = time;
+}
+
+void Chanend::wakePausedOut(ticks_t time)
 {
   if (pausedOut) {
+    if (time > pausedOutTime)
+      stats.blockedTime += time - pausedOutTime;
     pausedOut->time = time;
     pausedOut->schedule();
     pausedOut = 0;
   }
 }
 
-// TODO can this be merged with the above function.
+void Chanend::notifyDestClaimed(ticks_t time)
+{
+  wakePausedOut(time);
+}
+
 void Chanend::notifyDestCanAcceptTokens(ticks_t time, unsigned tokens)
 {
-  if (pausedOut) {
-    pausedOut->time = time;
-    pausedOut->schedule();
-    pausedOut = 0;
-  }
+  wakePausedOut(time);
 }
 
 bool Chanend::openRoute()
 {
   if (inPacket)
     return true;
-  dest = getOwner().getParent().getChanendDest(destID);
+  dest = getOwner().getParent().getChanendDest(destID, this);
   if (!dest) {
     // TODO if dest in unset should give a link error exception.
     junkPacket = true;
   } else if (!dest->claim(this, junkPacket)) {
+    ++stats.routeWaits;
     return false;
+  } else {
+    getOwner().getParent().getParent()->countPacketSent(destID);
   }
+  ++stats.packetsSent;
   inPacket = true;
   return true;
 }
@@ -104,33 +121,36 @@ bool Chanend::getData(Thread &thread, uint32_t &result, ticks_t time)
 }
 
 Resource::ResOpResult Chanend::
-outt(Thread &thread, uint8_t value, ticks_t time)
+outtAux(Thread &thread, uint8_t value, ticks_t time)
 {
   if (!openRoute()) {
-    pausedOut = &thread;
+    setPausedOut(thread, time);
     return DESCHEDULE;
   }
   if (junkPacket)
     return CONTINUE;
   if (!dest->canAcceptToken()) {
-    pausedOut = &thread;
+    setPausedOut(thread, time);
     return DESCHEDULE;
   }
+  if (outputObserved)
+    observeOutput(thread, value, RunPredicates::DATA_TOKEN, time);
+  ++stats.tokensSent;
   dest->receiveDataToken(time, value);
   return CONTINUE;
 }
 
 Resource::ResOpResult Chanend::
-out(Thread &thread, uint32_t value, ticks_t time)
+outAux(Thread &thread, uint32_t value, ticks_t time)
 {
   if (!openRoute()) {
-    pausedOut = &thread;
+    setPausedOut(thread, time);
     return DESCHEDULE;
   }
   if (junkPacket)
     return CONTINUE;
   if (!dest->canAcceptTokens(4)) {
-    pausedOut = &thread;
+    setPausedOut(thread, time);
     return DESCHEDULE;
   }
   // Channels are big endian
@@ -140,6 +160,9 @@ out(Thread &thread, uint32_t value, ticks_t time)
     static_cast<uint8_t>(value >> 8),
     static_cast<uint8_t>(value)
   };
+  if (outputObserved)
+    observeOutput(thread, value, RunPredicates::WORD, time);
+  stats.tokensSent += 4;
   dest->receiveDataTokens(time, tokens, 4);
   return CONTINUE;
 }
@@ -148,7 +171,7 @@ Resource::ResOpResult Chanend::
 outct(Thread &thread, uint8_t value, ticks_t time)
 {
   if (!openRoute()) {
-    pausedOut = &thread;
+    setPausedOut(thread, time);
     return DESCHEDULE;
   }
   if (junkPacket) {
@@ -159,9 +182,12 @@ outct(Thread &thread, uint8_t value, ticks_t time)
     return CONTINUE;
   }
   if (!dest->canAcceptToken()) {
-    pausedOut = &thread;
+    setPausedOut(thread, time);
     return DESCHEDULE;
   }  
+  if (outputObserved)
+    observeOutput(thread, value, RunPredicates::CONTROL_TOKEN, time);
+  ++stats.tokensSent;
   dest->receiveCtrlToken(time, value);
   if (value == CT_END || value == CT_PAUSE) {
     inPacket = false;
@@ -201,25 +227,23 @@ testwct(Thread &thread, ticks_t time, unsigned &position)
   return true;
 }
 
-uint8_t Chanend::poptoken(ticks_t time)
-{
-  assert(!buf.empty() && "poptoken on empty buf");
-  uint8_t value = buf.front().getValue();
-  buf.pop_front();
-  if (getSource()) {
-    getSource()->notifyDestCanAcceptTokens(time, buf.remaining());
-  }
-  return value;
-}
-
 void Chanend::setPausedIn(Thread &t, bool wordInput)
 {
   pausedIn = &t;
   waitForWord = wordInput;
 }
 
+void Chanend::
+observeOutput(Thread &thread, uint32_t value,
+              RunPredicates::ChanendOutputType type, ticks_t time)
+{
+  SystemState &system = *thread.getParent().getParent()->getParent();
+  system.getRunPredicates().seeChanendOutput(thread, *this, value, type,
+                                                time);
+}
+
 Resource::ResOpResult Chanend::
-intoken(Thread &thread, ticks_t time, uint32_t &val)
+intokenAux(Thread &thread, ticks_t time, uint32_t &val)
 {
   bool isCt;
   if (!testct(thread, time, isCt)) {
@@ -245,7 +269,7 @@ inct(Thread &thread, ticks_t time, uint32_t &val)
 }
 
 Resource::ResOpResult Chanend::
-chkct(Thread &thread, ticks_t time, uint32_t value)
+chkctAux(Thread &thread, ticks_t time, uint32_t value)
 {
   bool isCt;
   if (!testct(thread, time, isCt)) {
@@ -258,7 +282,7 @@ chkct(Thread &thread, ticks_t time, uint32_t value)
 }
 
 Resource::ResOpResult Chanend::
-in(Thread &thread, ticks_t time, uint32_t &value)
+inAux(Thread &thread, ticks_t time, uint32_t &value)
 {
   unsigned Position;
   if (!testwct(thread, time, Position))
@@ -267,9 +291,7 @@ in(Thread &thread, ticks_t time, uint32_t &value)
     return ILLEGAL;
   value = (buf[0] << 24) | (buf[1] << 16) | (buf[2] << 8) | buf[3];
   buf.pop_front(4);
-  if (getSource()) {
-    getSource()->notifyDestCanAcceptTokens(time, buf.remaining());
-  }
+  notifySourceCanAcceptTokens(time);
   return CONTINUE;
 }
 
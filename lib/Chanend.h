@@ -10,10 +10,11 @@
 #include "ChanEndpoint.h"
 #include "ring_buffer.h"
 #include "Token.h"
+#include "RunPredicates.h"
 
 namespace axe {
 
-class Chanend : public EventableResource, public ChanEndpoint {
+class Chanend final : public EventableResource, public ChanEndpoint {
 private:
   // The destination resource ID.
   uint32_t destID;
@@ -25,6 +26,8 @@ private:
   TokenBuffer buf;
   /// Thread paused on an output instruction, 0 if none.
   Thread *pausedOut;
+  /// Time at which pausedOut was paused.
+  ticks_t pausedOutTime;
   /// Thread paused on an input instruction, 0 if none.
   Thread *pausedIn;
   /// Is the pausedIn thread waiting for a word? Only valid if pausedIn is set.
@@ -33,6 +36,8 @@ private:
   bool inPacket;
   /// Should be current packet be junked?
   bool junkPacket;
+  /// Should output be reported to the run predicates?
+  bool outputObserved;
 
   /// Update the channel end after the data is placed in the buffer.
   void update(ticks_t time);
@@ -72,12 +77,52 @@ private:
   void notifyDestCanAcceptTokens(ticks_t time, unsigned tokens) override;
 
   /// Input a token. You must check beforehand if there is data available.
-  uint8_t poptoken(ticks_t time);
+  uint8_t poptoken(ticks_t time)
+  {
+    assert(!buf.empty() && "poptoken on empty buf");
+    uint8_t value = buf.front().getValue();
+    buf.pop_front();
+    notifySourceCanAcceptTokens(time);
+    return value;
+  }
+
+  void notifySourceCanAcceptTokens(ticks_t time)
+  {
+    if (getSource()) {
+      getSource()->notifyDestCanAcceptTokens(time, buf.remaining());
+    }
+  }
+
+  /// Returns whether the first n tokens in the buffer are data tokens. The
+  /// caller must check at least n tokens are buffered.
+  bool hasDataTokens(unsigned n) const
+  {
+    for (unsigned i = 0; i < n; i++) {
+      if (buf[i].isControl())
+        return false;
+    }
+    return true;
+  }
+
+  // Slow paths of the inline I/O operations below. These handle opening
+  // routes, pausing the thread and illegal operations.
+  ResOpResult outtAux(Thread &thread, uint8_t value, ticks_t time);
+  ResOpResult outAux(Thread &thread, uint32_t value, ticks_t time);
+  ResOpResult intokenAux(Thread &thread, ticks_t time, uint32_t &val);
+  ResOpResult chkctAux(Thread &thread, ticks_t time, uint32_t value);
+  ResOpResult inAux(Thread &thread, ticks_t time, uint32_t &val);
 
   void setPausedIn(Thread &t, bool wordInput);
+  void setPausedOut(Thread &t, ticks_t time);
+  void wakePausedOut(ticks_t time);
+  void observeOutput(Thread &thread, uint32_t value,
+                     RunPredicates::ChanendOutputType type, ticks_t time);
 
 public:
-  Chanend() : EventableResource(RES_TYPE_CHANEND) {}
+  Chanend() :
+    EventableResource(RES_TYPE_CHANEND), outputObserved(false) {}
+
+  void setOutputObserved(bool value) { outputObserved = value; }
 
   bool alloc(Thread &t) override
   {
@@ -105,13 +150,63 @@ public:
   bool setData(Thread &thread, uint32_t value, ticks_t time) override;
   bool getData(Thread &thread, uint32_t &value, ticks_t time) override;
 
-  ResOpResult outt(Thread &thread, uint8_t value, ticks_t time);
+  // The common I/O operations are defined inline with a fast path for the
+  // case where a route is already open and the destination has room, or the
+  // data is already buffered. The class is final so calls through a Chanend
+  // pointer bind directly to these definitions.
+  ResOpResult outt(Thread &thread, uint8_t value, ticks_t time)
+  {
+    if (inPacket && !junkPacket && !outputObserved &&
+        dest->canAcceptToken()) {
+      ++stats.tokensSent;
+      dest->receiveDataToken(time, value);
+      return CONTINUE;
+    }
+    return outtAux(thread, value, time);
+  }
+
   ResOpResult outct(Thread &thread, uint8_t value, ticks_t time);
   
-  ResOpResult out(Thread &thread, uint32_t value, ticks_t time) override;
-  ResOpResult intoken(Thread &thread, ticks_t time, uint32_t &val);
+  ResOpResult out(Thread &thread, uint32_t value, ticks_t time) override
+  {
+    if (inPacket && !junkPacket && !outputObserved &&
+        dest->canAcceptTokens(4)) {
+      // Channels are big endian
+      uint8_t tokens[4] = {
+        static_cast<uint8_t>(value >> 24),
+        static_cast<uint8_t>(value >> 16),
+        static_cast<uint8_t>(value >> 8),
+        static_cast<uint8_t>(value)
+      };
+      stats.tokensSent += 4;
+      dest->receiveDataTokens(time, tokens, 4);
+      return CONTINUE;
+    }
+    return outAux(thread, value, time);
+  }
+
+  ResOpResult intoken(Thread &thread, ticks_t time, uint32_t &val)
+  {
+    updateOwner(thread);
+    if (!buf.empty() && !buf.front().isControl()) {
+      val = poptoken(time);
+      return CONTINUE;
+    }
+    return intokenAux(thread, time, val);
+  }
+
   ResOpResult inct(Thread &thread, ticks_t time, uint32_t &val);
-  ResOpResult chkct(Thread &thread, ticks_t time, uint32_t value);
+
+  ResOpResult chkct(Thread &thread, ticks_t time, uint32_t value)
+  {
+    updateOwner(thread);
+    if (!buf.empty() && buf.front().isControl() &&
+        buf.front().getValue() == value) {
+      (void)poptoken(time);
+      return CONTINUE;
+    }
+    return chkctAux(thread, time, value);
+  }
 
   /// Check if there is a token available for input. If a token is available
   /// the current thread's time is adjusted to be after the time at which the
@@ -124,7 +219,17 @@ public:
   /// word.
   bool testwct(Thread &thread, ticks_t time, unsigned &position);
 
-  ResOpResult in(Thread &thread, ticks_t time, uint32_t &val) override;
+  ResOpResult in(Thread &thread, ticks_t time, uint32_t &val) override
+  {
+    updateOwner(thread);
+    if (buf.size() >= 4 && hasDataTokens(4)) {
+      val = (buf[0] << 24) | (buf[1] << 16) | (buf[2] << 8) | buf[3];
+      buf.pop_front(4);
+      notifySourceCanAcceptTokens(time);
+      return CONTINUE;
+    }
+    return inAux(thread, time, val);
+  }
 
   void run(ticks_t time) override;
 protected:
@@ -0,0 +1,173 @@
+// Copyright (c) 2012, Richard Osborne, All rights reserved
+// This software is freely distributable under a derivative of the
+// University of Illinois/NCSA Open Source License posted in
+// LICENSE.txt and at <http://github.xcore.com/>
+
+#include "CompressedWaveformWriter.h"
+#include "Config.h"
+#include <chrono>
+#if AXE_ENABLE_ZLIB
+#include <zlib.h>
+#endif
+
+using namespace axe;
+
+CompressedWaveformWriter::CompressedWaveformWriter(const std::string &name) :
+  out(name.c_str(), std::ofstream::out | std::ofstream::binary),
+  scopeOpen(false),
+  blockTime(0),
+  head(0),
+  tail(0),
+  done(false),
+  writer(&CompressedWaveformWriter::runWriter, this)
+{
+  out.write("AXEWAVE\1", 8);
+}
+
+CompressedWaveformWriter::~CompressedWaveformWriter()
+{
+  flushBlock();
+  done.store(true, std::memory_order_release);
+  writer.join();
+}
+
+void CompressedWaveformWriter::
+appendInteger(std::vector<uint8_t> &buf, uint64_t value)
+{
+  while (value >= 0x80) {
+    buf.push_back((value & 0x7f) | 0x80);
+    value >>= 7;
+  }
+  buf.push_back(value);
+}
+
+void CompressedWaveformWriter::
+appendString(std::vector<uint8_t> &buf, const std::string &s)
+{
+  appendInteger(buf, s.size());
+  buf.insert(buf.end(), s.begin(), s.end());
+}
+
+void CompressedWaveformWriter::beginScope(const std::string &name)
+{
+  scopes.push_back(Scope());
+  scopes.back().name = name;
+  scopeOpen = true;
+}
+
+void CompressedWaveformWriter::endScope()
+{
+  scopeOpen = false;
+}
+
+void CompressedWaveformWriter::declare(const std::string &name, unsigned width)
+{
+  if (!scopeOpen) {
+    // Variables outside a scope are recorded in a scope with an empty name.
+    beginScope("");
+  }
+  scopes.back().variables.push_back(std::make_pair(name, width));
+}
+
+void CompressedWaveformWriter::endDeclarations()
+{
+  std::vector<uint8_t> header;
+  appendInteger(header, scopes.size());
+  for (const Scope &scope : scopes) {
+    appendString(header, scope.name);
+    appendInteger(header, scope.variables.size());
+    for (const auto &variable : scope.variables) {
+      appendString(header, variable.first);
+      appendInteger(header, variable.second);
+    }
+  }
+  // The writer thread doesn't touch the file until the first block is
+  // queued.
+  out.write(reinterpret_cast<const char*>(&header[0]), header.size());
+  scopes.clear();
+}
+
+void CompressedWaveformWriter::beginBlock(uint64_t time)
+{
+  appendInteger(block, time);
+  blockTime = time;
+}
+
+void CompressedWaveformWriter::
+writeChange(uint64_t time, unsigned index, uint32_t value)
+{
+  if (block.empty())
+    beginBlock(time);
+  appendInteger(block, time - blockTime);
+  appendInteger(block, index);
+  appendInteger(block, value);
+  blockTime = time;
+  if (block.size() >= BLOCK_SIZE)
+    flushBlock();
+}
+
+void CompressedWaveformWriter::flushBlock()
+{
+  if (block.empty())
+    return;
+  unsigned t = tail.load(std::memory_order_relaxed);
+  // Wait for the writer thread if all blocks are in use.
+  while (t - head.load(std::memory_order_acquire) == NUM_BLOCKS)
+    std::this_thread::yield();
+  // Swap so the simulation reuses the storage of an already written block.
+  blocks[t % NUM_BLOCKS].swap(block);
+  block.clear();
+  tail.store(t + 1, std::memory_order_release);
+}
+
+static void writeUInt32(std::ofstream &out, uint32_t value)
+{
+  char buf[4] = {
+    static_cast<char>(value),
+    static_cast<char>(value >> 8),
+    static_cast<char>(value >> 16),
+    static_cast<char>(value >> 24)
+  };
+  out.write(buf, 4);
+}
+
+void CompressedWaveformWriter::writeBlock(const std::vector<uint8_t> &data)
+{
+  const uint8_t *stored = &data[0];
+  size_t storedSize = data.size();
+#if AXE_ENABLE_ZLIB
+  uLongf compressedSize = compressBound(data.size());
+  compressed.resize(compressedSize);
+  if (compress2(&compressed[0], &compressedSize, &data[0], data.size(),
+                Z_BEST_SPEED) == Z_OK &&
+      compressedSize < data.size()) {
+    stored = &compressed[0];
+    storedSize = compressedSize;
+  }
+#endif
+  writeUInt32(out, data.size());
+  writeUInt32(out, storedSize);
+  out.write(reinterpret_cast<const char*>(stored), storedSize);
+}
+
+void CompressedWaveformWriter::runWriter()
+{
+  unsigned h = head.load(std::memory_order_relaxed);
+  while (true) {
+    if (h == tail.load(std::memory_order_acquire)) {
+      if (done.load(std::memory_order_acquire)) {
+        // The last block is queued before done is set.
+        if (h == tail.load(std::memory_order_acquire))
+          break;
+        continue;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      continue;
+    }
+    std::vector<uint8_t> &data = blocks[h % NUM_BLOCKS];
+    writeBlock(data);
+    data.clear();
+    head.store(++h, std::memory_order_release);
+  }
+  out.flush();
+}
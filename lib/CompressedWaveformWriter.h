@@ -0,0 +1,88 @@
+// Copyright (c) 2012, Richard Osborne, All rights reserved
+// This software is freely distributable under a derivative of the
+// University of Illinois/NCSA Open Source License posted in
+// LICENSE.txt and at <http://github.xcore.com/>
+
+#ifndef _CompressedWaveformWriter_h_
+#define _CompressedWaveformWriter_h_
+
+#include "WaveformWriter.h"
+#include <atomic>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+namespace axe {
+
+/// Writes waveforms in a compact binary format. Value changes are encoded
+/// into blocks by the simulation. A background thread compresses full blocks
+/// and writes them to the file. Blocks are handed over through a fixed size
+/// single producer, single consumer ring so neither side takes a lock.
+///
+/// Integers are unsigned LEB128 unless stated otherwise and strings are an
+/// integer length followed by the bytes. The file consists of:
+///
+///   magic      "AXEWAVE\1" (8 bytes)
+///   numScopes  integer, followed by for each scope:
+///     name     string, empty for variables outside any scope
+///     numVars  integer, followed by for each variable:
+///       name   string
+///       width  integer
+///   blocks     until the end of the file, each:
+///     rawSize    32 bit little endian size of the decoded block
+///     storedSize 32 bit little endian size of the data that follows
+///     data       the decoded block, compressed with zlib if storedSize
+///                differs from rawSize
+///
+/// Variables are numbered in the order they are declared and all start at
+/// zero. A decoded block starts with an integer time. It is followed by value
+/// changes, each an integer time delta from the previous change (or from
+/// the start time of the block), a variable number and a value. Times are in
+/// units of 100ps.
+class CompressedWaveformWriter : public WaveformWriter {
+  enum {
+    NUM_BLOCKS = 8,
+    BLOCK_SIZE = 1 << 20
+  };
+  struct Scope {
+    std::string name;
+    std::vector<std::pair<std::string, unsigned>> variables;
+  };
+  std::ofstream out;
+  std::vector<Scope> scopes;
+  bool scopeOpen;
+  /// The block being encoded by the simulation.
+  std::vector<uint8_t> block;
+  /// Time of the last change in the current block.
+  uint64_t blockTime;
+  /// Blocks waiting to be written. The writer owns blocks[head % NUM_BLOCKS]
+  /// up to blocks[tail % NUM_BLOCKS].
+  std::vector<uint8_t> blocks[NUM_BLOCKS];
+  std::atomic<unsigned> head;
+  std::atomic<unsigned> tail;
+  std::atomic<bool> done;
+  /// Compression buffer used by the writer thread.
+  std::vector<uint8_t> compressed;
+  std::thread writer;
+
+  static void appendInteger(std::vector<uint8_t> &buf, uint64_t value);
+  static void appendString(std::vector<uint8_t> &buf, const std::string &s);
+  void beginBlock(uint64_t time);
+  /// Hand the current block to the writer thread.
+  void flushBlock();
+  void writeBlock(const std::vector<uint8_t> &data);
+  void runWriter();
+public:
+  CompressedWaveformWriter(const std::string &name);
+  CompressedWaveformWriter(const CompressedWaveformWriter &) = delete;
+  ~CompressedWaveformWriter();
+  void beginScope(const std::string &name) override;
+  void endScope() override;
+  void declare(const std::string &name, unsigned width) override;
+  void endDeclarations() override;
+  void writeChange(uint64_t time, unsigned index, uint32_t value) override;
+};
+
+} // End axe namespace
+
+#endif // _CompressedWaveformWriter_h_
@@ -0,0 +1,205 @@
+// Copyright (c) 2012, Richard Osborne, All rights reserved
+// This software is freely distributable under a derivative of the
+// University of Illinois/NCSA Open Source License posted in
+// LICENSE.txt and at <http://github.xcore.com/>
+
+#include "ConsoleSink.h"
+#include <algorithm>
+#include <cerrno>
+#include <sstream>
+
+#ifndef _MSC_VER
+#include <unistd.h>
+#else
+#include <io.h>
+#endif
+
+using namespace axe;
+
+ConsoleSink::ConsoleSink() :
+  buffered(true),
+  timestamps(false),
+  writing(false),
+  done(false)
+{
+}
+
+ConsoleSink::~ConsoleSink()
+{
+  flush();
+  if (writer.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      done = true;
+    }
+    wakeWriter.notify_one();
+    writer.join();
+  }
+}
+
+unsigned ConsoleSink::addSource(int fd)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  Source source;
+  source.fd = fd;
+  source.atLineStart = true;
+  sources.push_back(source);
+  return sources.size() - 1;
+}
+
+void ConsoleSink::writeAll(int fd, const char *data, size_t size)
+{
+  while (size != 0) {
+#ifndef _MSC_VER
+    ssize_t result = ::write(fd, data, size);
+#else
+    int result = ::_write(fd, data, static_cast<unsigned>(size));
+#endif
+    if (result < 0) {
+      if (errno == EINTR)
+        continue;
+      return;
+    }
+    data += result;
+    size -= result;
+  }
+}
+
+void ConsoleSink::append(Source &source, const char *data, size_t size,
+                         ticks_t time)
+{
+  if (!timestamps) {
+    source.buffer.append(data, size);
+    return;
+  }
+  const char *end = data + size;
+  while (data != end) {
+    if (source.atLineStart) {
+      std::ostringstream prefix;
+      prefix << '@' << time << ' ';
+      source.buffer += prefix.str();
+      source.atLineStart = false;
+    }
+    const char *newline = std::find(data, end, '\n');
+    if (newline != end) {
+      ++newline;
+      source.atLineStart = true;
+    }
+    source.buffer.append(data, newline);
+    data = newline;
+  }
+}
+
+void ConsoleSink::queue(Source &source, size_t size)
+{
+  if (size == source.buffer.size()) {
+    pending.push_back(std::make_pair(source.fd, std::string()));
+    pending.back().second.swap(source.buffer);
+  } else {
+    pending.push_back(std::make_pair(source.fd,
+                                     source.buffer.substr(0, size)));
+    source.buffer.erase(0, size);
+    source.bufferTime = Clock::now();
+  }
+}
+
+void ConsoleSink::output(unsigned index, const char *data, size_t size,
+                        ticks_t time)
+{
+  if (!buffered) {
+    Source &source = sources[index];
+    append(source, data, size, time);
+    writeAll(source.fd, source.buffer.data(), source.buffer.size());
+    source.buffer.clear();
+    return;
+  }
+  std::unique_lock<std::mutex> lock(mutex);
+  Source &source = sources[index];
+  size_t oldSize = source.buffer.size();
+  append(source, data, size, time);
+  if (oldSize == 0)
+    source.bufferTime = Clock::now();
+  if (source.buffer.size() >= BUFFER_SIZE) {
+    queue(source, source.buffer.size());
+  } else {
+    // Flush up to the end of the last complete line.
+    for (size_t i = source.buffer.size(); i > oldSize; --i) {
+      if (source.buffer[i - 1] == '\n') {
+        queue(source, i);
+        break;
+      }
+    }
+  }
+  if (!writer.joinable())
+    writer = std::thread(&ConsoleSink::runWriter, this);
+  // The writer must also be woken when a partial line starts to wait so it
+  // flushes it after FLUSH_INTERVAL_MS.
+  if (!pending.empty() || (oldSize == 0 && !source.buffer.empty())) {
+    lock.unlock();
+    wakeWriter.notify_one();
+  }
+}
+
+void ConsoleSink::flush()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  for (Source &source : sources) {
+    if (!source.buffer.empty())
+      queue(source, source.buffer.size());
+  }
+  if (!writer.joinable()) {
+    // Nothing is buffered unless the writer has been started.
+    return;
+  }
+  wakeWriter.notify_one();
+  written.wait(lock, [this] { return pending.empty() && !writing; });
+}
+
+void ConsoleSink::runWriter()
+{
+  const Clock::duration interval =
+    std::chrono::milliseconds(FLUSH_INTERVAL_MS);
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true) {
+    if (pending.empty() && !done) {
+      bool partial = false;
+      for (const Source &source : sources) {
+        if (!source.buffer.empty())
+          partial = true;
+      }
+      if (partial)
+        wakeWriter.wait_for(lock, interval);
+      else
+        wakeWriter.wait(lock);
+    }
+    Clock::time_point now = Clock::now();
+    for (Source &source : sources) {
+      if (!source.buffer.empty() && now - source.bufferTime >= interval)
+        queue(source, source.buffer.size());
+    }
+    if (pending.empty()) {
+      if (done)
+        return;
+      continue;
+    }
+    std::deque<std::pair<int, std::string>> output;
+    output.swap(pending);
+    writing = true;
+    lock.unlock();
+    // Combine consecutive output to the same file descriptor.
+    std::string batch;
+    int batchFD = output.front().first;
+    for (const auto &entry : output) {
+      if (entry.first != batchFD) {
+        writeAll(batchFD, batch.data(), batch.size());
+        batch.clear();
+        batchFD = entry.first;
+      }
+      batch += entry.second;
+    }
+    writeAll(batchFD, batch.data(), batch.size());
+    lock.lock();
+    writing = false;
+    written.notify_all();
+  }
+}
@@ -0,0 +1,74 @@
+// Copyright (c) 2012, Richard Osborne, All rights reserved
+// This software is freely distributable under a derivative of the
+// University of Illinois/NCSA Open Source License posted in
+// LICENSE.txt and at <http://github.xcore.com/>
+
+#ifndef _ConsoleSink_h_
+#define _ConsoleSink_h_
+
+#include "Config.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace axe {
+
+/// Collects console output from the simulated system, such as the output of
+/// each UART and writes to the standard output and error of the host.
+/// Output is buffered separately for each source. A source is flushed when a
+/// line is complete, when its buffer fills or when its output has been
+/// waiting for FLUSH_INTERVAL_MS. Flushed output is written by a background
+/// thread so the simulation never waits for the terminal.
+class ConsoleSink {
+  enum {
+    BUFFER_SIZE = 4096,
+    FLUSH_INTERVAL_MS = 20
+  };
+  typedef std::chrono::steady_clock Clock;
+  struct Source {
+    int fd;
+    std::string buffer;
+    bool atLineStart;
+    /// The time the oldest output in the buffer was written.
+    Clock::time_point bufferTime;
+  };
+  bool buffered;
+  bool timestamps;
+  std::vector<Source> sources;
+  std::mutex mutex;
+  std::condition_variable wakeWriter;
+  std::condition_variable written;
+  /// Output waiting to be written by the writer thread.
+  std::deque<std::pair<int, std::string>> pending;
+  bool writing;
+  bool done;
+  std::thread writer;
+
+  void append(Source &source, const char *data, size_t size, ticks_t time);
+  /// Move the first size bytes of the source's buffer to the pending output.
+  void queue(Source &source, size_t size);
+  void runWriter();
+  static void writeAll(int fd, const char *data, size_t size);
+public:
+  ConsoleSink();
+  ConsoleSink(const ConsoleSink &) = delete;
+  ~ConsoleSink();
+  /// If buffering is disabled output is written immediately.
+  void setBuffered(bool value) { buffered = value; }
+  /// Prefix each line with the simulated time at which it was started.
+  void setTimestamps(bool value) { timestamps = value; }
+  /// Add a source writing to the specified host file descriptor. Returns the
+  /// number used to refer to the source.
+  unsigned addSource(int fd);
+  void output(unsigned source, const char *data, size_t size, ticks_t time);
+  /// Write all buffered output and wait until it has been written.
+  void flush();
+};
+
+} // End axe namespace
+
+#endif // _ConsoleSink_h_
@@ -13,7 +13,11 @@
 #include "Lock.h"
 #include "Chanend.h"
 #include "ClockBlock.h"
+#include "InstructionOpcode.h"
+#include "InstructionProperties.h"
 #include "Tracer.h"
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <iomanip>
 #include <sstream>
@@ -47,6 +51,7 @@ Core::Core(uint32_t RamSize, uint32_t RamBase, bool tracing) :
   memoryOffset = memory - RamBase;
   invalidationInfoOffset =
     ramDecodeCache.getState().getInvalidationInfo() - (RamBase / 2);
+  writtenGranulesOffset = 0;
 
   resource[RES_TYPE_PORT] = 0;
   resourceNum[RES_TYPE_PORT] = 0;
@@ -150,6 +155,10 @@ void Core::setRamBaseMultiple(unsigned multiple)
   memoryOffset = memory - ramBase;
   invalidationInfoOffset =
     ramDecodeCache.getState().getInvalidationInfo() - (ramBase / 2);
+  if (writtenGranulesOffset) {
+    writtenGranulesOffset =
+      writtenGranules.data() - (ramBase >> WRITE_GRANULE_LOG2);
+  }
 
   // Inform threads of the change.
   for (unsigned i = 0; i < NUM_THREADS; i++) {
@@ -222,42 +231,34 @@ bool Core::writeMemory(uint32_t address, const void *src, size_t size)
     return false;
   std::memcpy(&memOffset()[address], src, size);
   invalidateRange(address, address + size);
+  markWritten(address, address + size);
   return true;
 }
 
-const Port *Core::getPortByID(ResourceID ID) const
+void Core::setTrackWrites(bool enable)
 {
-  assert(ID.type() == RES_TYPE_PORT);
-  unsigned width = ID.width();
-  if (width > 32)
-    return 0;
-  unsigned num = ID.num();
-  if (num >= portNum[width])
-    return 0;
-  return &port[width][num];
+  if (!enable) {
+    writtenGranulesOffset = 0;
+    std::vector<uint8_t>().swap(writtenGranules);
+    return;
+  }
+  writtenGranules.assign(getRamSize() >> WRITE_GRANULE_LOG2, 0);
+  writtenGranulesOffset =
+    writtenGranules.data() - (getRamBase() >> WRITE_GRANULE_LOG2);
 }
 
-const Resource *Core::getResourceByID(ResourceID ID) const
+void Core::clearWrittenGranules()
 {
-  ResourceType type = ID.type();
-  if (type > LAST_STD_RES_TYPE) {
-    return 0;
-  }
-  if (type == RES_TYPE_PORT) {
-    return getPortByID(ID);
-  }
-  unsigned num = ID.num();
-  if (num >= resourceNum[type]) {
-    return 0;
-  }
-  return resource[type][num];
+  std::fill(writtenGranules.begin(), writtenGranules.end(), 0);
 }
 
-Resource *Core::getResourceByID(ResourceID ID)
+void Core::markWritten(uint32_t begin, uint32_t end)
 {
-  return const_cast<Resource *>(
-    static_cast<const Core *>(this)->getResourceByID(ID)
-  );
+  if (!writtenGranulesOffset || begin == end)
+    return;
+  uint32_t first = begin >> WRITE_GRANULE_LOG2;
+  uint32_t last = (end - 1) >> WRITE_GRANULE_LOG2;
+  std::fill(&writtenGranulesOffset[first], &writtenGranulesOffset[last + 1], 1);
 }
 
 const DecodeCache::State *Core::
@@ -274,8 +275,10 @@ bool Core::setBreakpoint(uint32_t value)
 {
   if ((value & 1) || !isValidAddress(value))
     return false;
-  if (breakpoints.insert(value).second)
+  if (breakpoints.insert(value).second) {
+    breakpointConditions[value] = BreakpointCondition();
     invalidateShort(value);
+  }
   return true;
 }
 
@@ -283,6 +286,23 @@ void Core::unsetBreakpoint(uint32_t value)
 {
   if (breakpoints.erase(value))
     invalidateShort(value);
+  breakpointConditions.erase(value);
+}
+
+BreakpointCondition *Core::getBreakpointCondition(uint32_t address)
+{
+  auto it = breakpointConditions.find(address);
+  if (it == breakpointConditions.end())
+    return 0;
+  return &it->second;
+}
+
+bool Core::shouldStopAtBreakpoint(Thread &t, uint32_t address)
+{
+  auto it = breakpointConditions.find(address);
+  if (it == breakpointConditions.end())
+    return true;
+  return it->second.hit(t);
 }
 
 bool Core::setWatchpoint(WatchpointType type, uint32_t lowAddress, uint32_t highAddress)
@@ -290,10 +310,8 @@ bool Core::setWatchpoint(WatchpointType type, uint32_t lowAddress, uint32_t high
   if (((lowAddress & 1) || !isValidAddress(lowAddress)) 
     || ((highAddress & 1) || !isValidAddress(highAddress)))
     return false;
-  if(jitEnabled) {
-    // We need to turn tracing on (switch to "slow" mode, and disable JIT)
-    disableJIT();
-  }
+  // Compiled code stays valid. JIT memory checks bail out to the
+  // interpreter for accesses to pages with watchpoints.
   watchpoints.setWatchpoint(type, lowAddress, highAddress);
   return true;
 }
@@ -301,36 +319,22 @@ bool Core::setWatchpoint(WatchpointType type, uint32_t lowAddress, uint32_t high
 void Core::unsetWatchpoint(WatchpointType type, uint32_t lowAddress, uint32_t highAddress)
 {
   watchpoints.unsetWatchpoint(type, lowAddress, highAddress);
-  if (watchpoints.empty() && !getTracer()) {
-    enableJIT();
-  }
 }
 
-void Core::disableJIT()
+range<Chanend *> Core::getChanends()
 {
-  jitEnabled = false;
-  ramDecodeCache.setTracing(true);
-  resetCaches();
+  return make_range(chanend, chanend + NUM_CHANENDS);
 }
 
-void Core::enableJIT()
+void Core::checkMemoryPredicates(Thread &t)
 {
-  jitEnabled = true;
-  ramDecodeCache.setTracing(false);
-  resetCaches();
-}
-
-bool Core::hitWatchpoint(WatchpointType t, uint32_t address, uint8_t ldst_size)
-{
-  return watchpoints.isWatchpointAddress(t, address, ldst_size);
+  getParent()->getParent()->getRunPredicates().checkMemory(*this, t);
 }
 
 void Core::resetCaches()
 {
   uint32_t ramEnd = getRamBase() + (1 << ramSizeLog2);
-  for (unsigned address = getRamBase(); address < ramEnd; address += 4) {
-    invalidateWord(address);    
-  }
+  invalidateRange(getRamBase(), ramEnd);
 }
 
 bool Core::getLocalChanendDest(ResourceID ID, ChanEndpoint *&result)
@@ -361,7 +365,7 @@ bool Core::getLocalChanendDest(ResourceID ID, ChanEndpoint *&result)
   return false;
 }
 
-ChanEndpoint *Core::getChanendDest(ResourceID ID)
+ChanEndpoint *Core::getChanendDest(ResourceID ID, ChanEndpoint *source)
 {
   if (!ID.isChanendOrConfig())
     return 0;
@@ -370,6 +374,9 @@ ChanEndpoint *Core::getChanendDest(ResourceID ID)
   if (getLocalChanendDest(ID, result)) {
     return result;
   }
+  XLinkModel &xlinkModel = parent->getParent()->getXLinkModel();
+  if (xlinkModel.isEnabled())
+    return xlinkModel.getChanendDest(*parent, source, ID);
   return parent->getOutgoingChanendDest(ID);
 }
 
@@ -469,7 +476,56 @@ void Core::invalidateSlowPath(uint32_t shiftedAddress)
   } while (info == DecodeCache::INVALIDATE_CURRENT_AND_PREVIOUS);
 }
 
+/// Invalidate every decoded instruction in the code page starting at the
+/// specified pc.
+bool Core::invalidatePage(uint32_t pagePc)
+{
+  DecodeCache::State &cache = ramDecodeCache.getState();
+  unsigned char *info = cache.getInvalidationInfo();
+  uint32_t endPc = std::min(pagePc + DecodeCache::CODE_PAGE_SIZE, cache.size);
+  bool invalidated = false;
+  // An instruction or JIT fragment starting in the previous page.
+  if (info[pagePc] == DecodeCache::INVALIDATE_CURRENT_AND_PREVIOUS) {
+    invalidateSlowPath(pagePc + getRamBase() / 2);
+    invalidated = true;
+  }
+  JIT &jit = getParent()->getParent()->getJIT();
+  invalidated |= jit.invalidateRange(*this, pagePc, endPc);
+  for (uint32_t pc = pagePc; pc != endPc; ++pc) {
+    if (info[pc] == DecodeCache::INVALIDATE_NONE)
+      continue;
+    clearOpcode(pc);
+    cache.executionFrequency[pc] = 0;
+    info[pc] = DecodeCache::INVALIDATE_NONE;
+    invalidated = true;
+  }
+  cache.clearPageMayContainCode(pagePc);
+  return invalidated;
+}
+
 bool Core::invalidateRange(uint32_t begin, uint32_t end)
+{
+  const DecodeCache::State &cache = ramDecodeCache.getState();
+  bool invalidated = false;
+  uint32_t address = begin;
+  while (address < end) {
+    uint32_t pc = cache.toPc(address);
+    uint32_t pagePc = pc & ~(DecodeCache::CODE_PAGE_SIZE - 1);
+    uint32_t pageEnd = cache.fromPc(pagePc + DecodeCache::CODE_PAGE_SIZE);
+    uint32_t chunkEnd = std::min(end, pageEnd);
+    if (!cache.pageMayContainCode(pc)) {
+      // Nothing to invalidate.
+    } else if (address == cache.fromPc(pagePc) && chunkEnd == pageEnd) {
+      invalidated |= invalidatePage(pagePc);
+    } else {
+      invalidated |= invalidateRangeSlowPath(address, chunkEnd);
+    }
+    address = chunkEnd;
+  }
+  return invalidated;
+}
+
+bool Core::invalidateRangeSlowPath(uint32_t begin, uint32_t end)
 {
   uint32_t address = begin;
   bool invalidated = false;
@@ -485,13 +541,75 @@ bool Core::invalidateRange(uint32_t begin, uint32_t end)
   return invalidated;
 }
 
-void Core::runJIT(uint32_t jitPc)
+void Core::runJIT(DecodeCache::State &cache, uint32_t jitPc)
 {
-  if (!isValidRamPc(jitPc))
+  if (!jitEnabled || !cache.isValidPc(jitPc))
     return;
-  ramDecodeCache.getState().executionFrequency[jitPc] =
-    DecodeCache::MIN_EXECUTION_FREQUENCY;
-  getParent()->getParent()->getJIT().compileBlock(*this, jitPc);
+  cache.executionFrequency[jitPc] = DecodeCache::MIN_EXECUTION_FREQUENCY;
+  getParent()->getParent()->getJIT().compileBlock(*this, cache, jitPc);
+}
+
+static bool getBackwardBranchTarget(InstructionOpcode opc, const Operands &ops,
+                                    uint32_t &target)
+{
+  switch (opc) {
+  default:
+    return false;
+  case BRBU_u6:
+  case BRBU_lu6:
+    target = ops.ops[0];
+    return true;
+  case BRBT_ru6:
+  case BRBT_lru6:
+  case BRBF_ru6:
+  case BRBF_lru6:
+    target = ops.ops[1];
+    return true;
+  }
+}
+
+void Core::predecode(uint32_t begin, uint32_t end)
+{
+  // Execution frequency given to the target of a backward branch. This is
+  // half the threshold at which a thread will try to JIT compile the code.
+  const DecodeCache::executionFrequency_t loopHeadHint = 64;
+  DecodeCache::State &state = ramDecodeCache.getState();
+  bool tracing = state.tracingEnabled;
+  OPCODE_TYPE decode = getInstruction_DECODE(tracing);
+  begin = std::max(begin, getRamBase()) & ~1;
+  end = std::min(end, getRamBase() + getRamSize());
+  uint32_t address = begin;
+  while (address < end) {
+    uint32_t pc = toRamPc(address);
+    if (state.opcode[pc] != decode) {
+      address += 2;
+      continue;
+    }
+    InstructionOpcode opc;
+    Operands ops;
+    instructionDecode(*this, address, opc, ops);
+    InstructionOpcode dualIssueOpc = opc;
+    Operands dualIssueOps = ops;
+    instructionTransform(opc, ops, *this, address, false);
+    instructionTransform(dualIssueOpc, dualIssueOps, *this, address, true);
+    unsigned size = instructionProperties[opc].size;
+    // The issue mode of the thread that runs the code isn't known yet. Leave
+    // instructions whose operands depend on it (e.g. branches and LDAP) to be
+    // decoded by the thread when they are first executed.
+    if (opc == dualIssueOpc &&
+        std::memcmp(&ops, &dualIssueOps, sizeof(ops)) == 0) {
+      state.setOpcode(pc, getInstructionFunction(opc, ops, tracing), ops,
+                      size);
+    }
+    // The JIT only compiles single issue code so hint the single issue target.
+    uint32_t target;
+    if (getBackwardBranchTarget(opc, ops, target) &&
+        state.executionFrequency[target] >= 0 &&
+        state.executionFrequency[target] < loopHeadHint) {
+      state.executionFrequency[target] = loopHeadHint;
+    }
+    address += std::max(size, 2U);
+  }
 }
 
 void Core::clearOpcode(uint32_t pc)
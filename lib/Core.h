@@ -22,6 +22,9 @@
 #include "Endianness.h"
 #include "WatchpointException.h"
 #include "WatchpointManager.h"
+#include "BreakpointCondition.h"
+#include <map>
+#include <vector>
 
 namespace axe {
 
@@ -54,6 +57,10 @@ public:
 private:
   uint8_t * memoryOffset;
   unsigned char *invalidationInfoOffset;
+  /// If write tracking is enabled, points to the written flags of each
+  /// granule of RAM offset by the RAM base, otherwise null.
+  uint8_t *writtenGranulesOffset;
+  std::vector<uint8_t> writtenGranules;
   DecodeCache ramDecodeCache;
   const uint32_t ramSizeLog2;
   uint32_t ramBaseMultiple;
@@ -82,11 +89,18 @@ private:
   bool hasMatchingNodeID(ResourceID ID);
   void invalidateWordSlowPath(uint32_t address);
   void invalidateSlowPath(uint32_t shiftedAddress);
+  bool invalidatePage(uint32_t pagePc);
+  bool invalidateRangeSlowPath(uint32_t begin, uint32_t end);
   void resetCaches();
   uint32_t getRamSizeShorts() const { return 1 << (ramSizeLog2 - 1); }
 
   std::set<uint32_t> breakpoints;
+  /// Condition and hit count of each breakpoint.
+  std::map<uint32_t, BreakpointCondition> breakpointConditions;
   WatchpointManager watchpoints;
+  /// Words watched by memory predicates. Stores to these words are
+  /// interpreted so the predicates can be checked after the store.
+  WatchpointManager memoryPredicateWatches;
 public:
   uint32_t vector_base;
 
@@ -108,22 +122,61 @@ public:
 
   bool setBreakpoint(uint32_t value);
   void unsetBreakpoint(uint32_t value);
-  void clearBreakpoints() { breakpoints.clear(); }
+  void clearBreakpoints() {
+    breakpoints.clear();
+    breakpointConditions.clear();
+  }
   bool isBreakpointAddress(uint32_t value) const {
     return breakpoints.count(value);
   }
+  /// Returns the condition of the breakpoint at the specified address or
+  /// null if there is no breakpoint at the address.
+  BreakpointCondition *getBreakpointCondition(uint32_t address);
+  /// Called when a thread hits the breakpoint at the specified address.
+  /// Returns whether the simulation should stop.
+  bool shouldStopAtBreakpoint(Thread &t, uint32_t address);
 
   bool setWatchpoint(WatchpointType type, uint32_t lowAddress, uint32_t highAddress);
   void unsetWatchpoint(WatchpointType type, uint32_t lowAddress, uint32_t highAddress);
   void clearWatchpoints() { watchpoints.clearWatchpoints(); };
-  bool hitWatchpoint(WatchpointType t, uint32_t address, uint8_t ldst_size);
+  bool hitWatchpoint(WatchpointType t, uint32_t address, uint8_t ldst_size) const {
+    return watchpoints.isWatchpointAddress(t, address, ldst_size);
+  }
+  /// Returns whether an access to the page containing the address may hit a
+  /// watchpoint. Used by the JIT to guard compiled memory accesses.
+  bool mayHitWatchpoint(uint32_t address) const {
+    return watchpoints.mayBeWatchpointPage(address) ||
+           memoryPredicateWatches.mayBeWatchpointPage(address);
+  }
+  bool mayHitWatchpoint(uint32_t begin, uint32_t end) const {
+    return watchpoints.mayBeWatchpointRange(begin, end) ||
+           memoryPredicateWatches.mayBeWatchpointRange(begin, end);
+  }
+
+  void watchMemoryPredicate(uint32_t address) {
+    memoryPredicateWatches.setWatchpoint(WatchpointType::WRITE, address,
+                                         address + 3);
+  }
+  void clearMemoryPredicateWatches() {
+    memoryPredicateWatches.clearWatchpoints();
+  }
+  bool hitMemoryPredicate(uint32_t address, uint8_t ldst_size) const {
+    return memoryPredicateWatches.isWatchpointAddress(WatchpointType::WRITE,
+                                                      address, ldst_size);
+  }
+  /// Called by the interpreter after a store that hit a memory predicate.
+  void checkMemoryPredicates(Thread &t);
 
   bool jitEnabled;
-  void disableJIT();
-  void enableJIT();
 
-  // TODO should take address in order to handle ROM.
-  void runJIT(uint32_t jitPc);
+  /// Compile the code starting at the specified pc of a decode cache. The
+  /// decode cache may be the RAM of the core or the shared ROM.
+  void runJIT(DecodeCache::State &cache, uint32_t jitPc);
+
+  /// Decode the instructions in the RAM address range [begin, end) ahead of
+  /// their first execution. Backward branch targets are given a head start
+  /// on their execution frequency so hot loops reach the JIT sooner.
+  void predecode(uint32_t begin, uint32_t end);
 
   uint32_t getRamSize() const { return 1 << ramSizeLog2; }
   uint32_t getRamSizeLog2() const { return ramSizeLog2; }
@@ -261,6 +314,16 @@ public:
 
   bool invalidateRange(uint32_t begin, uint32_t end);
 
+  /// Returns whether a store to the range [begin, end) would invalidate any
+  /// decoded instructions.
+  bool invalidateRangeCheck(uint32_t begin, uint32_t end) const {
+    for (uint32_t i = begin >> 1, last = (end - 1) >> 1; i <= last; ++i) {
+      if (invalidationInfoOffset[i] != DecodeCache::INVALIDATE_NONE)
+        return true;
+    }
+    return false;
+  }
+
   uint8_t *ramBytePtr(uint32_t address) {
     return &memOffset()[address];
   }
@@ -274,19 +337,45 @@ public:
                                         romBytePtr(address);
   }
 
+  enum {
+    /// Log2 of the size in bytes of the granules tracked by setTrackWrites().
+    WRITE_GRANULE_LOG2 = 6
+  };
+
+  /// Enable or disable recording which granules of RAM are written.
+  void setTrackWrites(bool enable);
+  void clearWrittenGranules();
+  /// Returns the written flag of each granule of RAM, starting at the RAM
+  /// base. Empty if writes aren't tracked.
+  const std::vector<uint8_t> &getWrittenGranules() const {
+    return writtenGranules;
+  }
+
+  void markWritten(uint32_t address) {
+    if (writtenGranulesOffset)
+      writtenGranulesOffset[address >> WRITE_GRANULE_LOG2] = 1;
+  }
+
+  /// Record a write to [begin, end) made without going through the store
+  /// functions below.
+  void markWritten(uint32_t begin, uint32_t end);
+
   void storeWord(uint32_t value, uint32_t address)
   {
     endianness::write32le(memOffset() + address, value);
+    markWritten(address);
   }
 
   void storeShort(int16_t value, uint32_t address)
   {
     endianness::write16le(memOffset() + address, value);
+    markWritten(address);
   }
 
   void storeByte(uint8_t value, uint32_t address)
   {
     memOffset()[address] = value;
+    markWritten(address);
   }
   
   bool readMemory(uint32_t address, void *dst, size_t size);
@@ -299,15 +388,48 @@ public:
     return static_cast<Thread*>(allocResource(current, RES_TYPE_THREAD));
   }
 
-  const Port *getPortByID(ResourceID ID) const;
+  const Port *getPortByID(ResourceID ID) const
+  {
+    assert(ID.type() == RES_TYPE_PORT);
+    unsigned width = ID.width();
+    if (width > 32)
+      return 0;
+    unsigned num = ID.num();
+    if (num >= portNum[width])
+      return 0;
+    return &port[width][num];
+  }
 
   /// Returns the resource associated with the resource ID or NULL if the
-  /// the resource ID is invalid.
-  Resource *getResourceByID(ResourceID ID);
-  const Resource *getResourceByID(ResourceID ID) const;
+  /// the resource ID is invalid. Defined inline so resource instructions
+  /// compiled by the JIT can look up resources without a call.
+  const Resource *getResourceByID(ResourceID ID) const
+  {
+    ResourceType type = ID.type();
+    if (type > LAST_STD_RES_TYPE) {
+      return 0;
+    }
+    if (type == RES_TYPE_PORT) {
+      return getPortByID(ID);
+    }
+    unsigned num = ID.num();
+    if (num >= resourceNum[type]) {
+      return 0;
+    }
+    return resource[type][num];
+  }
+
+  Resource *getResourceByID(ResourceID ID)
+  {
+    return const_cast<Resource *>(
+      static_cast<const Core *>(this)->getResourceByID(ID)
+    );
+  }
 
   bool getLocalChanendDest(ResourceID ID, ChanEndpoint *&result);
-  ChanEndpoint *getChanendDest(ResourceID ID);
+  /// Returns the endpoint that the source on this core should send to in
+  /// order to reach the channel end with the specified ID.
+  ChanEndpoint *getChanendDest(ResourceID ID, ChanEndpoint *source);
 
   unsigned getRunJitAddr() const {
     return (getRamSizeShorts() - 1) + RUN_JIT_ADDR_OFFSET;
@@ -348,6 +470,7 @@ public:
   range<Thread *> getThreads() {
     return make_range(thread, thread + NUM_THREADS);
   }
+  range<Chanend *> getChanends();
   void setCodeReference(const std::string &value) { codeReference = value; }
   const std::string &getCodeReference() const { return codeReference; }
   std::string getCoreName() const;
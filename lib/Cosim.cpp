@@ -0,0 +1,342 @@
+// Copyright (c) 2012, Richard Osborne, All rights reserved
+// This software is freely distributable under a derivative of the
+// University of Illinois/NCSA Open Source License posted in
+// LICENSE.txt and at <http://github.xcore.com/>
+
+#include "Cosim.h"
+#include "axe-c/cosim.h"
+#include "Peripheral.h"
+#include "PeripheralDescriptor.h"
+#include "PortConnectionManager.h"
+#include "PortInterface.h"
+#include "Property.h"
+#include "Runnable.h"
+#include "RunnableQueue.h"
+#include "Signal.h"
+#include "SystemState.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <queue>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <cstdlib>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace axe;
+
+template <typename T> static T loadAcquire(const T &x)
+{
+  return __atomic_load_n(&x, __ATOMIC_ACQUIRE);
+}
+
+template <typename T> static void storeRelease(T &x, T value)
+{
+  __atomic_store_n(&x, value, __ATOMIC_RELEASE);
+}
+
+/// Exchanges pin changes with another process through the shared memory
+/// layout described in axe-c/cosim.h. Changes from the peer are queued and
+/// driven at their time. The peripheral is scheduled at the time up to which
+/// the peer has sent its changes and waits there for the peer to catch up.
+class Cosim : public Runnable, public Peripheral {
+  /// Time the peer has to exit once the simulation finishes before it is
+  /// killed.
+  enum { PEER_EXIT_TIMEOUT_MS = 1000 };
+  class PortProxy : public PortInterface {
+    Cosim &parent;
+    unsigned index;
+  public:
+    PortProxy(Cosim &p, unsigned i) : parent(p), index(i) {}
+    void seePinsChange(const Signal &value, ticks_t time) override {
+      parent.seePinsChange(index, value, time);
+    }
+  };
+  struct Change {
+    ticks_t time;
+    unsigned port;
+    Signal value;
+    Change(ticks_t t, unsigned p, const Signal &v) :
+      time(t), port(p), value(v) {}
+    bool operator<(const Change &other) const {
+      return time > other.time;
+    }
+  };
+  RunnableQueue &scheduler;
+  std::string name;
+  AXECosimShared *shared;
+  pid_t peerPid;
+  bool unlinked;
+  /// Maximum time to wait for the peer to attach.
+  std::chrono::seconds attachTimeout;
+  std::chrono::steady_clock::time_point startTime;
+  std::vector<PortInterface*> ports;
+  std::vector<std::unique_ptr<PortProxy>> proxies;
+  /// Changes from the peer waiting to be driven.
+  std::priority_queue<Change> pending;
+  /// The peer has sent all changes before this time.
+  ticks_t peerTime;
+
+  void seePinsChange(unsigned port, const Signal &value, ticks_t time);
+  void receiveChanges();
+  void driveChanges(ticks_t time);
+  bool peerExited();
+  void checkPeerAttached();
+  void waitForPeer(ticks_t time);
+  void stopPeer();
+public:
+  Cosim(RunnableQueue &s, const std::string &n, unsigned timeout);
+  ~Cosim();
+  void open();
+  void startPeer(const std::string &command);
+  void connect(unsigned index, PortConnectionWrapper port);
+  void start();
+  void run(ticks_t time) override;
+};
+
+Cosim::Cosim(RunnableQueue &s, const std::string &n, unsigned timeout) :
+  scheduler(s),
+  name(n),
+  shared(0),
+  peerPid(0),
+  unlinked(false),
+  attachTimeout(timeout),
+  peerTime(0)
+{
+}
+
+Cosim::~Cosim()
+{
+  if (!shared)
+    return;
+  storeRelease<uint64_t>(shared->axeTime, UINT64_MAX);
+  stopPeer();
+  if (!unlinked)
+    shm_unlink(name.c_str());
+  munmap(shared, sizeof(*shared));
+}
+
+void Cosim::stopPeer()
+{
+  if (peerPid <= 0)
+    return;
+  // The peer should exit once it sees the final time. Give it a moment
+  // before killing it so it isn't left running.
+  auto deadline = std::chrono::steady_clock::now() +
+                  std::chrono::milliseconds(PEER_EXIT_TIMEOUT_MS);
+  int status;
+  while (waitpid(peerPid, &status, WNOHANG) == 0) {
+    if (std::chrono::steady_clock::now() >= deadline) {
+      kill(peerPid, SIGKILL);
+      waitpid(peerPid, &status, 0);
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  peerPid = 0;
+}
+
+void Cosim::open()
+{
+  int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+  if (fd < 0 || ftruncate(fd, sizeof(AXECosimShared)) != 0) {
+    std::cerr << "Error: failed to create shared memory \"" << name << "\"\n";
+    std::exit(1);
+  }
+  void *p = mmap(0, sizeof(AXECosimShared), PROT_READ | PROT_WRITE,
+                 MAP_SHARED, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED) {
+    std::cerr << "Error: failed to map shared memory \"" << name << "\"\n";
+    std::exit(1);
+  }
+  shared = static_cast<AXECosimShared*>(p);
+  shared->version = AXE_COSIM_VERSION;
+  shared->axePid = getpid();
+}
+
+void Cosim::startPeer(const std::string &command)
+{
+  std::string commandLine = command + " " + name;
+  peerPid = fork();
+  if (peerPid < 0) {
+    std::cerr << "Error: failed to start \"" << command << "\"\n";
+    std::exit(1);
+  }
+  if (peerPid == 0) {
+    execl("/bin/sh", "sh", "-c", commandLine.c_str(), (char*)0);
+    _exit(127);
+  }
+}
+
+void Cosim::connect(unsigned index, PortConnectionWrapper port)
+{
+  if (index >= ports.size()) {
+    ports.resize(index + 1);
+    proxies.resize(index + 1);
+  }
+  ports[index] = port.getInterface();
+  proxies[index].reset(new PortProxy(*this, index));
+  port.attach(proxies[index].get());
+}
+
+void Cosim::start()
+{
+  shared->numPorts = ports.size();
+  storeRelease(shared->magic, AXE_COSIM_MAGIC);
+  startTime = std::chrono::steady_clock::now();
+  scheduler.push(*this, 0);
+}
+
+void Cosim::seePinsChange(unsigned port, const Signal &value, ticks_t time)
+{
+  AXECosimRing &ring = shared->toPeer;
+  uint32_t tail = ring.tail;
+  // Wait for the peer if the ring is full.
+  while (tail - loadAcquire(ring.head) == AXE_COSIM_RING_SIZE) {
+    if (peerExited())
+      return;
+    checkPeerAttached();
+    std::this_thread::yield();
+  }
+  AXECosimChange &change = ring.changes[tail % AXE_COSIM_RING_SIZE];
+  change.time = time;
+  change.port = port;
+  change.halfPeriod = value.halfPeriod;
+  change.value = value.value;
+  storeRelease(ring.tail, tail + 1);
+}
+
+void Cosim::receiveChanges()
+{
+  // Read the time first so all changes before it are in the ring.
+  ticks_t time = loadAcquire(shared->peerTime);
+  AXECosimRing &ring = shared->fromPeer;
+  uint32_t head = ring.head;
+  uint32_t tail = loadAcquire(ring.tail);
+  for (; head != tail; ++head) {
+    const AXECosimChange &change = ring.changes[head % AXE_COSIM_RING_SIZE];
+    if (change.port >= ports.size() || !ports[change.port])
+      continue;
+    Signal value;
+    value.halfPeriod = change.halfPeriod;
+    value.value = change.value;
+    pending.push(Change(change.time, change.port, value));
+  }
+  storeRelease(ring.head, head);
+  peerTime = std::max(peerTime, time);
+  if (!unlinked && loadAcquire(shared->peerAttached)) {
+    // The name is no longer needed once the peer has opened it.
+    shm_unlink(name.c_str());
+    unlinked = true;
+  }
+}
+
+void Cosim::driveChanges(ticks_t time)
+{
+  while (!pending.empty() && pending.top().time <= time) {
+    const Change &change = pending.top();
+    ports[change.port]->seePinsChange(change.value, time);
+    pending.pop();
+  }
+}
+
+bool Cosim::peerExited()
+{
+  if (peerPid <= 0)
+    return false;
+  int status;
+  if (waitpid(peerPid, &status, WNOHANG) != peerPid)
+    return false;
+  peerPid = 0;
+  // The peer won't make any more changes.
+  receiveChanges();
+  peerTime = UINT64_MAX;
+  return true;
+}
+
+void Cosim::checkPeerAttached()
+{
+  if (unlinked || loadAcquire(shared->peerAttached))
+    return;
+  if (std::chrono::steady_clock::now() - startTime < attachTimeout)
+    return;
+  std::cerr << "Error: no peer attached to shared memory \"" << name
+            << "\" within " << attachTimeout.count() << " seconds\n";
+  std::exit(1);
+}
+
+void Cosim::waitForPeer(ticks_t time)
+{
+  storeRelease<uint64_t>(shared->axeTime, time);
+  while (true) {
+    receiveChanges();
+    if (peerTime > time)
+      return;
+    if (peerExited())
+      return;
+    checkPeerAttached();
+    std::this_thread::yield();
+  }
+}
+
+void Cosim::run(ticks_t time)
+{
+  if (peerTime <= time)
+    waitForPeer(time);
+  else
+    receiveChanges();
+  driveChanges(time);
+  ticks_t next = peerTime;
+  if (!pending.empty())
+    next = std::min(next, pending.top().time);
+  if (next != UINT64_MAX)
+    scheduler.push(*this, next);
+}
+
+static Peripheral *
+createCosim(SystemState &system, PortConnectionManager &connectionManager,
+            const Properties &properties)
+{
+  std::string name = properties.get("shm")->getAsString();
+  if (name.empty() || name[0] != '/')
+    name = "/" + name;
+  unsigned timeout = 10;
+  if (const Property *timeoutProperty = properties.get("timeout"))
+    timeout = timeoutProperty->getAsInteger();
+  Cosim *p = new Cosim(system.getScheduler(), name, timeout);
+  p->open();
+  for (unsigned i = 0; i < AXE_COSIM_MAX_PORTS; i++) {
+    std::ostringstream portName;
+    portName << "port" << i;
+    PortConnectionWrapper port = connectionManager.get(properties,
+                                                       portName.str());
+    if (!!port)
+      p->connect(i, port);
+  }
+  p->start();
+  if (const Property *command = properties.get("command"))
+    p->startPeer(command->getAsString());
+  return p;
+}
+
+std::unique_ptr<PeripheralDescriptor> axe::getPeripheralDescriptorCosim()
+{
+  std::unique_ptr<PeripheralDescriptor> p(
+    new PeripheralDescriptor("cosim", &createCosim));
+  p->addProperty(PropertyDescriptor::stringProperty("shm")).setRequired(true);
+  p->addProperty(PropertyDescriptor::stringProperty("command"));
+  p->addProperty(PropertyDescriptor::integerProperty("timeout"));
+  for (unsigned i = 0; i < AXE_COSIM_MAX_PORTS; i++) {
+    std::ostringstream portName;
+    portName << "port" << i;
+    p->addProperty(PropertyDescriptor::portProperty(portName.str()));
+  }
+  return p;
+}
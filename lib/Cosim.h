@@ -0,0 +1,19 @@
+// Copyright (c) 2012, Richard Osborne, All rights reserved
+// This software is freely distributable under a derivative of the
+// University of Illinois/NCSA Open Source License posted in
+// LICENSE.txt and at <http://github.xcore.com/>
+
+#ifndef _Cosim_h_
+#define _Cosim_h_
+
+#include <memory>
+
+namespace axe {
+
+class PeripheralDescriptor;
+
+std::unique_ptr<PeripheralDescriptor> getPeripheralDescriptorCosim();
+
+} // End axe namespace
+
+#endif // _Cosim_h_
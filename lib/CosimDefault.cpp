@@ -0,0 +1,38 @@
+// Copyright (c) 2012, Richard Osborne, All rights reserved
+// This software is freely distributable under a derivative of the
+// University of Illinois/NCSA Open Source License posted in
+// LICENSE.txt and at <http://github.xcore.com/>
+
+#include "Cosim.h"
+#include "axe-c/cosim.h"
+#include "PeripheralDescriptor.h"
+#include <iostream>
+#include <sstream>
+#include <cstdlib>
+
+using namespace axe;
+
+static Peripheral *
+createCosim(SystemState &system, PortConnectionManager &connectionManager,
+            const Properties &properties)
+{
+  std::cerr << "Error: cosim peripheral not supported on this platform\n";
+  std::exit(1);
+}
+
+std::unique_ptr<PeripheralDescriptor> axe::getPeripheralDescriptorCosim()
+{
+  // Accept the same properties as the real peripheral so the error above is
+  // reported instead of an unknown property.
+  std::unique_ptr<PeripheralDescriptor> p(
+    new PeripheralDescriptor("cosim", &createCosim));
+  p->addProperty(PropertyDescriptor::stringProperty("shm")).setRequired(true);
+  p->addProperty(PropertyDescriptor::stringProperty("command"));
+  p->addProperty(PropertyDescriptor::integerProperty("timeout"));
+  for (unsigned i = 0; i < AXE_COSIM_MAX_PORTS; i++) {
+    std::ostringstream portName;
+    portName << "port" << i;
+    p->addProperty(PropertyDescriptor::portProperty(portName.str()));
+  }
+  return p;
+}
@@ -7,6 +7,7 @@
 #include "Thread.h"
 #include "Tracer.h"
 #include <cstring>
+#include <algorithm>
 
 using namespace axe;
 
@@ -23,8 +24,12 @@ DecodeCache::DecodeCache(uint32_t sz, uint32_t b, bool writable, bool tracing)
     for (unsigned i = 0; i != sz; ++i) {
       state.invalidationInfo[i] = INVALIDATE_NONE;
     }
+    unsigned numPages = (sz + CODE_PAGE_SIZE - 1) >> CODE_PAGE_SIZE_LOG2;
+    state.codePages = new bool[numPages];
+    std::fill(state.codePages, state.codePages + numPages, false);
   } else {
     state.invalidationInfo = 0;
+    state.codePages = 0;
   }
   std::memset(state.executionFrequency, 0,
               sizeof(state.executionFrequency[0]) * sz);
@@ -37,6 +42,7 @@ DecodeCache::~DecodeCache()
   delete[] state.opcode;
   delete[] state.executionFrequency;
   delete[] state.invalidationInfo;
+  delete[] state.codePages;
 }
 
 void DecodeCache::State::clearOpcode(uint32_t pc)
@@ -55,6 +61,12 @@ setOpcode(uint32_t pc, OPCODE_TYPE opc, unsigned size)
     for (unsigned i = 1; i < size / 2; i++) {
       invalidationInfo[pc + i] = INVALIDATE_CURRENT_AND_PREVIOUS;
     }
+    // JIT compiled code covers the whole fragment and may span many pages.
+    uint32_t last = size ? pc + size / 2 - 1 : pc;
+    for (uint32_t page = pc >> CODE_PAGE_SIZE_LOG2,
+         lastPage = last >> CODE_PAGE_SIZE_LOG2; page <= lastPage; ++page) {
+      codePages[page] = true;
+    }
   }
 }
 
@@ -29,6 +29,11 @@ public:
     INVALIDATE_CURRENT,
     INVALIDATE_CURRENT_AND_PREVIOUS
   };
+  enum {
+    /// log2 of the number of half words in a code page.
+    CODE_PAGE_SIZE_LOG2 = 8,
+    CODE_PAGE_SIZE = 1 << CODE_PAGE_SIZE_LOG2
+  };
   struct State {
     // The opcode cache is bigger than the memory size. We place an ILLEGAL_PC
     // pseudo instruction just past the end of memory. This saves
@@ -39,6 +44,10 @@ public:
     Operands *operands;
     executionFrequency_t *executionFrequency;
     unsigned char *invalidationInfo;
+    /// For each page, whether any half word in the page may hold a decoded
+    /// instruction. Only allocated for writable caches. Stores to pages
+    /// without code can skip the per half word invalidation info.
+    bool *codePages;
     /// Size in half words.
     uint32_t size;
     /// Base in bytes
@@ -81,6 +90,14 @@ public:
     unsigned char *getInvalidationInfo() {
       return invalidationInfo;
     }
+
+    bool pageMayContainCode(uint32_t pc) const {
+      return codePages[pc >> CODE_PAGE_SIZE_LOG2];
+    }
+
+    void clearPageMayContainCode(uint32_t pc) {
+      codePages[pc >> CODE_PAGE_SIZE_LOG2] = false;
+    }
     
     void setOpcode(uint32_t pc, OPCODE_TYPE opc, unsigned size);
     void setOpcode(uint32_t pc, OPCODE_TYPE opc, Operands &ops, unsigned size);
@@ -16,7 +16,9 @@
 #include "NetworkLink.h"
 #include "CRC.h"
 #include "BitManip.h"
+#include <iostream>
 #include <memory>
+#include <cstdlib>
 #include <cstring>
 
 using namespace axe;
@@ -50,7 +52,7 @@ class EthernetPhyTx : public Runnable {
   uint8_t prevNibble;
 
   void reset();
-  bool transmitFrame();
+  bool transmitFrame(ticks_t time);
   bool possibleSFD();
 public:
   EthernetPhyTx(RunnableQueue &s, PortConnectionWrapper txd,
@@ -86,7 +88,7 @@ void EthernetPhyTx::reset()
   frame.clear();
 }
 
-bool EthernetPhyTx::transmitFrame()
+bool EthernetPhyTx::transmitFrame(ticks_t time)
 {
   if (frame.size() < minFrameSize)
     return false;
@@ -101,7 +103,7 @@ bool EthernetPhyTx::transmitFrame()
     return false;
   }
   
-  link->transmitFrame(&frame[0], frame.size() - 4);
+  link->transmitFrame(&frame[0], frame.size() - 4, time);
   return true;
 }
 
@@ -154,7 +156,7 @@ void EthernetPhyTx::run(ticks_t time)
     } else {
       // End of frame.
       if (!hadError) {
-        transmitFrame();
+        transmitFrame(time);
       }
       reset();
     }
@@ -192,7 +194,7 @@ class EthernetPhyRx : public Runnable {
     TX_EFD,
   } state;
   void appendCRC32();
-  bool receiveFrame();
+  bool receiveFrame(ticks_t time);
   void setRXD(unsigned value, ticks_t time);
 public:
   EthernetPhyRx(RunnableQueue &s, PortConnectionWrapper rxclk,
@@ -239,9 +241,9 @@ void EthernetPhyRx::appendCRC32()
   frameSize += 4;
 }
 
-bool EthernetPhyRx::receiveFrame()
+bool EthernetPhyRx::receiveFrame(ticks_t time)
 {
-  if (!link->receiveFrame(frame, frameSize))
+  if (!link->receiveFrame(frame, frameSize, time))
     return false;
   const unsigned minSize = minFrameSize - 4;
   if (frameSize < minSize) {
@@ -266,7 +268,7 @@ void EthernetPhyRx::run(ticks_t time)
   // Drive on falling edge.
   switch (state) {
   case IDLE:
-    if (receiveFrame()) {
+    if (receiveFrame(time)) {
       setRXD(0x5, time);
       RX_DV->seePinsChange(Signal(1), time);
       state = TX_SFD2;
@@ -515,7 +517,7 @@ public:
               PortConnectionWrapper RX_CLK, PortConnectionWrapper RXD,
               PortConnectionWrapper RX_DV, PortConnectionWrapper RX_ER,
               PortConnectionWrapper MDC, PortConnectionWrapper MDIO,
-              const std::string &ifname);
+              std::unique_ptr<NetworkLink> link);
   EthernetPhyTx &getTX() { return tx; }
 };
 
@@ -526,8 +528,8 @@ EthernetPhy(RunnableQueue &s, PortConnectionWrapper TXD,
             PortConnectionWrapper RX_CLK, PortConnectionWrapper RXD,
             PortConnectionWrapper RX_DV, PortConnectionWrapper RX_ER,
             PortConnectionWrapper MDC, PortConnectionWrapper MDIO,
-            const std::string &ifname) :
-  link(createNetworkLinkTap(ifname)),
+            std::unique_ptr<NetworkLink> l) :
+  link(std::move(l)),
   rx(s, RX_CLK, RXD, RX_DV, RX_ER),
   tx(s, TXD, TX_EN, TX_CLK),
   smi(s, MDC, MDIO)
@@ -536,6 +538,49 @@ EthernetPhy(RunnableQueue &s, PortConnectionWrapper TXD,
   tx.setLink(link.get());
 }
 
+static std::string getStringProperty(const Properties &properties,
+                                     const char *name)
+{
+  if (const Property *property = properties.get(name))
+    return property->getAsString();
+  return std::string();
+}
+
+static std::unique_ptr<NetworkLink> createLink(const Properties &properties)
+{
+  std::string type = getStringProperty(properties, "link");
+  if (type.empty() || type == "tap")
+    return createNetworkLinkTap(getStringProperty(properties, "ifname"));
+  if (type == "pcap") {
+    std::string in = getStringProperty(properties, "pcap_in");
+    std::string out = getStringProperty(properties, "pcap_out");
+    if (in.empty() && out.empty()) {
+      std::cerr << "Error: pcap link requires pcap_in or pcap_out\n";
+      std::exit(1);
+    }
+    return createNetworkLinkPcap(in, out);
+  }
+  if (type == "unix") {
+    std::string socket = getStringProperty(properties, "socket");
+    std::string peer = getStringProperty(properties, "peer");
+    if (socket.empty() || peer.empty()) {
+      std::cerr << "Error: unix link requires socket and peer\n";
+      std::exit(1);
+    }
+    return createNetworkLinkUnix(socket, peer);
+  }
+  if (type == "shm") {
+    std::string name = getStringProperty(properties, "shm");
+    if (name.empty()) {
+      std::cerr << "Error: shm link requires shm\n";
+      std::exit(1);
+    }
+    return createNetworkLinkShm(name);
+  }
+  std::cerr << "Error: unknown network link \"" << type << "\"\n";
+  std::exit(1);
+}
+
 static Peripheral *
 createEthernetPhy(SystemState &system, PortConnectionManager &connectionManager,
                   const Properties &properties)
@@ -549,12 +594,9 @@ createEthernetPhy(SystemState &system, PortConnectionManager &connectionManager,
   PortConnectionWrapper RX_ER = connectionManager.get(properties, "rx_er");
   PortConnectionWrapper MDC = connectionManager.get(properties, "mdc");
   PortConnectionWrapper MDIO = connectionManager.get(properties, "mdio");
-  std::string ifname;
-  if (const Property *property = properties.get("ifname"))
-    ifname = property->getAsString();
   EthernetPhy *p =
     new EthernetPhy(system.getScheduler(), TXD, TX_EN, TX_CLK, RX_CLK, RXD,
-                    RX_DV, RX_ER, MDC, MDIO, ifname);
+                    RX_DV, RX_ER, MDC, MDIO, createLink(properties));
   if (properties.get("tx_er"))
     p->getTX().connectTX_ER(connectionManager.get(properties, "tx_er"));
   return p;
@@ -574,6 +616,12 @@ std::unique_ptr<PeripheralDescriptor> axe::getPeripheralDescriptorEthernetPhy()
   p->addProperty(PropertyDescriptor::portProperty("rx_er")).setRequired(true);
   p->addProperty(PropertyDescriptor::portProperty("mdio"));
   p->addProperty(PropertyDescriptor::portProperty("mdc"));
+  p->addProperty(PropertyDescriptor::stringProperty("link"));
   p->addProperty(PropertyDescriptor::stringProperty("ifname"));
+  p->addProperty(PropertyDescriptor::stringProperty("pcap_in"));
+  p->addProperty(PropertyDescriptor::stringProperty("pcap_out"));
+  p->addProperty(PropertyDescriptor::stringProperty("socket"));
+  p->addProperty(PropertyDescriptor::stringProperty("peer"));
+  p->addProperty(PropertyDescriptor::stringProperty("shm"));
   return p;
 }
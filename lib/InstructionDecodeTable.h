@@ -0,0 +1,151 @@
+// Copyright (c) 2012, Richard Osborne, All rights reserved
+// This software is freely distributable under a derivative of the
+// University of Illinois/NCSA Open Source License posted in
+// LICENSE.txt and at <http://github.xcore.com/>
+
+#ifndef _InstructionDecodeTable_h_
+#define _InstructionDecodeTable_h_
+
+#include <stdint.h>
+
+/// Definitions shared between instgen, which generates the instruction decode
+/// tables, and the decoder in Instruction.cpp which indexes them. The first
+/// level of the table is indexed by the major opcode (bits 15:11) of the
+/// instruction word. The second level is indexed by a minor index computed
+/// from the remaining opcode bits according to the layout of the major opcode.
+
+namespace axe {
+
+enum DecodeLayout : uint8_t {
+  /// No instructions use this major opcode.
+  DECODE_LAYOUT_NONE,
+  /// 3r / 2rus, 2r / rus, 1r and 0r instructions.
+  DECODE_LAYOUT_3R,
+  /// ru6 instructions selected by bit 10.
+  DECODE_LAYOUT_RU6,
+  /// ru6 instructions, or u6 instructions when bits 9:6 are >= 12.
+  DECODE_LAYOUT_RU6_U6,
+  /// u10 instructions selected by bit 10.
+  DECODE_LAYOUT_U10,
+};
+
+/// How to decode the operands of an instruction from the instruction word.
+enum DecodeOperands : uint8_t {
+  DECODE_OPERANDS_NONE,
+  DECODE_OPERANDS_3R,
+  DECODE_OPERANDS_2RUS,
+  DECODE_OPERANDS_2RUS_BITP,
+  DECODE_OPERANDS_2R,
+  DECODE_OPERANDS_RUS,
+  DECODE_OPERANDS_RUS_BITP,
+  DECODE_OPERANDS_1R,
+  DECODE_OPERANDS_RU6,
+  DECODE_OPERANDS_U6,
+  DECODE_OPERANDS_U10,
+  DECODE_OPERANDS_LRU6,
+  DECODE_OPERANDS_LU6,
+  DECODE_OPERANDS_LU10,
+  DECODE_OPERANDS_L2R,
+  DECODE_OPERANDS_L3R,
+  DECODE_OPERANDS_L2RUS,
+  DECODE_OPERANDS_L2RUS_BITP,
+  DECODE_OPERANDS_L3RUS,
+  DECODE_OPERANDS_L4R,
+  DECODE_OPERANDS_L5R,
+  DECODE_OPERANDS_L6R,
+};
+
+/// Minor indices for the layouts of 16 bit instructions. These are also used
+/// for the second word of prefixed (pfix) instructions.
+enum {
+  DECODE_MINOR_3R = 0,
+  /// Plus bit 4.
+  DECODE_MINOR_2R = 1,
+  /// Plus bit 4 << 4 | bits 3:0. Covers both 1r and 0r instructions.
+  DECODE_MINOR_1R = 3,
+  DECODE_MINOR_SHORT_COUNT = 35,
+
+  /// Plus bit 10.
+  DECODE_MINOR_RU6 = 0,
+  /// Plus bit 10 << 2 | bits 7:6.
+  DECODE_MINOR_U6 = 2,
+
+  /// Plus bit 10.
+  DECODE_MINOR_U10 = 0,
+};
+
+/// Minor indices for extended (eopr) instructions. These are computed from
+/// both the first and second words of the instruction.
+enum {
+  DECODE_MINOR_L6R = 0,
+  /// Plus bit 4 of the high word.
+  DECODE_MINOR_L5R = 1,
+  /// Plus bit 4 << 4 | bits 3:0 of the high word. Covers both l4r and l3r
+  /// instructions.
+  DECODE_MINOR_L4R = 3,
+  /// Plus bit 4 of the low word << 4 | bits 3:0 of the high word.
+  DECODE_MINOR_L2R = 35,
+  /// Instructions that match none of the above.
+  DECODE_MINOR_L0R = 67,
+  DECODE_MINOR_EOPR_COUNT = 68
+};
+
+inline uint32_t decodeTableBits(uint32_t value, unsigned high, unsigned low)
+{
+  return (value >> low) & ((1 << (high - low + 1)) - 1);
+}
+
+/// Returns whether the word uses the 3r / 2rus operand encoding.
+inline bool isDecode3RWord(uint32_t word)
+{
+  return decodeTableBits(word, 10, 6) < 27;
+}
+
+/// Returns whether the word uses the 2r / rus operand encoding.
+inline bool isDecode2RWord(uint32_t word)
+{
+  return !isDecode3RWord(word) && decodeTableBits(word, 10, 5) != 0x3f;
+}
+
+inline unsigned getShortDecodeMinor(DecodeLayout layout, uint32_t word)
+{
+  switch (layout) {
+  default:
+    return 0;
+  case DECODE_LAYOUT_3R:
+    if (isDecode3RWord(word))
+      return DECODE_MINOR_3R;
+    if (isDecode2RWord(word))
+      return DECODE_MINOR_2R + decodeTableBits(word, 4, 4);
+    return DECODE_MINOR_1R + decodeTableBits(word, 4, 0);
+  case DECODE_LAYOUT_RU6:
+    return DECODE_MINOR_RU6 + decodeTableBits(word, 10, 10);
+  case DECODE_LAYOUT_RU6_U6:
+    if (decodeTableBits(word, 9, 6) < 12)
+      return DECODE_MINOR_RU6 + decodeTableBits(word, 10, 10);
+    return DECODE_MINOR_U6 + (decodeTableBits(word, 10, 10) << 2 |
+                              decodeTableBits(word, 7, 6));
+  case DECODE_LAYOUT_U10:
+    return DECODE_MINOR_U10 + decodeTableBits(word, 10, 10);
+  }
+}
+
+inline unsigned getEoprDecodeMinor(uint32_t low, uint32_t high)
+{
+  if (isDecode3RWord(low)) {
+    if (isDecode3RWord(high))
+      return DECODE_MINOR_L6R;
+    if (isDecode2RWord(high))
+      return DECODE_MINOR_L5R + decodeTableBits(high, 4, 4);
+    return DECODE_MINOR_L4R + decodeTableBits(high, 4, 0);
+  }
+  if (isDecode2RWord(low) && decodeTableBits(high, 10, 4) == 0x7e) {
+    return DECODE_MINOR_L2R + (decodeTableBits(low, 4, 4) << 4 |
+                               decodeTableBits(high, 3, 0));
+  }
+  return DECODE_MINOR_L0R;
+}
+
+} // End axe namespace
+
+#endif // _InstructionDecodeTable_h_
@@ -3,6 +3,7 @@
 // University of Illinois/NCSA Open Source License posted in
 // LICENSE.txt and at <http://github.xcore.com/>
 
+#include <algorithm>
 #include <cstdlib>
 #include "Thread.h"
 #include "Core.h"
@@ -15,6 +16,7 @@
 #include "InstructionMacrosCommon.h"
 #include "Compiler.h"
 #include "WatchpointException.h"
+#include "JITOptimize.h"
 #include <cstdio>
 
 using namespace axe;
@@ -31,7 +33,7 @@ extern "C" uint32_t jitGetPc(Thread &t) {
 extern "C" InstReturn jitStubImpl(Thread &t) {
   if (t.updateExecutionFrequencyFromStub(t.pc)) {
     t.pendingPc = t.pc;
-    t.pc = t.getParent().getRunJitAddr();
+    t.pc = t.getRunJitAddr();
   }
   return InstReturn::END_TRACE;
 }
@@ -40,13 +42,29 @@ extern "C" void jitUpdateExecutionFrequency(Thread &t) {
   t.updateExecutionFrequency(t.pc);
 }
 
+extern "C" uint32_t jitGetRamBase(const Thread &t) {
+  return t.getParent().getRamBase();
+}
+
+extern "C" uint32_t jitGetRamSizeLog2(const Thread &t) {
+  return t.getParent().getRamSizeLog2();
+}
+
+extern "C" uint32_t *jitGetRegisters(Thread &t) {
+  return t.regs;
+}
+
+extern "C" bool jitIsDualIssue(const Thread &t) {
+  return t.dualIssue;
+}
+
 extern "C" uint32_t
-jitComputeAddress(const Thread &t, Register::Reg baseReg, unsigned scale,
+jitComputeAddress(const uint32_t *regs, Register::Reg baseReg, unsigned scale,
                   Register::Reg offsetReg, uint32_t immOffset)
 {
-  uint32_t address = t.regs[baseReg];
+  uint32_t address = regs[baseReg];
   if (scale != 0)
-    address += scale * t.regs[offsetReg];
+    address += scale * regs[offsetReg];
   address += immOffset;
   return address;
 }
@@ -54,7 +72,45 @@ jitComputeAddress(const Thread &t, Register::Reg baseReg, unsigned scale,
 extern "C" bool
 jitCheckAddress(const Thread &t, uint32_t ramSizeLog2, uint32_t address)
 {
-  return (address >> ramSizeLog2) == t.getParent().getRamBaseMultiple();
+  const Core &core = t.getParent();
+  return (address >> ramSizeLog2) == core.getRamBaseMultiple() &&
+         !core.mayHitWatchpoint(address);
+}
+
+/// Returns the number of iterations of a loop, up to \a maxIterations, for
+/// which an access with the specified size starting at \a address and
+/// changing by \a step each iteration passes the memory checks in \a flags.
+extern "C" uint32_t
+jitGetLoopIterations(const Thread &t, uint32_t ramSizeLog2, uint32_t address,
+                     uint32_t size, int32_t step, unsigned flags,
+                     uint32_t maxIterations)
+{
+  if (maxIterations == 0)
+    return 0;
+  if ((flags & MemoryCheck::CheckAlignment) && address % size != 0)
+    return 0;
+  const Core &core = t.getParent();
+  if ((address >> ramSizeLog2) != core.getRamBaseMultiple())
+    return 0;
+  uint32_t offset = address - (core.getRamBaseMultiple() << ramSizeLog2);
+  uint32_t ramSize = uint32_t(1) << ramSizeLog2;
+  if (offset > ramSize - size)
+    return 0;
+  uint32_t iterations = maxIterations;
+  if (step > 0) {
+    iterations = std::min(iterations, (ramSize - size - offset) / uint32_t(step) + 1);
+  } else if (step < 0) {
+    iterations = std::min(iterations, offset / -uint32_t(step) + 1);
+  }
+  uint32_t distance = (iterations - 1) * uint32_t(step);
+  uint32_t begin = step < 0 ? address + distance : address;
+  uint32_t end = (step < 0 ? address : address + distance) + size;
+  if ((flags & MemoryCheck::CheckInvalidation) &&
+      core.invalidateRangeCheck(begin, end))
+    return 0;
+  if (core.mayHitWatchpoint(begin, end))
+    return 0;
+  return iterations;
 }
 
 extern "C" bool jitInvalidateByteCheck(Thread &t, uint32_t address)
@@ -79,7 +135,7 @@ extern "C" bool jitInvalidateDoubleCheck(Thread &t, uint32_t address)
 
 extern "C" InstReturn jitInterpretOne(Thread &t) {
   t.pendingPc = t.pc;
-  t.pc = t.getParent().getInterpretOneAddr();
+  t.pc = t.getInterpretOneAddr();
   return InstReturn::END_TRACE;
 }
 
@@ -48,15 +48,6 @@ uint32_t axe::exception(Thread &t, uint32_t pc, int et, uint32_t ed)
   return t.toPc(newPc);
 }
 
-Resource *axe::checkResource(Core &state, ResourceID id)
-{
-  Resource *res = state.getResourceByID(id);
-  if (!res || !res->isInUse()) {
-    return 0;
-  }
-  return res;
-}
-
 Synchroniser *axe::checkSync(Core &state, ResourceID id)
 {
   Resource *res = checkResource(state, id);
@@ -77,26 +68,6 @@ Thread *axe::checkThread(Core &state, ResourceID id)
   return static_cast<Thread *>(res);
 }
 
-Chanend *axe::checkChanend(Core &state, ResourceID id)
-{
-  Resource *res = checkResource(state, id);
-  if (!res)
-    return 0;
-  if (res->getType() != RES_TYPE_CHANEND)
-    return 0;
-  return static_cast<Chanend *>(res);
-}
-
-Port *axe::checkPort(Core &state, ResourceID id)
-{
-  Resource *res = checkResource(state, id);
-  if (!res)
-    return 0;
-  if (res->getType() != RES_TYPE_PORT)
-    return 0;
-  return static_cast<Port *>(res);
-}
-
 EventableResource *axe::checkEventableResource(Core &state, ResourceID id)
 {
   Resource *res = checkResource(state, id);
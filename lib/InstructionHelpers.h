@@ -8,30 +8,53 @@
 
 #include <stdint.h>
 #include "Config.h"
+#include "Core.h"
+#include "Chanend.h"
 
 namespace axe {
 
 class Thread;
-class Core;
 class ResourceID;
-class Resource;
 class Synchroniser;
 class Thread;
-class Chanend;
-class Port;
 class EventableResource;
 
 uint32_t exception(Thread &t, uint32_t pc, int et, uint32_t ed);
 
-Resource *checkResource(Core &state, ResourceID id);
+// The lookups used by the I/O instructions are defined inline so that they
+// are inlined into JIT compiled code along with the instruction fast paths.
+inline Resource *checkResource(Core &state, ResourceID id)
+{
+  Resource *res = state.getResourceByID(id);
+  if (!res || !res->isInUse()) {
+    return 0;
+  }
+  return res;
+}
 
 Synchroniser *checkSync(Core &state, ResourceID id);
 
 Thread *checkThread(Core &state, ResourceID id);
 
-Chanend *checkChanend(Core &state, ResourceID id);
+inline Chanend *checkChanend(Core &state, ResourceID id)
+{
+  Resource *res = checkResource(state, id);
+  if (!res)
+    return 0;
+  if (res->getType() != RES_TYPE_CHANEND)
+    return 0;
+  return static_cast<Chanend *>(res);
+}
 
-Port *checkPort(Core &state, ResourceID id);
+inline Port *checkPort(Core &state, ResourceID id)
+{
+  Resource *res = checkResource(state, id);
+  if (!res)
+    return 0;
+  if (res->getType() != RES_TYPE_PORT)
+    return 0;
+  return static_cast<Port *>(res);
+}
 
 EventableResource *checkEventableResource(Core &state, ResourceID id);
 
@@ -25,7 +25,8 @@ struct InstructionProperties {
     MAY_YIELD = 1 << 1,
     MAY_DESCHEDULE = 1 << 2,
     MAY_END_TRACE = 1 << 3,
-    MEM_CHECK_OPT_ENABLED = 1 << 4
+    MEM_CHECK_OPT_ENABLED = 1 << 4,
+    MAY_ACCESS_THREAD_STATE = 1 << 5
   };
   const char *function;
   OperandProperties::OpType *ops;
@@ -41,6 +42,9 @@ struct InstructionProperties {
   bool memCheckHoistingOptEnabled() const {
     return flags & MEM_CHECK_OPT_ENABLED;
   }
+  /// Returns whether the instruction may read or write thread state (including
+  /// registers) other than through its operands.
+  bool mayAccessThreadState() const { return flags & MAY_ACCESS_THREAD_STATE; }
   unsigned getNumOperands() const { return numOperands; }
   unsigned getNumExplicitOperands() const {
     return numOperands - numImplicitOperands;
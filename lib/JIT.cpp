@@ -34,6 +34,8 @@
 #include <iostream>
 #include <cstdlib>
 #include <cassert>
+#include <climits>
+#include <list>
 #include <map>
 #include <vector>
 
@@ -44,9 +46,15 @@ using namespace axe;
 // TODO make this a struct wrapper so we can enforce type safety.
 typedef InstFunction_t InstFunctionFast_t;
 
+struct JITCacheInfo;
+struct JITFunctionInfo;
+
+typedef std::list<std::pair<JITCacheInfo*, JITFunctionInfo*>> JITLRUList;
+
 struct JITFunctionInfo {
   explicit JITFunctionInfo(uint32_t a) :
-    pc(a), ptr(0), fastFunc(0), func(0), fastFuncValue(0), funcValue(0) {}
+    pc(a), ptr(0), fastFunc(0), func(0), fastFuncValue(0), funcValue(0),
+    codeSize(0), inLRU(false), referenced(false) {}
   uint32_t pc;
   /// Global function pointer used to chain calls to this basic block.
   LLVMValueRef ptr;
@@ -62,15 +70,37 @@ struct JITFunctionInfo {
   LLVMValueRef fastFuncValue;
   /// LLVMValueRef for func.
   LLVMValueRef funcValue;
+  /// Estimated size of the generated code in bytes.
+  unsigned codeSize;
+  /// Whether the function is in the LRU list (and counted in the cache usage).
+  bool inLRU;
+  JITLRUList::iterator lruPosition;
+  /// Set by the generated code each time the function is entered and cleared
+  /// when the function is given a second chance by evictColdFunctions().
+  bool referenced;
+  /// Start addresses of the functions the code chains to.
+  std::vector<uint32_t> successors;
 };
 
-struct JITCoreInfo {
+/// Compiled code for a decode cache.
+struct JITCacheInfo {
+  /// Whether the code is specific to a single core. Code compiled for a
+  /// read-only decode cache (e.g. the ROM) is shared between cores and so
+  /// can't make assumptions about the core's RAM.
+  bool coreSpecific;
+  /// The decode cache, updated each time code is compiled for it.
+  DecodeCache::State cache;
   std::vector<uint32_t> unreachableFunctions;
+  /// Functions whose information may no longer be needed since their code or
+  /// the code chaining to them has been freed.
+  std::vector<uint32_t> maybeUnusedFunctions;
   std::map<uint32_t, JITFunctionInfo*> functionMap;
-  ~JITCoreInfo();
+  JITCacheInfo(bool c, const DecodeCache::State &s) :
+    coreSpecific(c), cache(s) {}
+  ~JITCacheInfo();
 };
 
-JITCoreInfo::~JITCoreInfo()
+JITCacheInfo::~JITCacheInfo()
 {
   for (auto &entry : functionMap) {
     delete entry.second;
@@ -90,6 +120,11 @@ class axe::JITImpl {
     LLVMValueRef jitInvalidateWordCheck;
     LLVMValueRef jitInvalidateDoubleCheck;
     LLVMValueRef jitInterpretOne;
+    LLVMValueRef jitGetRamBase;
+    LLVMValueRef jitGetRamSizeLog2;
+    LLVMValueRef jitGetRegisters;
+    LLVMValueRef jitIsDualIssue;
+    LLVMValueRef jitGetLoopIterations;
     void init(LLVMModuleRef mod);
   };
   Functions functions;
@@ -102,12 +137,41 @@ class axe::JITImpl {
   // Stub used to return to the interpreter (lazily initialized).
   InstFunctionFast_t stub;
 
-  std::map<const Core*,JITCoreInfo*> jitCoreMap;
+  /// Compiled code indexed by the opcode array of the decode cache.
+  std::map<const OPCODE_TYPE*,JITCacheInfo*> jitCacheMap;
+  /// Limit on the estimated size of generated code, 0 if unlimited.
+  uint64_t cacheSize;
+  /// Estimated size of generated code.
+  uint64_t cacheUsage;
+  uint64_t numEvictions;
+  /// Compiled functions, least recently used first.
+  JITLRUList lru;
+  /// The first function in the LRU list compiled by the current call to
+  /// compileBlock(), lru.end() if none. These functions are about to be run
+  /// and so are never evicted.
+  JITLRUList::iterator recentlyCompiled;
   std::vector<LLVMValueRef> earlyReturnIncomingValues;
   std::vector<LLVMBasicBlockRef> earlyReturnIncomingBlocks;
 
   LLVMValueRef threadParam;
+  LLVMValueRef ramBaseParam;
   LLVMValueRef ramSizeLog2Param;
+  /// Pointer to the register file of the thread.
+  LLVMValueRef threadRegs;
+  /// Pointer to the copy of the register file local to the function or null
+  /// if registers are not promoted.
+  LLVMValueRef promotedRegs;
+  /// Registers in the local copy that have been modified since they were last
+  /// written back to the thread.
+  uint32_t dirtyRegs;
+  /// Registers written back by the interpret one bailout block.
+  uint32_t interpretOneDirtyRegs;
+  /// Registers written back by the end trace bailout block.
+  uint32_t endTraceDirtyRegs;
+  /// If the fragment is a loop, the pc of the start of the loop and the block
+  /// to branch to when the loop is taken.
+  uint32_t loopPc;
+  LLVMBasicBlockRef loopBB;
   LLVMBasicBlockRef earlyReturnBB;
   LLVMBasicBlockRef interpretOneBB;
   LLVMBasicBlockRef endTraceBB;
@@ -117,38 +181,68 @@ class axe::JITImpl {
   void init();
   LLVMValueRef getCurrentFunction();
   void resetPerFunctionState();
-  void reclaimUnreachableFunctions(JITCoreInfo &coreInfo);
+  void reclaimUnreachableFunctions(JITCacheInfo &cacheInfo);
   void reclaimUnreachableFunctions();
+  void deleteUnusedFunctionInfo(JITCacheInfo &cacheInfo);
+  void addToLRU(JITCacheInfo &cacheInfo, JITFunctionInfo &info);
+  void removeFromLRU(JITFunctionInfo &info);
+  void evictColdFunctions();
+  void emitSetReferenced(JITFunctionInfo &info);
   void emitCondEarlyReturn(LLVMValueRef cond, LLVMValueRef retval);
   void checkReturnValue(LLVMValueRef call, InstructionProperties &properties);
   void emitCondBrToBlock(LLVMValueRef cond, LLVMBasicBlockRef trueBB);
   void ensureEarlyReturnBB(LLVMTypeRef phiType);
-  LLVMValueRef getNextFragmentPointer(JITCoreInfo &coreInfo, uint32_t pc);
+  LLVMValueRef getNextFragmentPointer(JITCacheInfo &cacheInfo, uint32_t pc);
   LLVMBasicBlockRef appendBBToCurrentFunction(const char *name);
   LLVMValueRef emitCallToBeInlined(LLVMValueRef fn, LLVMValueRef *args,
                                    unsigned numArgs);
-  JITCoreInfo *getJITCoreInfo(const Core &);
-  JITCoreInfo *getOrCreateJITCoreInfo(const Core &);
+  LLVMValueRef getRegisterAddress(LLVMValueRef regs, unsigned reg);
+  void loadPromotedRegisters();
+  void writeBackDirtyRegisters();
+  JITCacheInfo *getJITCacheInfo(const DecodeCache::State &cache);
+  JITCacheInfo *getOrCreateJITCacheInfo(const Core &core,
+                                        const DecodeCache::State &cache);
   InstFunctionFast_t getOrCreateStub();
-  bool compileOneFragment(Core &core, JITCoreInfo &coreInfo, uint32_t pc,
+  bool compileOneFragment(Core &core, DecodeCache::State &cache,
+                          JITCacheInfo &cacheInfo, uint32_t pc,
                           bool &endOfBlock, uint32_t &nextPc);
+  uint32_t emitFragmentBody(JITCacheInfo &cacheInfo, JITFunctionInfo *info,
+                            uint32_t startPc,
+                            const std::vector<InstructionOpcode> &opcode,
+                            const std::vector<Operands> &operands,
+                            std::queue<std::pair<uint32_t,MemoryCheck>> &checks);
+  void emitLoop(JITCacheInfo &cacheInfo, JITFunctionInfo *info,
+                uint32_t startPc,
+                const std::vector<InstructionOpcode> &opcode,
+                const std::vector<Operands> &operands,
+                std::queue<std::pair<uint32_t,MemoryCheck>> &checks,
+                std::queue<std::pair<uint32_t,MemoryCheck>> &loopBodyChecks,
+                const std::vector<LoopMemoryCheck> &loopChecks);
   LLVMBasicBlockRef getOrCreateMemoryCheckBailoutBlock(unsigned index);
+  LLVMValueRef emitComputeAddress(const MemoryCheck &check);
   void emitMemoryChecks(unsigned index,
                         std::queue<std::pair<uint32_t,MemoryCheck>> &checks);
   LLVMValueRef getJitInvalidateFunction(unsigned size);
-  void emitJumpToNextFragment(JITCoreInfo &coreInfo, uint32_t targetPc,
+  void emitJumpToNextFragment(JITCacheInfo &cacheInfo, uint32_t targetPc,
                               JITFunctionInfo *caller);
   bool emitJumpToNextFragment(InstructionOpcode opc, const Operands &operands,
-                              JITCoreInfo &coreInfo, uint32_t nextPc,
+                              JITCacheInfo &cacheInfo, uint32_t nextPc,
                               JITFunctionInfo *caller);
   LLVMValueRef getFunctionThunk(LLVMValueRef f);
 public:
-  JITImpl() : initialized(false) {}
+  JITImpl() :
+    initialized(false), cacheSize(0), cacheUsage(0), numEvictions(0),
+    recentlyCompiled(lru.end()) {}
   ~JITImpl();
   static JITImpl instance;
   static void initializeGlobalState();
   bool invalidate(Core &c, uint32_t pc);
-  void compileBlock(Core &core, uint32_t pc);
+  bool invalidateRange(Core &c, uint32_t beginPc, uint32_t endPc);
+  void compileBlock(Core &core, DecodeCache::State &cache, uint32_t pc);
+  void setCacheSize(uint64_t bytes) { cacheSize = bytes; }
+  uint64_t getCacheSize() const { return cacheSize; }
+  uint64_t getCacheUsage() const { return cacheUsage; }
+  uint64_t getNumEvictions() const { return numEvictions; }
 };
 
 JITImpl::~JITImpl()
@@ -159,7 +253,7 @@ JITImpl::~JITImpl()
     LLVMDisposeExecutionEngine(executionEngine);
     LLVMContextDispose(context);
   }
-  for (auto &entry : jitCoreMap) {
+  for (auto &entry : jitCacheMap) {
     delete entry.second;
   }
 }
@@ -180,6 +274,11 @@ void JITImpl::Functions::init(LLVMModuleRef module)
     { "jitInvalidateWordCheck", &jitInvalidateWordCheck },
     { "jitInvalidateDoubleCheck", &jitInvalidateDoubleCheck },
     { "jitInterpretOne", &jitInterpretOne },
+    { "jitGetRamBase", &jitGetRamBase },
+    { "jitGetRamSizeLog2", &jitGetRamSizeLog2 },
+    { "jitGetRegisters", &jitGetRegisters },
+    { "jitIsDualIssue", &jitIsDualIssue },
+    { "jitGetLoopIterations", &jitGetLoopIterations },
   };
   for (unsigned i = 0; i < arraySize(initInfo); i++) {
     *initInfo[i].ref = LLVMGetNamedFunction(module, initInfo[i].name);
@@ -237,6 +336,7 @@ void JITImpl::init()
   LLVMAddTargetData(LLVMGetExecutionEngineTargetData(executionEngine), FPM);
   LLVMAddTypeBasedAliasAnalysisPass(FPM);
   LLVMAddBasicAliasAnalysisPass(FPM);
+  LLVMAddScalarReplAggregatesPass(FPM);
   LLVMAddJumpThreadingPass(FPM);
   LLVMAddGVNPass(FPM);
   LLVMAddJumpThreadingPass(FPM);
@@ -259,7 +359,15 @@ LLVMValueRef JITImpl::getCurrentFunction()
 void JITImpl::resetPerFunctionState()
 {
   threadParam = 0;
+  ramBaseParam = 0;
   ramSizeLog2Param = 0;
+  threadRegs = 0;
+  promotedRegs = 0;
+  dirtyRegs = 0;
+  interpretOneDirtyRegs = 0;
+  endTraceDirtyRegs = 0;
+  loopPc = 0;
+  loopBB = 0;
   earlyReturnBB = 0;
   interpretOneBB = 0;
   endTraceBB = 0;
@@ -269,24 +377,27 @@ void JITImpl::resetPerFunctionState()
 }
 
 static bool
-getInstruction(Core &core, uint32_t address, InstructionOpcode &opc,
-               Operands &operands)
+getInstruction(Core &core, const DecodeCache::State &cache, uint32_t address,
+               InstructionOpcode &opc, Operands &operands)
 {
-  if (!core.isValidRamPc(core.toRamPc(address)))
+  if (!cache.contains(address))
     return false;
   instructionDecode(core, address, opc, operands);
   return true;
 }
 
-void JITImpl::reclaimUnreachableFunctions(JITCoreInfo &coreInfo)
+void JITImpl::reclaimUnreachableFunctions(JITCacheInfo &cacheInfo)
 {
-  std::vector<uint32_t> &unreachableFunctions = coreInfo.unreachableFunctions;
-  std::map<uint32_t,JITFunctionInfo*> &functionMap = coreInfo.functionMap;
+  std::vector<uint32_t> &unreachableFunctions = cacheInfo.unreachableFunctions;
+  std::map<uint32_t,JITFunctionInfo*> &functionMap = cacheInfo.functionMap;
   for (uint32_t addr : unreachableFunctions) {
     auto entry = functionMap.find(addr);
     if (entry == functionMap.end())
       continue;
     JITFunctionInfo *info = entry->second;
+    if (!info->fastFuncValue)
+      continue;
+    removeFromLRU(*info);
     LLVMValueRef functions[] = {
       info->funcValue,
       info->fastFuncValue
@@ -300,21 +411,116 @@ void JITImpl::reclaimUnreachableFunctions(JITCoreInfo &coreInfo)
     info->func = nullptr;
     info->funcValue = nullptr;
     info->fastFuncValue = nullptr;
+    std::vector<uint32_t> &maybeUnused = cacheInfo.maybeUnusedFunctions;
+    maybeUnused.push_back(info->pc);
+    maybeUnused.insert(maybeUnused.end(), info->successors.begin(),
+                       info->successors.end());
+    info->successors.clear();
     if (info->ptr) {
       *reinterpret_cast<InstFunctionFast_t*>(
         LLVMGetPointerToGlobal(executionEngine, info->ptr)) = getOrCreateStub();
     }
   }
+  if (!unreachableFunctions.empty())
+    deleteUnusedFunctionInfo(cacheInfo);
   unreachableFunctions.clear();
 }
 
+/// Delete the information for functions that have no code and that no
+/// remaining code chains to. This frees the global used to chain to the
+/// function, which is otherwise kept for as long as the JIT exists. Only the
+/// functions in maybeUnusedFunctions are checked.
+void JITImpl::deleteUnusedFunctionInfo(JITCacheInfo &cacheInfo)
+{
+  std::map<uint32_t,JITFunctionInfo*> &functionMap = cacheInfo.functionMap;
+  for (uint32_t addr : cacheInfo.maybeUnusedFunctions) {
+    auto it = functionMap.find(addr);
+    if (it == functionMap.end())
+      continue;
+    JITFunctionInfo *info = it->second;
+    if (info->fastFuncValue || (info->ptr && LLVMGetFirstUse(info->ptr)))
+      continue;
+    if (info->ptr)
+      LLVMExtraDeleteGlobal(executionEngine, info->ptr);
+    delete info;
+    functionMap.erase(it);
+  }
+  cacheInfo.maybeUnusedFunctions.clear();
+}
+
 void JITImpl::reclaimUnreachableFunctions()
 {
-  for (auto &entry : jitCoreMap) {
+  for (auto &entry : jitCacheMap) {
     reclaimUnreachableFunctions(*entry.second);
   }
 }
 
+void JITImpl::addToLRU(JITCacheInfo &cacheInfo, JITFunctionInfo &info)
+{
+  assert(!info.inLRU);
+  info.lruPosition = lru.insert(lru.end(), std::make_pair(&cacheInfo, &info));
+  info.inLRU = true;
+  if (recentlyCompiled == lru.end())
+    recentlyCompiled = info.lruPosition;
+  cacheUsage += info.codeSize;
+}
+
+void JITImpl::removeFromLRU(JITFunctionInfo &info)
+{
+  if (!info.inLRU)
+    return;
+  if (recentlyCompiled == info.lruPosition)
+    ++recentlyCompiled;
+  lru.erase(info.lruPosition);
+  info.inLRU = false;
+  cacheUsage -= info.codeSize;
+}
+
+/// Evict the least recently used functions until the estimated size of the
+/// generated code is within the limit. Functions that have been entered since
+/// they were last considered are moved to the back of the list instead of
+/// being evicted (the clock algorithm), so hot code is kept even though the
+/// list is not updated on each call. Functions compiled by the current call to
+/// compileBlock() are kept. Evicted functions are removed from the
+/// decode cache immediately but, as with invalidated functions, the code is
+/// only freed by the next call to reclaimUnreachableFunctions() since it may
+/// currently be executing.
+void JITImpl::evictColdFunctions()
+{
+  if (cacheSize == 0)
+    return;
+  while (cacheUsage > cacheSize && lru.begin() != recentlyCompiled) {
+    JITCacheInfo &cacheInfo = *lru.front().first;
+    JITFunctionInfo &info = *lru.front().second;
+    if (info.referenced) {
+      info.referenced = false;
+      lru.splice(recentlyCompiled, lru, info.lruPosition);
+      continue;
+    }
+    removeFromLRU(info);
+    DecodeCache::State &cache = cacheInfo.cache;
+    if (cache.opcode[info.pc] == info.func)
+      cache.clearOpcode(info.pc);
+    // Allow the code to be compiled again if it becomes hot.
+    cache.executionFrequency[info.pc] = 0;
+    cacheInfo.unreachableFunctions.push_back(info.pc);
+    ++numEvictions;
+  }
+}
+
+void JITImpl::emitSetReferenced(JITFunctionInfo &info)
+{
+  LLVMTypeRef int8Type = LLVMInt8TypeInContext(context);
+  LLVMTypeRef intPtrType =
+    LLVMIntTypeInContext(context, sizeof(void*) * CHAR_BIT);
+  LLVMValueRef address =
+    LLVMConstIntToPtr(LLVMConstInt(intPtrType,
+                                   reinterpret_cast<uintptr_t>(&info.referenced),
+                                   false),
+                      LLVMPointerType(int8Type, 0));
+  LLVMBuildStore(builder, LLVMConstInt(int8Type, 1, false), address);
+}
+
 static bool mayReturnEarly(InstructionProperties &properties)
 {
   return properties.mayYield() || properties.mayEndTrace() ||
@@ -324,9 +530,22 @@ static bool mayReturnEarly(InstructionProperties &properties)
 void JITImpl::emitCondEarlyReturn(LLVMValueRef cond, LLVMValueRef retval)
 {
   ensureEarlyReturnBB(LLVMGetReturnType((jitFunctionType)));
+  if (!dirtyRegs) {
+    earlyReturnIncomingValues.push_back(retval);
+    earlyReturnIncomingBlocks.push_back(LLVMGetInsertBlock(builder));
+    emitCondBrToBlock(cond, earlyReturnBB);
+    return;
+  }
+  // Write back modified registers before returning.
+  LLVMBasicBlockRef writeBackBB = appendBBToCurrentFunction("");
+  emitCondBrToBlock(cond, writeBackBB);
+  LLVMBasicBlockRef savedBB = LLVMGetInsertBlock(builder);
+  LLVMPositionBuilderAtEnd(builder, writeBackBB);
+  writeBackDirtyRegisters();
   earlyReturnIncomingValues.push_back(retval);
-  earlyReturnIncomingBlocks.push_back(LLVMGetInsertBlock(builder));
-  emitCondBrToBlock(cond, earlyReturnBB);
+  earlyReturnIncomingBlocks.push_back(writeBackBB);
+  LLVMBuildBr(builder, earlyReturnBB);
+  LLVMPositionBuilderAtEnd(builder, savedBB);
 }
 
 void
@@ -365,17 +584,95 @@ emitCallToBeInlined(LLVMValueRef fn, LLVMValueRef *args, unsigned numArgs)
   return call;
 }
 
-void JITImpl::compileBlock(Core &core, uint32_t pc)
+LLVMValueRef JITImpl::getRegisterAddress(LLVMValueRef regs, unsigned reg)
+{
+  LLVMValueRef index = LLVMConstInt(LLVMInt32TypeInContext(context), reg,
+                                    false);
+  return LLVMBuildInBoundsGEP(builder, regs, &index, 1, "");
+}
+
+/// Number of registers that may be promoted. The remaining registers are
+/// only accessed by exceptions and by instructions that access the thread
+/// state directly.
+const unsigned numPromotedRegisters = Register::ET;
+
+/// Copy the promotable registers from the thread into the local copy of the
+/// register file. Loads of registers that are never read are removed by the
+/// optimizer.
+void JITImpl::loadPromotedRegisters()
+{
+  for (unsigned reg = 0; reg != numPromotedRegisters; ++reg) {
+    LLVMValueRef value =
+      LLVMBuildLoad(builder, getRegisterAddress(threadRegs, reg), "");
+    LLVMBuildStore(builder, value, getRegisterAddress(promotedRegs, reg));
+  }
+}
+
+void JITImpl::writeBackDirtyRegisters()
+{
+  for (unsigned reg = 0; reg != numPromotedRegisters; ++reg) {
+    if (!(dirtyRegs & (1 << reg)))
+      continue;
+    LLVMValueRef value =
+      LLVMBuildLoad(builder, getRegisterAddress(promotedRegs, reg), "");
+    LLVMBuildStore(builder, value, getRegisterAddress(threadRegs, reg));
+  }
+}
+
+/// Returns whether the registers accessed by the instruction can be kept in
+/// the local copy of the register file.
+static bool
+canPromoteRegisters(const InstructionProperties &properties,
+                    const Operands &operands)
+{
+  if (properties.mayAccessThreadState())
+    return false;
+  for (unsigned i = 0, e = properties.getNumExplicitOperands(); i != e; ++i) {
+    if (properties.getOperandType(i) != OperandProperties::imm &&
+        operands.ops[i] >= numPromotedRegisters)
+      return false;
+  }
+  for (unsigned i = 0, e = properties.getNumOperands() -
+       properties.getNumExplicitOperands(); i != e; ++i) {
+    if (properties.getImplicitOperand(i) >= numPromotedRegisters)
+      return false;
+  }
+  return true;
+}
+
+static uint32_t
+getRegistersWritten(const InstructionProperties &properties,
+                    const Operands &operands)
+{
+  uint32_t written = 0;
+  unsigned numExplicit = properties.getNumExplicitOperands();
+  for (unsigned i = 0, e = properties.getNumOperands(); i != e; ++i) {
+    OperandProperties::OpType type = properties.getOperandType(i);
+    if (type != OperandProperties::out && type != OperandProperties::inout)
+      continue;
+    Register::Reg reg =
+      i < numExplicit ? static_cast<Register::Reg>(operands.ops[i]) :
+                        properties.getImplicitOperand(i - numExplicit);
+    written |= 1 << reg;
+  }
+  return written;
+}
+
+void JITImpl::compileBlock(Core &core, DecodeCache::State &cache, uint32_t pc)
 {
   init();
   reclaimUnreachableFunctions();
+  recentlyCompiled = lru.end();
   bool endOfBlock;
   uint32_t nextPc;
-  JITCoreInfo &coreInfo = *getOrCreateJITCoreInfo(core);
+  JITCacheInfo &cacheInfo = *getOrCreateJITCacheInfo(core, cache);
+  cacheInfo.cache = cache;
   do {
-    compileOneFragment(core, coreInfo, pc, endOfBlock, nextPc);
+    compileOneFragment(core, cache, cacheInfo, pc, endOfBlock, nextPc);
     pc = nextPc;
   } while (!endOfBlock);
+  evictColdFunctions();
+  recentlyCompiled = lru.end();
 }
 
 static bool
@@ -417,20 +714,22 @@ getSuccessors(InstructionOpcode opc, const Operands &operands,
   }
 }
 
-JITCoreInfo *JITImpl::getJITCoreInfo(const Core &c)
+JITCacheInfo *JITImpl::getJITCacheInfo(const DecodeCache::State &cache)
 {
-  auto it = jitCoreMap.find(&c);
-  if (it != jitCoreMap.end())
+  auto it = jitCacheMap.find(cache.opcode);
+  if (it != jitCacheMap.end())
     return it->second;
   return 0;
 }
 
-JITCoreInfo *JITImpl::getOrCreateJITCoreInfo(const Core &c)
+JITCacheInfo *JITImpl::
+getOrCreateJITCacheInfo(const Core &core, const DecodeCache::State &cache)
 {
-  if (JITCoreInfo *info = getJITCoreInfo(c))
+  if (JITCacheInfo *info = getJITCacheInfo(cache))
     return info;
-  JITCoreInfo *info = new JITCoreInfo;
-  jitCoreMap.insert(std::make_pair(&c, info));
+  bool coreSpecific = cache.opcode == core.getRamDecodeCache().opcode;
+  JITCacheInfo *info = new JITCacheInfo(coreSpecific, cache);
+  jitCacheMap.insert(std::make_pair(cache.opcode, info));
   return info;
 }
 
@@ -460,9 +759,9 @@ InstFunctionFast_t JITImpl::getOrCreateStub()
   return stub;
 }
 
-LLVMValueRef JITImpl::getNextFragmentPointer(JITCoreInfo &coreInfo, uint32_t pc)
+LLVMValueRef JITImpl::getNextFragmentPointer(JITCacheInfo &cacheInfo, uint32_t pc)
 {
-  JITFunctionInfo *&info = coreInfo.functionMap[pc];
+  JITFunctionInfo *&info = cacheInfo.functionMap[pc];
   if (!info) {
     info = new JITFunctionInfo(pc);
   }
@@ -490,10 +789,17 @@ LLVMBasicBlockRef JITImpl::appendBBToCurrentFunction(const char *name)
 }
 
 void JITImpl::
-emitJumpToNextFragment(JITCoreInfo &coreInfo, uint32_t targetPc,
+emitJumpToNextFragment(JITCacheInfo &cacheInfo, uint32_t targetPc,
                        JITFunctionInfo *caller)
 {
-  LLVMValueRef nextPtr = getNextFragmentPointer(coreInfo, targetPc);
+  if (loopBB && targetPc == loopPc) {
+    LLVMBuildBr(builder, loopBB);
+    return;
+  }
+  writeBackDirtyRegisters();
+  LLVMValueRef nextPtr = getNextFragmentPointer(cacheInfo, targetPc);
+  if (caller)
+    caller->successors.push_back(targetPc);
   LLVMValueRef next = LLVMBuildLoad(builder, nextPtr, "");
   LLVMValueRef args[] = {
     threadParam
@@ -506,7 +812,7 @@ emitJumpToNextFragment(JITCoreInfo &coreInfo, uint32_t targetPc,
 
 bool JITImpl::
 emitJumpToNextFragment(InstructionOpcode opc, const Operands &operands,
-                       JITCoreInfo &coreInfo, uint32_t nextPc,
+                       JITCacheInfo &cacheInfo, uint32_t nextPc,
                        JITFunctionInfo *caller)
 {
   std::set<uint32_t> successors;
@@ -530,16 +836,35 @@ emitJumpToNextFragment(InstructionOpcode opc, const Operands &operands,
       LLVMBasicBlockRef afterBB = appendBBToCurrentFunction("");
       LLVMBuildCondBr(builder, cmp, trueBB, afterBB);
       LLVMPositionBuilderAtEnd(builder, trueBB);
-      emitJumpToNextFragment(coreInfo, *it, caller);
+      emitJumpToNextFragment(cacheInfo, *it, caller);
       LLVMPositionBuilderAtEnd(builder, afterBB);
     }
   }
-  emitJumpToNextFragment(coreInfo, *successors.begin(), caller);
+  emitJumpToNextFragment(cacheInfo, *successors.begin(), caller);
   return true;
 }
 
+/// Estimate the size of the machine code generated for a function. The JIT
+/// doesn't report the size of the code it generates so this is approximated
+/// from the number of instructions after optimization.
+static unsigned estimateCodeSize(LLVMValueRef f)
+{
+  const unsigned bytesPerInstruction = 8;
+  const unsigned functionOverhead = 64;
+  unsigned numInstructions = 0;
+  for (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(f); bb;
+       bb = LLVMGetNextBasicBlock(bb)) {
+    for (LLVMValueRef inst = LLVMGetFirstInstruction(bb); inst;
+         inst = LLVMGetNextInstruction(inst)) {
+      ++numInstructions;
+    }
+  }
+  return functionOverhead + numInstructions * bytesPerInstruction;
+}
+
 static bool
-getFragmentToCompile(Core &core, uint32_t startAddress,
+getFragmentToCompile(Core &core, const DecodeCache::State &cache,
+                     uint32_t startAddress,
                      std::vector<InstructionOpcode> &opcode,
                      std::vector<Operands> &operands, 
                      bool &endOfBlock, uint32_t &nextAddress)
@@ -555,7 +880,7 @@ getFragmentToCompile(Core &core, uint32_t startAddress,
   Operands ops;
   InstructionProperties *properties;
   do {
-    if (!getInstruction(core, address, opc, ops)) {
+    if (!getInstruction(core, cache, address, opc, ops)) {
       endOfBlock = true;
       break;
     }
@@ -577,54 +902,37 @@ getFragmentToCompile(Core &core, uint32_t startAddress,
   return !opcode.empty();
 }
 
-/// Try and compile a fragment starting at the specified address. Returns
-/// true if successful setting \a nextAddress to the first instruction after
-/// the fragment. If unsuccessful returns false and sets \a nextAddress to the
-/// address after the current function. \a endOfBlock is set to true if the
-/// next address is in a new basic block.
-bool JITImpl::
-compileOneFragment(Core &core, JITCoreInfo &coreInfo, uint32_t startPc,
-                   bool &endOfBlock, uint32_t &pcAfterFragment)
+/// Returns whether the last instruction of the fragment may branch back to
+/// the start of the fragment, in which case the fragment is compiled as a
+/// loop.
+static bool
+isLoopFragment(uint32_t startPc, const std::vector<InstructionOpcode> &opcode,
+               const std::vector<Operands> &operands)
 {
-  assert(initialized);
-  resetPerFunctionState();
-
-  auto infoIt = coreInfo.functionMap.find(startPc);
-  JITFunctionInfo *info =
-    (infoIt == coreInfo.functionMap.end()) ? 0 : infoIt->second;
-  if (info && info->fastFuncValue) {
-    endOfBlock = true;
-    return false;
-  }
-
-  std::vector<InstructionOpcode> opcode;
-  std::vector<Operands> operands;
-  if (!getFragmentToCompile(core, core.fromRamPc(startPc), opcode, operands,
-                            endOfBlock, pcAfterFragment)) {
-    pcAfterFragment = core.toRamPc(pcAfterFragment);
+  uint32_t pc = startPc;
+  for (InstructionOpcode opc : opcode)
+    pc += instructionProperties[opc].size / 2;
+  std::set<uint32_t> successors;
+  if (!getSuccessors(opcode.back(), operands.back(), pc, successors))
     return false;
-  }
-  std::queue<std::pair<uint32_t,MemoryCheck>> checks;
-  placeMemoryChecks(opcode, operands, checks);
+  return successors.count(startPc);
+}
 
-  if (info) {
-    info->func = 0;
-  } else {
-    info = new JITFunctionInfo(startPc);
-    coreInfo.functionMap.insert(std::make_pair(startPc, info));
-  }
-  // Create function to contain the code we are about to add.
-  LLVMValueRef f = LLVMAddFunction(module, "", jitFunctionType);
-  LLVMSetFunctionCallConv(f, LLVMFastCallConv);
-  info->fastFuncValue = f;
-  threadParam = LLVMGetParam(f, 0);
-  LLVMValueRef ramBase =
-    LLVMConstInt(LLVMInt32TypeInContext(context), core.getRamBase(), false);
-  ramSizeLog2Param =
-    LLVMConstInt(LLVMInt32TypeInContext(context), core.getRamSizeLog2(), false);
-  LLVMBasicBlockRef entryBB =
-    LLVMAppendBasicBlockInContext(context, f, "entry");
-  LLVMPositionBuilderAtEnd(builder, entryBB);
+/// Maximum number of loop iterations covered by one evaluation of the hoisted
+/// memory checks. This bounds the range of memory scanned for decoded
+/// instructions when checking stores.
+const uint32_t maxLoopIterationsPerCheck = 256;
+
+/// Emit the code for the instructions in a fragment, returning the pc after
+/// the fragment.
+uint32_t JITImpl::
+emitFragmentBody(JITCacheInfo &cacheInfo, JITFunctionInfo *info,
+                 uint32_t startPc,
+                 const std::vector<InstructionOpcode> &opcode,
+                 const std::vector<Operands> &operands,
+                 std::queue<std::pair<uint32_t,MemoryCheck>> &checks)
+{
+  bool promoteRegisters = promotedRegs != nullptr;
   uint32_t pc = startPc;
   bool needsReturn = true;
   for (unsigned i = 0, e = opcode.size(); i != e; ++i) {
@@ -638,7 +946,7 @@ compileOneFragment(Core &core, JITCoreInfo &coreInfo, uint32_t startPc,
     LLVMValueRef callee = LLVMGetNamedFunction(module, properties->function);
     assert(callee && "Function for instruction not found in module");
     LLVMTypeRef calleeType = LLVMGetElementType(LLVMTypeOf(callee));
-    const unsigned fixedArgs = 4;
+    const unsigned fixedArgs = 5;
     const unsigned maxOperands = 6;
     unsigned numArgs = properties->getNumExplicitOperands() + fixedArgs;
     assert(LLVMCountParamTypes(calleeType) == numArgs);
@@ -649,16 +957,29 @@ compileOneFragment(Core &core, JITCoreInfo &coreInfo, uint32_t startPc,
     LLVMValueRef args[fixedArgs + maxOperands];
     args[0] = threadParam;
     args[1] = LLVMConstInt(paramTypes[1], nextPc, false);
-    args[2] = ramBase;
+    args[2] = ramBaseParam;
     args[3] = ramSizeLog2Param;
+    bool promoted = promoteRegisters && canPromoteRegisters(*properties, ops);
+    if (promoted) {
+      args[4] = promotedRegs;
+      dirtyRegs |= getRegistersWritten(*properties, ops);
+    } else {
+      if (promoteRegisters) {
+        writeBackDirtyRegisters();
+        dirtyRegs = 0;
+      }
+      args[4] = threadRegs;
+    }
     for (unsigned i = fixedArgs; i < numArgs; i++) {
       uint32_t value = ops.ops[i - fixedArgs];
       args[i] = LLVMConstInt(paramTypes[i], value, false);
     }
     LLVMValueRef call = emitCallToBeInlined(callee, args, numArgs);
     checkReturnValue(call, *properties);
+    if (promoteRegisters && !promoted)
+      loadPromotedRegisters();
     if (properties->mayBranch() && properties->function &&
-        emitJumpToNextFragment(opc, ops, coreInfo, nextPc, info)) {
+        emitJumpToNextFragment(opc, ops, cacheInfo, nextPc, info)) {
       needsReturn = false;
     }
     pc = nextPc;
@@ -668,12 +989,213 @@ compileOneFragment(Core &core, JITCoreInfo &coreInfo, uint32_t startPc,
     LLVMValueRef args[] = {
       threadParam
     };
+    writeBackDirtyRegisters();
     emitCallToBeInlined(functions.jitUpdateExecutionFrequency, args, 1);
     // Build return.
     LLVMBuildRet(builder,
                  LLVMConstInt(LLVMGetReturnType(jitFunctionType),
                               static_cast<int>(InstReturn::CONTINUE), 0));
   }
+  return pc;
+}
+
+/// Emit a fragment that branches back to its start. The back edge branches
+/// within the function instead of calling the fragment again. If there are
+/// memory checks that can be hoisted out of the loop the number of iterations
+/// for which they pass is computed at the start of the loop and a copy of the
+/// body without these checks is run for that many iterations. Otherwise, or
+/// once the iterations run out, the body with all checks is used.
+void JITImpl::
+emitLoop(JITCacheInfo &cacheInfo, JITFunctionInfo *info, uint32_t startPc,
+         const std::vector<InstructionOpcode> &opcode,
+         const std::vector<Operands> &operands,
+         std::queue<std::pair<uint32_t,MemoryCheck>> &checks,
+         std::queue<std::pair<uint32_t,MemoryCheck>> &loopBodyChecks,
+         const std::vector<LoopMemoryCheck> &loopChecks)
+{
+  // Registers modified in one iteration may be modified on entry to the body.
+  uint32_t loopDirtyRegs = 0;
+  if (promotedRegs) {
+    for (unsigned i = 0, e = opcode.size(); i != e; ++i) {
+      loopDirtyRegs |= getRegistersWritten(instructionProperties[opcode[i]],
+                                           operands[i]);
+    }
+    loopDirtyRegs &= (1 << numPromotedRegisters) - 1;
+  }
+  LLVMBasicBlockRef headerBB = appendBBToCurrentFunction("loop");
+  LLVMBuildBr(builder, headerBB);
+  LLVMPositionBuilderAtEnd(builder, headerBB);
+  loopPc = startPc;
+  dirtyRegs = loopDirtyRegs;
+  if (loopChecks.empty()) {
+    loopBB = headerBB;
+    emitFragmentBody(cacheInfo, info, startPc, opcode, operands, checks);
+    return;
+  }
+  // Compute the number of iterations for which the hoisted checks pass.
+  LLVMTypeRef paramTypes[7];
+  LLVMGetParamTypes(
+    LLVMGetElementType(LLVMTypeOf(functions.jitGetLoopIterations)),
+    paramTypes);
+  LLVMValueRef iterations =
+    LLVMConstInt(paramTypes[6], maxLoopIterationsPerCheck, false);
+  for (const LoopMemoryCheck &loopCheck : loopChecks) {
+    const MemoryCheck &check = loopCheck.getMemoryCheck();
+    LLVMValueRef args[] = {
+      threadParam,
+      ramSizeLog2Param,
+      emitComputeAddress(check),
+      LLVMConstInt(paramTypes[3], check.getSize(), false),
+      LLVMConstInt(paramTypes[4], loopCheck.getStep(), true),
+      LLVMConstInt(paramTypes[5], check.getFlags(), false),
+      iterations
+    };
+    iterations = emitCallToBeInlined(functions.jitGetLoopIterations, args, 7);
+  }
+  LLVMBasicBlockRef checkedBB = LLVMGetInsertBlock(builder);
+  LLVMBasicBlockRef fastBB = appendBBToCurrentFunction("loop_fast");
+  LLVMBasicBlockRef slowBB = appendBBToCurrentFunction("loop_slow");
+  LLVMBasicBlockRef latchBB = appendBBToCurrentFunction("loop_latch");
+  LLVMValueRef zero = LLVMConstInt(LLVMTypeOf(iterations), 0, false);
+  LLVMValueRef cmp = LLVMBuildICmp(builder, LLVMIntEQ, iterations, zero, "");
+  LLVMBuildCondBr(builder, cmp, slowBB, fastBB);
+  // Body without the hoisted checks.
+  LLVMPositionBuilderAtEnd(builder, fastBB);
+  LLVMValueRef remaining = LLVMBuildPhi(builder, LLVMTypeOf(iterations), "");
+  loopBB = latchBB;
+  emitFragmentBody(cacheInfo, info, startPc, opcode, operands,
+                   loopBodyChecks);
+  LLVMPositionBuilderAtEnd(builder, latchBB);
+  LLVMValueRef nextRemaining =
+    LLVMBuildSub(builder, remaining,
+                 LLVMConstInt(LLVMTypeOf(iterations), 1, false), "");
+  cmp = LLVMBuildICmp(builder, LLVMIntNE, nextRemaining, zero, "");
+  LLVMBuildCondBr(builder, cmp, fastBB, headerBB);
+  LLVMValueRef incomingValues[] = { iterations, nextRemaining };
+  LLVMBasicBlockRef incomingBlocks[] = { checkedBB, latchBB };
+  LLVMAddIncoming(remaining, incomingValues, incomingBlocks, 2);
+  // Body with all checks.
+  LLVMPositionBuilderAtEnd(builder, slowBB);
+  loopBB = headerBB;
+  dirtyRegs = loopDirtyRegs;
+  emitFragmentBody(cacheInfo, info, startPc, opcode, operands, checks);
+}
+
+/// Try and compile a fragment starting at the specified address. Returns
+/// true if successful setting \a nextAddress to the first instruction after
+/// the fragment. If unsuccessful returns false and sets \a nextAddress to the
+/// address after the current function. \a endOfBlock is set to true if the
+/// next address is in a new basic block.
+bool JITImpl::
+compileOneFragment(Core &core, DecodeCache::State &cache,
+                   JITCacheInfo &cacheInfo, uint32_t startPc,
+                   bool &endOfBlock, uint32_t &pcAfterFragment)
+{
+  assert(initialized);
+  resetPerFunctionState();
+
+  auto infoIt = cacheInfo.functionMap.find(startPc);
+  JITFunctionInfo *info =
+    (infoIt == cacheInfo.functionMap.end()) ? 0 : infoIt->second;
+  if (info && info->fastFuncValue) {
+    endOfBlock = true;
+    return false;
+  }
+
+  std::vector<InstructionOpcode> opcode;
+  std::vector<Operands> operands;
+  if (!getFragmentToCompile(core, cache, cache.fromPc(startPc), opcode,
+                            operands, endOfBlock, pcAfterFragment)) {
+    pcAfterFragment = cache.toPc(pcAfterFragment);
+    return false;
+  }
+  std::queue<std::pair<uint32_t,MemoryCheck>> checks;
+  placeMemoryChecks(opcode, operands, checks);
+  std::queue<std::pair<uint32_t,MemoryCheck>> loopBodyChecks;
+  std::vector<LoopMemoryCheck> loopChecks;
+  bool isLoop = isLoopFragment(startPc, opcode, operands);
+  if (isLoop)
+    placeLoopMemoryChecks(opcode, operands, loopBodyChecks, loopChecks);
+
+  if (info) {
+    info->func = 0;
+  } else {
+    info = new JITFunctionInfo(startPc);
+    cacheInfo.functionMap.insert(std::make_pair(startPc, info));
+  }
+  // Create function to contain the code we are about to add.
+  LLVMValueRef f = LLVMAddFunction(module, "", jitFunctionType);
+  LLVMSetFunctionCallConv(f, LLVMFastCallConv);
+  info->fastFuncValue = f;
+  threadParam = LLVMGetParam(f, 0);
+  LLVMBasicBlockRef entryBB =
+    LLVMAppendBasicBlockInContext(context, f, "entry");
+  LLVMPositionBuilderAtEnd(builder, entryBB);
+  if (cacheSize != 0)
+    emitSetReferenced(*info);
+  if (cacheInfo.coreSpecific) {
+    ramBaseParam =
+      LLVMConstInt(LLVMInt32TypeInContext(context), core.getRamBase(), false);
+    ramSizeLog2Param =
+      LLVMConstInt(LLVMInt32TypeInContext(context), core.getRamSizeLog2(),
+                   false);
+  } else {
+    // Shared code must read the RAM configuration of the executing core.
+    LLVMValueRef args[] = {
+      threadParam
+    };
+    ramBaseParam = emitCallToBeInlined(functions.jitGetRamBase, args, 1);
+    ramSizeLog2Param = emitCallToBeInlined(functions.jitGetRamSizeLog2, args,
+                                           1);
+  }
+  {
+    LLVMValueRef args[] = {
+      threadParam
+    };
+    threadRegs = emitCallToBeInlined(functions.jitGetRegisters, args, 1);
+  }
+  // Keep registers in a local copy of the register file so they can be
+  // promoted to SSA values.
+  bool promoteRegisters = false;
+  for (unsigned i = 0, e = opcode.size(); i != e; ++i) {
+    if (canPromoteRegisters(instructionProperties[opcode[i]], operands[i])) {
+      promoteRegisters = true;
+      break;
+    }
+  }
+  if (promoteRegisters) {
+    LLVMTypeRef int32Type = LLVMInt32TypeInContext(context);
+    LLVMValueRef alloca =
+      LLVMBuildAlloca(builder, LLVMArrayType(int32Type, numPromotedRegisters),
+                      "");
+    LLVMValueRef indices[] = {
+      LLVMConstInt(int32Type, 0, false),
+      LLVMConstInt(int32Type, 0, false)
+    };
+    promotedRegs = LLVMBuildInBoundsGEP(builder, alloca, indices, 2, "");
+    // Pending register writes in dual issue mode are applied to the thread's
+    // register file so interpret the instruction instead.
+    LLVMValueRef args[] = {
+      threadParam
+    };
+    LLVMValueRef isDualIssue =
+      emitCallToBeInlined(functions.jitIsDualIssue, args, 1);
+    LLVMValueRef cmp =
+      LLVMBuildICmp(builder, LLVMIntNE, isDualIssue,
+                    LLVMConstInt(LLVMTypeOf(isDualIssue), 0, false), "");
+    emitCondBrToBlock(cmp, getOrCreateMemoryCheckBailoutBlock(0));
+    loadPromotedRegisters();
+  }
+  uint32_t pc;
+  if (isLoop) {
+    emitLoop(cacheInfo, info, startPc, opcode, operands, checks, loopBodyChecks,
+             loopChecks);
+    pc = startPc;
+    for (InstructionOpcode opc : opcode)
+      pc += instructionProperties[opc].size / 2;
+  } else {
+    pc = emitFragmentBody(cacheInfo, info, startPc, opcode, operands, checks);
+  }
   // Add incoming phi values.
   if (earlyReturnBB) {
     LLVMAddIncoming(earlyReturnPhi, &earlyReturnIncomingValues[0],
@@ -692,6 +1214,7 @@ compileOneFragment(Core &core, JITCoreInfo &coreInfo, uint32_t startPc,
   if (DEBUG_JIT) {
     LLVMDumpValue(f);
   }
+  info->codeSize = estimateCodeSize(f);
   // Compile.
   InstFunctionFast_t compiledFunction =
     reinterpret_cast<InstFunctionFast_t>(
@@ -705,7 +1228,8 @@ compileOneFragment(Core &core, JITCoreInfo &coreInfo, uint32_t startPc,
     *reinterpret_cast<InstFunctionFast_t*>(
       LLVMGetPointerToGlobal(executionEngine, info->ptr)) = info->fastFunc;
   }
-  core.setOpcode(startPc, info->func, (pc - startPc) * 2);
+  cache.setOpcode(startPc, info->func, (pc - startPc) * 2);
+  addToLRU(cacheInfo, *info);
   return true;
 }
 
@@ -720,16 +1244,17 @@ void JITImpl::emitCondBrToBlock(LLVMValueRef cond, LLVMBasicBlockRef trueBB)
 LLVMBasicBlockRef JITImpl::getOrCreateMemoryCheckBailoutBlock(unsigned index)
 {
   if (index == 0) {
-    if (interpretOneBB) {
+    if (interpretOneBB && interpretOneDirtyRegs == dirtyRegs) {
       return interpretOneBB;
     }
-  } else if (endTraceBB) {
+  } else if (endTraceBB && endTraceDirtyRegs == dirtyRegs) {
     return endTraceBB;
   }
   LLVMBasicBlockRef savedInsertPoint = LLVMGetInsertBlock(builder);
   LLVMBasicBlockRef bailoutBB =
     LLVMAppendBasicBlockInContext(context, getCurrentFunction(), "");
   LLVMPositionBuilderAtEnd(builder, bailoutBB);
+  writeBackDirtyRegisters();
   if (index == 0) {
     LLVMValueRef args[] = {
       threadParam
@@ -737,6 +1262,7 @@ LLVMBasicBlockRef JITImpl::getOrCreateMemoryCheckBailoutBlock(unsigned index)
     LLVMValueRef call = emitCallToBeInlined(functions.jitInterpretOne, args, 1);
     LLVMBuildRet(builder, call);
     interpretOneBB = bailoutBB;
+    interpretOneDirtyRegs = dirtyRegs;
   } else {
     ensureEarlyReturnBB(LLVMGetReturnType(jitFunctionType));
     earlyReturnIncomingValues.push_back(
@@ -745,11 +1271,31 @@ LLVMBasicBlockRef JITImpl::getOrCreateMemoryCheckBailoutBlock(unsigned index)
     earlyReturnIncomingBlocks.push_back(LLVMGetInsertBlock(builder));
     LLVMBuildBr(builder, earlyReturnBB);
     endTraceBB = bailoutBB;
+    endTraceDirtyRegs = dirtyRegs;
   }
   LLVMPositionBuilderAtEnd(builder, savedInsertPoint);
   return bailoutBB;
 }
 
+LLVMValueRef JITImpl::emitComputeAddress(const MemoryCheck &check)
+{
+  LLVMTypeRef paramTypes[5];
+  LLVMGetParamTypes(LLVMGetElementType(LLVMTypeOf(functions.jitComputeAddress)),
+                    paramTypes);
+  assert(!promotedRegs ||
+         (check.getBaseReg() < numPromotedRegisters &&
+          (check.getScale() == 0 ||
+           check.getOffsetReg() < numPromotedRegisters)));
+  LLVMValueRef args[] = {
+    promotedRegs ? promotedRegs : threadRegs,
+    LLVMConstInt(paramTypes[1], check.getBaseReg(), false),
+    LLVMConstInt(paramTypes[2], check.getScale(), false),
+    LLVMConstInt(paramTypes[3], check.getOffsetReg(), false),
+    LLVMConstInt(paramTypes[4], check.getOffsetImm(), false)
+  };
+  return emitCallToBeInlined(functions.jitComputeAddress, args, 5);
+}
+
 void JITImpl::
 emitMemoryChecks(unsigned index,
                  std::queue<std::pair<uint32_t,MemoryCheck>> &checks)
@@ -758,21 +1304,7 @@ emitMemoryChecks(unsigned index,
     const auto check = checks.front().second;
     checks.pop();
     LLVMBasicBlockRef bailoutBB = getOrCreateMemoryCheckBailoutBlock(index);
-    // Compute address.
-    LLVMValueRef address;
-    {
-      LLVMTypeRef paramTypes[5];
-      LLVMGetParamTypes(LLVMGetElementType(LLVMTypeOf(functions.jitComputeAddress)),
-                        paramTypes);
-      LLVMValueRef args[] = {
-        threadParam,
-        LLVMConstInt(paramTypes[1], check.getBaseReg(), false),
-        LLVMConstInt(paramTypes[2], check.getScale(), false),
-        LLVMConstInt(paramTypes[3], check.getOffsetReg(), false),
-        LLVMConstInt(paramTypes[4], check.getOffsetImm(), false)
-      };
-      address = emitCallToBeInlined(functions.jitComputeAddress, args, 5);
-    }
+    LLVMValueRef address = emitComputeAddress(check);
     // Check alignment.
     if (check.getFlags() & MemoryCheck::CheckAlignment &&
         check.getSize() > 1) {
@@ -857,11 +1389,11 @@ LLVMValueRef JITImpl::getFunctionThunk(LLVMValueRef f)
 
 bool JITImpl::invalidate(Core &core, uint32_t pc)
 {
-  JITCoreInfo *coreInfo = getJITCoreInfo(core);
-  if (!coreInfo)
+  JITCacheInfo *cacheInfo = getJITCacheInfo(core.getRamDecodeCache());
+  if (!cacheInfo)
     return false;
-  auto entry = coreInfo->functionMap.find(pc);
-  if (entry == coreInfo->functionMap.end())
+  auto entry = cacheInfo->functionMap.find(pc);
+  if (entry == cacheInfo->functionMap.end())
     return false;
   JITFunctionInfo *funcInfo = entry->second;
   uint32_t functionPc = funcInfo->pc;
@@ -869,10 +1401,28 @@ bool JITImpl::invalidate(Core &core, uint32_t pc)
   // Don't remove the function yet since we might be invalidating it from inside
   // the function itself. Instead add the function to a list of functions to
   // clean up later.
-  coreInfo->unreachableFunctions.push_back(functionPc);
+  cacheInfo->unreachableFunctions.push_back(functionPc);
   return true;
 }
 
+bool JITImpl::invalidateRange(Core &core, uint32_t beginPc, uint32_t endPc)
+{
+  JITCacheInfo *cacheInfo = getJITCacheInfo(core.getRamDecodeCache());
+  if (!cacheInfo)
+    return false;
+  bool invalidated = false;
+  auto &functionMap = cacheInfo->functionMap;
+  for (auto it = functionMap.lower_bound(beginPc), e = functionMap.end();
+       it != e && it->first < endPc; ++it) {
+    uint32_t functionPc = it->second->pc;
+    core.clearOpcode(functionPc);
+    // As above the function is cleaned up later.
+    cacheInfo->unreachableFunctions.push_back(functionPc);
+    invalidated = true;
+  }
+  return invalidated;
+}
+
 #else
 
 using namespace axe;
@@ -881,8 +1431,15 @@ class axe::JITImpl {
 public:
   static void initializeGlobalState() {}
   void init() {}
-  void compileBlock(Core &core, uint32_t pc) {}
+  void compileBlock(Core &core, DecodeCache::State &cache, uint32_t pc) {}
   bool invalidate(Core &core, uint32_t pc) { return false; }
+  bool invalidateRange(Core &core, uint32_t beginPc, uint32_t endPc) {
+    return false;
+  }
+  void setCacheSize(uint64_t bytes) {}
+  uint64_t getCacheSize() const { return 0; }
+  uint64_t getCacheUsage() const { return 0; }
+  uint64_t getNumEvictions() const { return 0; }
 };
 
 #endif
@@ -900,12 +1457,37 @@ void JIT::initializeGlobalState()
   JITImpl::initializeGlobalState();
 }
 
-void JIT::compileBlock(Core &core, uint32_t pc)
+void JIT::compileBlock(Core &core, DecodeCache::State &cache, uint32_t pc)
 {
-  return pImpl->compileBlock(core, pc);
+  return pImpl->compileBlock(core, cache, pc);
 }
 
 bool JIT::invalidate(Core &core, uint32_t pc)
 {
   return pImpl->invalidate(core, pc);
 }
+
+bool JIT::invalidateRange(Core &core, uint32_t beginPc, uint32_t endPc)
+{
+  return pImpl->invalidateRange(core, beginPc, endPc);
+}
+
+void JIT::setCacheSize(uint64_t bytes)
+{
+  pImpl->setCacheSize(bytes);
+}
+
+uint64_t JIT::getCacheSize() const
+{
+  return pImpl->getCacheSize();
+}
+
+uint64_t JIT::getCacheUsage() const
+{
+  return pImpl->getCacheUsage();
+}
+
+uint64_t JIT::getNumEvictions() const
+{
+  return pImpl->getNumEvictions();
+}
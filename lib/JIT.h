@@ -7,6 +7,7 @@
 #define _JIT_h_
 
 #include <stdint.h>
+#include "DecodeCache.h"
 
 namespace axe {
 
@@ -24,8 +25,23 @@ public:
   /// when the JIT is first used but in a multi-threaded applications it should
   /// be preallocated to avoid race conditions.
   static void initializeGlobalState();
-  void compileBlock(Core &c, uint32_t pc);
+  /// Compile the block starting at the specified pc of the decode cache. The
+  /// decode cache may be the RAM of the core or a read-only region such as the
+  /// ROM, in which case the compiled code is shared by all cores.
+  void compileBlock(Core &c, DecodeCache::State &cache, uint32_t pc);
   bool invalidate(Core &c, uint32_t pc);
+  /// Invalidate all compiled functions that start in the range of pcs
+  /// [beginPc, endPc) of the core's RAM decode cache.
+  bool invalidateRange(Core &c, uint32_t beginPc, uint32_t endPc);
+  /// Limit the size of the generated code to approximately the specified
+  /// number of bytes. Least recently used code is evicted when the limit is
+  /// exceeded. A size of 0 means no limit.
+  void setCacheSize(uint64_t bytes);
+  uint64_t getCacheSize() const;
+  /// Returns the approximate size in bytes of the generated code.
+  uint64_t getCacheUsage() const;
+  /// Returns the number of compiled fragments evicted due to the size limit.
+  uint64_t getNumEvictions() const;
 };
   
 } // End axe namespace
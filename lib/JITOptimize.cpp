@@ -38,7 +38,7 @@ public:
 
   MemoryAccess &addRegisterOffset(unsigned s, Register::Reg r) {
     assert(scale == 0);
-    (void)scale;
+    scale = s;
     offsetReg = r;
     // Canonicalise.
     if (scale == 1 && offsetReg < baseReg)
@@ -51,7 +51,7 @@ public:
   }
   Register::Reg getBaseReg() const { return baseReg; }
   unsigned getScale() const { return scale; }
-  Register::Reg getOffsetReg() const { return baseReg; }
+  Register::Reg getOffsetReg() const { return offsetReg; }
   uint32_t getOffsetImm() const { return offsetImm; }
   unsigned getSize() const { return size; }
   bool getIsStore() const { return isStore; }
@@ -225,14 +225,13 @@ update(InstructionOpcode opc, const Operands &ops, unsigned nextOffset)
   }
 }
 
-void axe::
-placeMemoryChecks(std::vector<InstructionOpcode> &opcode,
-                  std::vector<Operands> &operands,
-                  std::queue<std::pair<uint32_t,MemoryCheck>> &checks)
+static void
+getMemoryCheckCandidates(const std::vector<InstructionOpcode> &opcode,
+                         const std::vector<Operands> &operands,
+                         std::vector<MemoryCheckCandidate> &candidates)
 {
   MemoryCheckState state;
 
-  std::vector<MemoryCheckCandidate> candidates;
   // Gather expressions for memory accesses.
   for (unsigned i = 0, e = opcode.size(); i != e; ++i) {
     InstructionOpcode opc = opcode[i];
@@ -271,11 +270,122 @@ placeMemoryChecks(std::vector<InstructionOpcode> &opcode,
     // Update regDefs.
     state.update(opc, ops, i + 1);
   }
-  if (candidates.empty())
-    return;
+}
 
+void axe::
+placeMemoryChecks(std::vector<InstructionOpcode> &opcode,
+                  std::vector<Operands> &operands,
+                  std::queue<std::pair<uint32_t,MemoryCheck>> &checks)
+{
+  std::vector<MemoryCheckCandidate> candidates;
+  getMemoryCheckCandidates(opcode, operands, candidates);
   for (unsigned index = 0, size = candidates.size(); index < size; index++) {
     checks.push(std::make_pair(candidates[index].getInstructionIndex(),
                                candidates[index].getMemoryCheck()));
   }
 }
+
+/// If the instruction adds a constant to a register and writes the result
+/// back to the same register set \a reg and \a delta and return true.
+static bool
+getInductionUpdate(InstructionOpcode opc, const Operands &ops,
+                   Register::Reg &reg, int32_t &delta)
+{
+  switch (opc) {
+  default:
+    return false;
+  case ADD_2rus:
+    if (ops.ops[0] != ops.ops[1])
+      return false;
+    reg = static_cast<Register::Reg>(ops.ops[0]);
+    delta = ops.ops[2];
+    return true;
+  case SUB_2rus:
+    if (ops.ops[0] != ops.ops[1])
+      return false;
+    reg = static_cast<Register::Reg>(ops.ops[0]);
+    delta = -static_cast<int32_t>(ops.ops[2]);
+    return true;
+  }
+}
+
+struct InductionState {
+  /// Whether the register only changes by constant amounts in the loop.
+  std::array<bool, Register::NUM_REGISTERS> isInduction;
+  /// Change to the register since the start of the iteration.
+  std::array<int32_t, Register::NUM_REGISTERS> delta;
+
+  InductionState() {
+    isInduction.fill(true);
+    delta.fill(0);
+  }
+
+  void update(InstructionOpcode opc, const Operands &ops);
+};
+
+void InductionState::update(InstructionOpcode opc, const Operands &ops)
+{
+  Register::Reg reg;
+  int32_t value;
+  if (getInductionUpdate(opc, ops, reg, value)) {
+    delta.at(reg) += value;
+    return;
+  }
+  const InstructionProperties &properties = instructionProperties[opc];
+  for (unsigned i = 0, e = properties.getNumOperands(); i != e; ++i) {
+    if (!isDef(properties.getOperandType(i)))
+      continue;
+    isInduction.at(getRegister(properties, ops, i)) = false;
+  }
+}
+
+void axe::
+placeLoopMemoryChecks(std::vector<InstructionOpcode> &opcode,
+                      std::vector<Operands> &operands,
+                      std::queue<std::pair<uint32_t,MemoryCheck>> &checks,
+                      std::vector<LoopMemoryCheck> &loopChecks)
+{
+  std::vector<MemoryCheckCandidate> candidates;
+  getMemoryCheckCandidates(opcode, operands, candidates);
+  // Find the change in each register over one iteration of the loop.
+  InductionState loopState;
+  bool canHoist = true;
+  for (unsigned i = 0, e = opcode.size(); i != e; ++i) {
+    // Instructions that access the thread state may write registers that
+    // aren't operands.
+    if (instructionProperties[opcode[i]].mayAccessThreadState())
+      canHoist = false;
+    loopState.update(opcode[i], operands[i]);
+  }
+  InductionState state;
+  unsigned nextCandidate = 0;
+  for (unsigned i = 0, e = opcode.size(); i != e; ++i) {
+    for (; nextCandidate != candidates.size() &&
+         candidates[nextCandidate].getInstructionIndex() == i;
+         ++nextCandidate) {
+      MemoryCheck check = candidates[nextCandidate].getMemoryCheck();
+      Register::Reg base = check.getBaseReg();
+      Register::Reg offset = check.getOffsetReg();
+      unsigned scale = check.getScale();
+      bool hoist = canHoist && loopState.isInduction.at(base) &&
+                   (scale == 0 || loopState.isInduction.at(offset));
+      int32_t step = loopState.delta.at(base);
+      uint32_t offsetImm = check.getOffsetImm() + state.delta.at(base);
+      if (scale != 0) {
+        step += scale * loopState.delta.at(offset);
+        offsetImm += scale * state.delta.at(offset);
+      }
+      if ((check.getFlags() & MemoryCheck::CheckAlignment) &&
+          step % static_cast<int32_t>(check.getSize()) != 0)
+        hoist = false;
+      if (hoist) {
+        loopChecks.push_back(
+          LoopMemoryCheck(MemoryCheck(check.getSize(), base, scale, offset,
+                                      offsetImm, check.getFlags()), step));
+      } else {
+        checks.push(std::make_pair(i, check));
+      }
+    }
+    state.update(opcode[i], operands[i]);
+  }
+}
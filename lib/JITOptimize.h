@@ -48,9 +48,31 @@ public:
   unsigned getFlags() const { return flags; }
 };
 
+/// A memory check for an access in a loop. The address of the access in the
+/// first iteration is computed from the registers at the start of the loop
+/// and the address changes by a constant step each iteration.
+class LoopMemoryCheck {
+  MemoryCheck check;
+  int32_t step;
+public:
+  LoopMemoryCheck(const MemoryCheck &c, int32_t s) : check(c), step(s) {}
+
+  const MemoryCheck &getMemoryCheck() const { return check; }
+  int32_t getStep() const { return step; }
+};
+
 void placeMemoryChecks(std::vector<InstructionOpcode> &opcode,
                        std::vector<Operands> &operands,
                        std::queue<std::pair<uint32_t,MemoryCheck>> &checks);
+
+/// Place memory checks for a fragment that branches back to its start. The
+/// checks for accesses whose address changes by a constant amount each
+/// iteration are added to \a loopChecks so they can be checked for a number
+/// of iterations at once. The remaining checks are added to \a checks.
+void placeLoopMemoryChecks(std::vector<InstructionOpcode> &opcode,
+                           std::vector<Operands> &operands,
+                           std::queue<std::pair<uint32_t,MemoryCheck>> &checks,
+                           std::vector<LoopMemoryCheck> &loopChecks);
   
 } // End axe namespace
 
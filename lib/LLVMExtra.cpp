@@ -8,6 +8,7 @@
 #include "llvm-c/Target.h"
 #include "llvm/ExecutionEngine/ExecutionEngine.h"
 #include "llvm/ExecutionEngine/JITEventListener.h"
+#include "llvm/IR/GlobalVariable.h"
 #include "llvm/Support/CallSite.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Transforms/Utils/Cloning.h"
@@ -66,3 +67,10 @@ void LLVMDisableSymbolSearching(LLVMExecutionEngineRef EE, LLVMBool Disable)
 {
   unwrap(EE)->DisableSymbolSearching(Disable);
 }
+
+void LLVMExtraDeleteGlobal(LLVMExecutionEngineRef EE, LLVMValueRef Global)
+{
+  GlobalVariable *GV = unwrap<GlobalVariable>(Global);
+  unwrap(EE)->updateGlobalMapping(GV, 0);
+  GV->eraseFromParent();
+}
@@ -20,6 +20,8 @@ void LLVMExtraRegisterJitDisassembler(LLVMExecutionEngineRef EE,
 
 void LLVMDisableSymbolSearching(LLVMExecutionEngineRef EE, LLVMBool Disable);
 
+void LLVMExtraDeleteGlobal(LLVMExecutionEngineRef EE, LLVMValueRef Global);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
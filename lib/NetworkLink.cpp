@@ -4,9 +4,55 @@
 // LICENSE.txt and at <http://github.xcore.com/>
 
 #include "NetworkLink.h"
+#include <cstring>
 
 using namespace axe;
 
 NetworkLink::~NetworkLink()
 {
 }
+
+NetworkLinkBatched::NetworkLinkBatched() :
+  numTxFrames(0),
+  numRxFrames(0),
+  rxIndex(0),
+  pollCount(0)
+{
+}
+
+void NetworkLinkBatched::flushTx()
+{
+  if (numTxFrames == 0)
+    return;
+  sendFrames(txFrames, numTxFrames);
+  numTxFrames = 0;
+}
+
+void NetworkLinkBatched::
+transmitFrame(const uint8_t *data, unsigned size, ticks_t time)
+{
+  Frame &frame = txFrames[numTxFrames++];
+  frame.size = size;
+  std::memcpy(frame.data, data, size);
+  if (numTxFrames == BATCH_SIZE)
+    flushTx();
+}
+
+bool NetworkLinkBatched::
+receiveFrame(uint8_t *data, unsigned &size, ticks_t time)
+{
+  if (rxIndex == numRxFrames) {
+    if (++pollCount < POLL_INTERVAL)
+      return false;
+    pollCount = 0;
+    flushTx();
+    numRxFrames = receiveFrames(rxFrames, BATCH_SIZE);
+    rxIndex = 0;
+    if (numRxFrames == 0)
+      return false;
+  }
+  const Frame &frame = rxFrames[rxIndex++];
+  size = frame.size;
+  std::memcpy(data, frame.data, size);
+  return true;
+}
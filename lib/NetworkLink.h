@@ -6,6 +6,7 @@
 #ifndef _NetworkLink_h
 #define _NetworkLink_h
 
+#include "Config.h"
 #include <stdint.h>
 #include <memory>
 #include <string>
@@ -16,11 +17,61 @@ class NetworkLink {
 public:
   static const unsigned maxFrameSize = 1500 + 18;
   virtual ~NetworkLink();
-  virtual void transmitFrame(const uint8_t *data, unsigned size) = 0;
-  virtual bool receiveFrame(uint8_t *data, unsigned &size) = 0;
+  virtual void transmitFrame(const uint8_t *data, unsigned size,
+                             ticks_t time) = 0;
+  virtual bool receiveFrame(uint8_t *data, unsigned &size, ticks_t time) = 0;
+};
+
+/// Base class for links which transfer frames in batches. Transmitted frames
+/// are queued and sent when the batch is full or when the link is next
+/// checked for received frames. Received frames are read a batch at a time.
+/// While no frames are waiting the link is only checked every POLL_INTERVAL
+/// calls to receiveFrame().
+class NetworkLinkBatched : public NetworkLink {
+public:
+  enum {
+    BATCH_SIZE = 32,
+    POLL_INTERVAL = 64
+  };
+protected:
+  struct Frame {
+    unsigned size;
+    uint8_t data[maxFrameSize];
+  };
+  /// Send frames to the other end of the link. Frames which can't be sent are
+  /// dropped.
+  virtual void sendFrames(const Frame *frames, unsigned num) = 0;
+  /// Receive up to max frames without blocking. Returns the number of frames
+  /// received.
+  virtual unsigned receiveFrames(Frame *frames, unsigned max) = 0;
+  /// Send any queued frames. sendFrames() can't be called once the derived
+  /// class is destroyed so derived destructors must call this first.
+  void flushTx();
+private:
+  Frame txFrames[BATCH_SIZE];
+  unsigned numTxFrames;
+  Frame rxFrames[BATCH_SIZE];
+  unsigned numRxFrames;
+  unsigned rxIndex;
+  unsigned pollCount;
+public:
+  NetworkLinkBatched();
+  void transmitFrame(const uint8_t *data, unsigned size,
+                     ticks_t time) override;
+  bool receiveFrame(uint8_t *data, unsigned &size, ticks_t time) override;
 };
 
 std::unique_ptr<NetworkLink> createNetworkLinkTap(const std::string &ifname);
+/// Create a link which receives the frames in the pcap file in and writes
+/// transmitted frames to the pcap file out. Either name may be empty.
+std::unique_ptr<NetworkLink> createNetworkLinkPcap(const std::string &in,
+                                                   const std::string &out);
+/// Create a link which sends frames as datagrams from the UNIX domain socket
+/// bound to path to the socket bound to peer.
+std::unique_ptr<NetworkLink> createNetworkLinkUnix(const std::string &path,
+                                                   const std::string &peer);
+/// Create a link to the other user of the POSIX shared memory object name.
+std::unique_ptr<NetworkLink> createNetworkLinkShm(const std::string &name);
   
 } // End axe namespace
 
@@ -0,0 +1,24 @@
+// Copyright (c) 2012, Richard Osborne, All rights reserved
+// This software is freely distributable under a derivative of the
+// University of Illinois/NCSA Open Source License posted in
+// LICENSE.txt and at <http://github.xcore.com/>
+
+#include "NetworkLink.h"
+#include <iostream>
+#include <cstdlib>
+
+using namespace axe;
+
+std::unique_ptr<NetworkLink>
+axe::createNetworkLinkUnix(const std::string &path, const std::string &peer)
+{
+  std::cerr << "Error: unix network link not supported on this platform\n";
+  std::exit(1);
+}
+
+std::unique_ptr<NetworkLink>
+axe::createNetworkLinkShm(const std::string &name)
+{
+  std::cerr << "Error: shm network link not supported on this platform\n";
+  std::exit(1);
+}
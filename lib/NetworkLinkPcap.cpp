@@ -0,0 +1,200 @@
+// Copyright (c) 2012, Richard Osborne, All rights reserved
+// This software is freely distributable under a derivative of the
+// University of Illinois/NCSA Open Source License posted in
+// LICENSE.txt and at <http://github.xcore.com/>
+
+#include "NetworkLink.h"
+#include <fstream>
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+
+using namespace axe;
+
+const uint32_t pcapMagicMicroseconds = 0xa1b2c3d4;
+const uint32_t pcapMagicNanoseconds = 0xa1b23c4d;
+const uint32_t pcapLinkTypeEthernet = 1;
+
+static uint32_t byteSwap(uint32_t value)
+{
+  return (value >> 24) | ((value >> 8) & 0xff00) | ((value << 8) & 0xff0000) |
+         (value << 24);
+}
+
+static uint64_t ticksToNanoseconds(ticks_t time)
+{
+  return time * 10 / CYCLES_PER_TICK;
+}
+
+static ticks_t nanosecondsToTicks(uint64_t ns)
+{
+  return ns * CYCLES_PER_TICK / 10;
+}
+
+/// Replays the frames in a pcap file and records transmitted frames to
+/// another. Received frames are delivered at their timestamp relative to the
+/// first frame in the file. Transmitted frames are written with the simulated
+/// time in nanoseconds.
+class NetworkLinkPcap : public NetworkLink {
+  std::ifstream in;
+  std::ofstream out;
+  bool swapped;
+  bool nanoseconds;
+  /// The next frame to receive, if hasNext is true.
+  bool hasNext;
+  uint8_t nextData[maxFrameSize];
+  unsigned nextSize;
+  ticks_t nextTime;
+  bool hasFirstTimestamp;
+  uint64_t firstTimestamp;
+
+  bool readWord(uint32_t &value);
+  void readHeader(const std::string &name);
+  void writeHeader();
+  void readNext();
+public:
+  NetworkLinkPcap(const std::string &inName, const std::string &outName);
+  void transmitFrame(const uint8_t *data, unsigned size,
+                     ticks_t time) override;
+  bool receiveFrame(uint8_t *data, unsigned &size, ticks_t time) override;
+};
+
+NetworkLinkPcap::
+NetworkLinkPcap(const std::string &inName, const std::string &outName) :
+  swapped(false),
+  nanoseconds(false),
+  hasNext(false),
+  nextSize(0),
+  nextTime(0),
+  hasFirstTimestamp(false),
+  firstTimestamp(0)
+{
+  if (!inName.empty()) {
+    in.open(inName.c_str(), std::ios::in | std::ios::binary);
+    if (!in) {
+      std::cerr << "Error: cannot open \"" << inName << "\"\n";
+      std::exit(1);
+    }
+    readHeader(inName);
+    readNext();
+  }
+  if (!outName.empty()) {
+    out.open(outName.c_str(), std::ios::out | std::ios::binary);
+    if (!out) {
+      std::cerr << "Error: cannot open \"" << outName << "\"\n";
+      std::exit(1);
+    }
+    writeHeader();
+  }
+}
+
+bool NetworkLinkPcap::readWord(uint32_t &value)
+{
+  if (!in.read(reinterpret_cast<char*>(&value), sizeof(value)))
+    return false;
+  if (swapped)
+    value = byteSwap(value);
+  return true;
+}
+
+void NetworkLinkPcap::readHeader(const std::string &name)
+{
+  uint32_t magic;
+  if (!readWord(magic)) {
+    std::cerr << "Error: \"" << name << "\" is not a pcap file\n";
+    std::exit(1);
+  }
+  if (magic == byteSwap(pcapMagicMicroseconds) ||
+      magic == byteSwap(pcapMagicNanoseconds)) {
+    swapped = true;
+    magic = byteSwap(magic);
+  }
+  if (magic != pcapMagicMicroseconds && magic != pcapMagicNanoseconds) {
+    std::cerr << "Error: \"" << name << "\" is not a pcap file\n";
+    std::exit(1);
+  }
+  nanoseconds = magic == pcapMagicNanoseconds;
+  // Version (2 x 16 bits), thiszone, sigfigs, snaplen.
+  uint32_t ignored;
+  for (unsigned i = 0; i < 4; i++)
+    readWord(ignored);
+  uint32_t linkType;
+  if (!readWord(linkType) || linkType != pcapLinkTypeEthernet) {
+    std::cerr << "Error: \"" << name << "\" does not contain Ethernet frames\n";
+    std::exit(1);
+  }
+}
+
+void NetworkLinkPcap::writeHeader()
+{
+  const uint32_t header[] = {
+    pcapMagicNanoseconds,
+    2 | (4 << 16), // Version 2.4
+    0, // thiszone
+    0, // sigfigs
+    maxFrameSize, // snaplen
+    pcapLinkTypeEthernet
+  };
+  out.write(reinterpret_cast<const char*>(header), sizeof(header));
+}
+
+void NetworkLinkPcap::readNext()
+{
+  hasNext = false;
+  while (true) {
+    uint32_t seconds, fraction, capturedSize, originalSize;
+    if (!readWord(seconds) || !readWord(fraction) ||
+        !readWord(capturedSize) || !readWord(originalSize))
+      return;
+    uint64_t timestamp = seconds * UINT64_C(1000000000) +
+                         (nanoseconds ? fraction : fraction * UINT64_C(1000));
+    if (!hasFirstTimestamp) {
+      firstTimestamp = timestamp;
+      hasFirstTimestamp = true;
+    }
+    if (capturedSize > maxFrameSize || capturedSize != originalSize) {
+      // Skip truncated and oversized frames.
+      in.ignore(capturedSize);
+      continue;
+    }
+    if (!in.read(reinterpret_cast<char*>(nextData), capturedSize))
+      return;
+    nextSize = capturedSize;
+    nextTime = timestamp < firstTimestamp ?
+      0 : nanosecondsToTicks(timestamp - firstTimestamp);
+    hasNext = true;
+    return;
+  }
+}
+
+void NetworkLinkPcap::
+transmitFrame(const uint8_t *data, unsigned size, ticks_t time)
+{
+  if (!out.is_open())
+    return;
+  uint64_t ns = ticksToNanoseconds(time);
+  const uint32_t header[] = {
+    static_cast<uint32_t>(ns / 1000000000),
+    static_cast<uint32_t>(ns % 1000000000),
+    size,
+    size
+  };
+  out.write(reinterpret_cast<const char*>(header), sizeof(header));
+  out.write(reinterpret_cast<const char*>(data), size);
+}
+
+bool NetworkLinkPcap::receiveFrame(uint8_t *data, unsigned &size, ticks_t time)
+{
+  if (!hasNext || time < nextTime)
+    return false;
+  std::memcpy(data, nextData, nextSize);
+  size = nextSize;
+  readNext();
+  return true;
+}
+
+std::unique_ptr<NetworkLink>
+axe::createNetworkLinkPcap(const std::string &in, const std::string &out)
+{
+  return std::unique_ptr<NetworkLink>(new NetworkLinkPcap(in, out));
+}
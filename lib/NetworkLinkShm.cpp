@@ -0,0 +1,196 @@
+// Copyright (c) 2012, Richard Osborne, All rights reserved
+// This software is freely distributable under a derivative of the
+// University of Illinois/NCSA Open Source License posted in
+// LICENSE.txt and at <http://github.xcore.com/>
+
+#include "NetworkLink.h"
+#include "axe-c/netlink.h"
+#include <iostream>
+#include <thread>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace axe;
+
+template <typename T> static T loadAcquire(const T &x)
+{
+  return __atomic_load_n(&x, __ATOMIC_ACQUIRE);
+}
+
+template <typename T> static void storeRelease(T &x, T value)
+{
+  __atomic_store_n(&x, value, __ATOMIC_RELEASE);
+}
+
+/// Exchanges frames with another process through a pair of single producer,
+/// single consumer rings in shared memory. See axe-c/netlink.h for the
+/// layout. Each batch of frames publishes the ring index once.
+class NetworkLinkShm : public NetworkLinkBatched {
+  std::string name;
+  AXENetlinkShared *shared;
+  AXENetlinkRing *txRing;
+  AXENetlinkRing *rxRing;
+  bool creator;
+  bool unlinked;
+
+  void map(int fd);
+  bool create();
+  void join();
+protected:
+  void sendFrames(const Frame *frames, unsigned num) override;
+  unsigned receiveFrames(Frame *frames, unsigned max) override;
+public:
+  NetworkLinkShm(const std::string &name);
+  ~NetworkLinkShm();
+};
+
+static_assert(NetworkLink::maxFrameSize <= AXE_NETLINK_MAX_FRAME_SIZE,
+              "Shared memory frames are too small");
+
+NetworkLinkShm::NetworkLinkShm(const std::string &n) :
+  name(n),
+  shared(0),
+  creator(false),
+  unlinked(false)
+{
+  if (create()) {
+    creator = true;
+    txRing = &shared->rings[0];
+    rxRing = &shared->rings[1];
+  } else {
+    join();
+    txRing = &shared->rings[1];
+    rxRing = &shared->rings[0];
+  }
+}
+
+NetworkLinkShm::~NetworkLinkShm()
+{
+  flushTx();
+  if (creator && !unlinked)
+    shm_unlink(name.c_str());
+  munmap(shared, sizeof(*shared));
+}
+
+void NetworkLinkShm::map(int fd)
+{
+  void *p = mmap(0, sizeof(AXENetlinkShared), PROT_READ | PROT_WRITE,
+                 MAP_SHARED, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED) {
+    std::cerr << "Error: failed to map shared memory \"" << name << "\"\n";
+    std::exit(1);
+  }
+  shared = static_cast<AXENetlinkShared*>(p);
+}
+
+bool NetworkLinkShm::create()
+{
+  int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd < 0) {
+    if (errno == EEXIST)
+      return false;
+    std::cerr << "Error: failed to create shared memory \"" << name << "\"\n";
+    std::exit(1);
+  }
+  if (ftruncate(fd, sizeof(AXENetlinkShared)) != 0) {
+    std::cerr << "Error: failed to create shared memory \"" << name << "\"\n";
+    std::exit(1);
+  }
+  map(fd);
+  shared->version = AXE_NETLINK_VERSION;
+  storeRelease<uint32_t>(shared->magic, AXE_NETLINK_MAGIC);
+  return true;
+}
+
+void NetworkLinkShm::join()
+{
+  int fd = shm_open(name.c_str(), O_RDWR, 0);
+  if (fd < 0) {
+    std::cerr << "Error: failed to open shared memory \"" << name << "\"\n";
+    std::exit(1);
+  }
+  // Wait for the creator to size the object before mapping it.
+  const unsigned maxAttempts = 1000;
+  unsigned attempts = 0;
+  struct stat st;
+  while (fstat(fd, &st) == 0 &&
+         static_cast<size_t>(st.st_size) < sizeof(AXENetlinkShared)) {
+    if (++attempts == maxAttempts) {
+      std::cerr << "Error: shared memory \"" << name
+                << "\" was not initialized\n";
+      std::exit(1);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  map(fd);
+  while (loadAcquire(shared->magic) != AXE_NETLINK_MAGIC) {
+    if (++attempts == maxAttempts) {
+      std::cerr << "Error: shared memory \"" << name
+                << "\" was not initialized\n";
+      std::exit(1);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  if (shared->version != AXE_NETLINK_VERSION) {
+    std::cerr << "Error: shared memory \"" << name
+              << "\" has an unsupported version\n";
+    std::exit(1);
+  }
+  if (__atomic_exchange_n(&shared->attached, 1, __ATOMIC_ACQ_REL) != 0) {
+    std::cerr << "Error: shared memory \"" << name << "\" is already in use\n";
+    std::exit(1);
+  }
+}
+
+void NetworkLinkShm::sendFrames(const Frame *frames, unsigned num)
+{
+  uint32_t head = loadAcquire(txRing->head);
+  uint32_t tail = txRing->tail;
+  for (unsigned i = 0; i < num; i++) {
+    if (tail - head == AXE_NETLINK_RING_SIZE) {
+      // The ring is full, drop the remaining frames.
+      break;
+    }
+    AXENetlinkFrame &slot = txRing->frames[tail % AXE_NETLINK_RING_SIZE];
+    slot.size = frames[i].size;
+    std::memcpy(slot.data, frames[i].data, frames[i].size);
+    ++tail;
+  }
+  storeRelease(txRing->tail, tail);
+}
+
+unsigned NetworkLinkShm::receiveFrames(Frame *frames, unsigned max)
+{
+  if (creator && !unlinked && loadAcquire(shared->attached)) {
+    // Both ends have the object mapped so the name is no longer needed.
+    shm_unlink(name.c_str());
+    unlinked = true;
+  }
+  uint32_t head = rxRing->head;
+  uint32_t tail = loadAcquire(rxRing->tail);
+  unsigned num = 0;
+  while (head != tail && num < max) {
+    const AXENetlinkFrame &slot = rxRing->frames[head % AXE_NETLINK_RING_SIZE];
+    unsigned size = slot.size;
+    if (size <= maxFrameSize) {
+      frames[num].size = size;
+      std::memcpy(frames[num].data, slot.data, size);
+      ++num;
+    }
+    ++head;
+  }
+  storeRelease(rxRing->head, head);
+  return num;
+}
+
+std::unique_ptr<NetworkLink>
+axe::createNetworkLinkShm(const std::string &name)
+{
+  return std::unique_ptr<NetworkLink>(new NetworkLinkShm(name));
+}
@@ -25,8 +25,10 @@ class NetworkLinkTap : public NetworkLink {
   int fd;
 public:
   NetworkLinkTap(const std::string &ifname);
-  virtual void transmitFrame(const uint8_t *data, unsigned size) override;
-  virtual bool receiveFrame(uint8_t *data, unsigned &size) override;
+  virtual void transmitFrame(const uint8_t *data, unsigned size,
+                             ticks_t time) override;
+  virtual bool receiveFrame(uint8_t *data, unsigned &size,
+                            ticks_t time) override;
 };
 
 static int tun_alloc(std::string &dev)
@@ -66,7 +68,8 @@ NetworkLinkTap::NetworkLinkTap(const std::string &ifname)
   fcntl(fd, F_SETFL, O_NONBLOCK);
 }
 
-void NetworkLinkTap::transmitFrame(const uint8_t *data, unsigned size)
+void NetworkLinkTap::
+transmitFrame(const uint8_t *data, unsigned size, ticks_t time)
 {
   assert(fd >= 0);
   if (write(fd, data, size) < 0) {
@@ -75,7 +78,7 @@ void NetworkLinkTap::transmitFrame(const uint8_t *data, unsigned size)
   }
 }
 
-bool NetworkLinkTap::receiveFrame(uint8_t *data, unsigned &size)
+bool NetworkLinkTap::receiveFrame(uint8_t *data, unsigned &size, ticks_t time)
 {
   assert(fd >= 0);
   ssize_t nread = read(fd, data, maxFrameSize);
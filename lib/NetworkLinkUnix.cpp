@@ -0,0 +1,189 @@
+// Copyright (c) 2012, Richard Osborne, All rights reserved
+// This software is freely distributable under a derivative of the
+// University of Illinois/NCSA Open Source License posted in
+// LICENSE.txt and at <http://github.xcore.com/>
+
+#include "NetworkLink.h"
+#include <iostream>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace axe;
+
+/// Exchanges frames as datagrams on a UNIX domain socket. Each end binds its
+/// own path and connects to the path of its peer, so no privileges are needed
+/// and either end may be started first. Frames sent while the peer isn't
+/// listening are dropped, as they would be on a real network.
+class NetworkLinkUnix : public NetworkLinkBatched {
+  /// Maximum time to wait for the peer to drain its receive queue.
+  enum { SEND_TIMEOUT_MS = 1 };
+  int fd;
+  std::string path;
+  sockaddr_un peerAddr;
+  bool connected;
+
+  static void makeAddress(sockaddr_un &addr, const std::string &path);
+  bool connectToPeer();
+  /// Send frames to the connected peer, returning the number sent.
+  unsigned sendSome(const Frame *frames, unsigned num);
+protected:
+  void sendFrames(const Frame *frames, unsigned num) override;
+  unsigned receiveFrames(Frame *frames, unsigned max) override;
+public:
+  NetworkLinkUnix(const std::string &path, const std::string &peer);
+  ~NetworkLinkUnix();
+};
+
+void NetworkLinkUnix::makeAddress(sockaddr_un &addr, const std::string &path)
+{
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(addr.sun_path)) {
+    std::cerr << "Error: socket path \"" << path << "\" is too long\n";
+    std::exit(1);
+  }
+  std::strcpy(addr.sun_path, path.c_str());
+}
+
+NetworkLinkUnix::
+NetworkLinkUnix(const std::string &p, const std::string &peer) :
+  path(p),
+  connected(false)
+{
+  sockaddr_un addr;
+  makeAddress(addr, path);
+  makeAddress(peerAddr, peer);
+  fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+  if (fd < 0) {
+    std::cerr << "Error: failed to create socket: " << std::strerror(errno)
+              << '\n';
+    std::exit(1);
+  }
+  // Remove any socket left behind by a previous run.
+  unlink(path.c_str());
+  if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+    std::cerr << "Error: failed to bind socket \"" << path << "\": "
+              << std::strerror(errno) << '\n';
+    std::exit(1);
+  }
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+NetworkLinkUnix::~NetworkLinkUnix()
+{
+  flushTx();
+  close(fd);
+  unlink(path.c_str());
+}
+
+bool NetworkLinkUnix::connectToPeer()
+{
+  // Connecting lets poll() report when the peer's receive queue has space.
+  if (!connected)
+    connected = connect(fd, reinterpret_cast<const sockaddr*>(&peerAddr),
+                        sizeof(peerAddr)) == 0;
+  return connected;
+}
+
+unsigned NetworkLinkUnix::sendSome(const Frame *frames, unsigned num)
+{
+#ifdef __linux__
+  mmsghdr msgs[BATCH_SIZE];
+  iovec iovs[BATCH_SIZE];
+  std::memset(msgs, 0, sizeof(msgs[0]) * num);
+  for (unsigned i = 0; i < num; i++) {
+    iovs[i].iov_base = const_cast<uint8_t*>(frames[i].data);
+    iovs[i].iov_len = frames[i].size;
+    msgs[i].msg_hdr.msg_iov = &iovs[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+  int result = sendmmsg(fd, msgs, num, 0);
+  return result < 0 ? 0 : result;
+#else
+  unsigned sent = 0;
+  while (sent < num &&
+         send(fd, frames[sent].data, frames[sent].size, 0) >= 0) {
+    ++sent;
+  }
+  return sent;
+#endif
+}
+
+void NetworkLinkUnix::sendFrames(const Frame *frames, unsigned num)
+{
+  unsigned sent = 0;
+  while (sent < num) {
+    if (!connectToPeer()) {
+      // The peer isn't listening, drop the frames.
+      return;
+    }
+    unsigned result = sendSome(&frames[sent], num - sent);
+    sent += result;
+    if (result != 0 || errno == EINTR)
+      continue;
+    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      pollfd pfd;
+      pfd.fd = fd;
+      pfd.events = POLLOUT;
+      if (poll(&pfd, 1, SEND_TIMEOUT_MS) > 0)
+        continue;
+      // The peer isn't keeping up, drop the remaining frames.
+      return;
+    } else if (errno == ECONNREFUSED || errno == ENOTCONN) {
+      // The peer has gone away. Try to reconnect for the next batch.
+      connected = false;
+      return;
+    } else {
+      ++sent;
+    }
+  }
+}
+
+unsigned NetworkLinkUnix::receiveFrames(Frame *frames, unsigned max)
+{
+#ifdef __linux__
+  mmsghdr msgs[BATCH_SIZE];
+  iovec iovs[BATCH_SIZE];
+  std::memset(msgs, 0, sizeof(msgs[0]) * max);
+  for (unsigned i = 0; i < max; i++) {
+    iovs[i].iov_base = frames[i].data;
+    iovs[i].iov_len = maxFrameSize;
+    msgs[i].msg_hdr.msg_iov = &iovs[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+  int result = recvmmsg(fd, msgs, max, 0, 0);
+  if (result <= 0)
+    return 0;
+  unsigned num = 0;
+  for (int i = 0; i < result; i++) {
+    if (msgs[i].msg_hdr.msg_flags & MSG_TRUNC)
+      continue;
+    if (num != static_cast<unsigned>(i))
+      std::memcpy(frames[num].data, frames[i].data, msgs[i].msg_len);
+    frames[num++].size = msgs[i].msg_len;
+  }
+  return num;
+#else
+  unsigned num = 0;
+  while (num < max) {
+    ssize_t result = recv(fd, frames[num].data, maxFrameSize, 0);
+    if (result < 0)
+      break;
+    frames[num++].size = result;
+  }
+  return num;
+#endif
+}
+
+std::unique_ptr<NetworkLink>
+axe::createNetworkLinkUnix(const std::string &path, const std::string &peer)
+{
+  return std::unique_ptr<NetworkLink>(new NetworkLinkUnix(path, peer));
+}
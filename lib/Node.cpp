@@ -5,6 +5,8 @@
 
 #include "Node.h"
 #include "BitManip.h"
+#include "XLinkRoute.h"
+#include <algorithm>
 #include <iostream>
 
 using namespace axe;
@@ -18,7 +20,13 @@ XLink::XLink() :
   direction(0),
   // TODO find out defaults.
   interTokenDelay(0),
-  interSymbolDelay(0)
+  interSymbolDelay(0),
+  busyUntil(0),
+  credits(XLINK_BUFFER_SIZE),
+  packetsSent(0),
+  tokensSent(0),
+  busyTime(0),
+  contentionTime(0)
 {
   
 }
@@ -40,6 +48,47 @@ bool XLink::isConnected() const
   return isFiveWire() == otherEnd->isFiveWire();
 }
 
+ticks_t XLink::getTokenTime() const
+{
+  // A token is sent as 2 symbols on a five wire link and 4 symbols on a two
+  // wire link. The delays are in switch clock cycles, which are modelled as
+  // one tick each.
+  unsigned symbols = isFiveWire() ? 2 : 4;
+  return symbols * (interSymbolDelay + 1) + interTokenDelay;
+}
+
+ticks_t XLink::transmitToken(ticks_t time)
+{
+  ticks_t tokenTime = getTokenTime();
+  if (busyUntil > time) {
+    contentionTime += busyUntil - time;
+    time = busyUntil;
+  }
+  busyUntil = time + tokenTime;
+  busyTime += tokenTime;
+  ++tokensSent;
+  return busyUntil;
+}
+
+void XLink::returnCredit(ticks_t time, unsigned tokens)
+{
+  credits += tokens;
+  if (creditWaiters.empty())
+    return;
+  std::vector<XLinkRoute*> waiters;
+  std::swap(waiters, creditWaiters);
+  for (XLinkRoute *route : waiters) {
+    route->notifyCreditReturned(time);
+  }
+}
+
+void XLink::waitForCredit(XLinkRoute *route)
+{
+  if (std::find(creditWaiters.begin(), creditWaiters.end(), route) ==
+      creditWaiters.end())
+    creditWaiters.push_back(route);
+}
+
 Node::Node(Type t, unsigned numXLinks) :
   type(t),
   jtagIndex(0),
@@ -97,7 +146,8 @@ void Node::finalize()
   sswitch.initRegisters();
 }
 
-ChanEndpoint *Node::getIncomingChanendDest(ResourceID ID)
+ChanEndpoint *Node::getIncomingChanendDest(ResourceID ID,
+                                           std::vector<XLink*> *route)
 {
   Node *node = this;
   // Use Brent's algorithm to detect cycles.
@@ -118,6 +168,8 @@ ChanEndpoint *Node::getIncomingChanendDest(ResourceID ID)
     XLink *xLink = node->getXLinkForDirection(direction);
     if (!xLink || !xLink->isConnected())
       return 0;
+    if (route)
+      route->push_back(xLink);
     node = xLink->destNode;
     ++hops;
     // Junk message if a cycle is detected.
@@ -134,9 +186,21 @@ ChanEndpoint *Node::getIncomingChanendDest(ResourceID ID)
   return node->getLocalChanendDest(ID);
 }
 
-ChanEndpoint *Node::getOutgoingChanendDest(ResourceID ID)
+ChanEndpoint *Node::
+getOutgoingChanendDest(ResourceID ID, std::vector<XLink*> *route)
+{
+  return getIncomingChanendDest(ID, route);
+}
+
+void Node::countPacketSent(ResourceID ID)
 {
-  return getIncomingChanendDest(ID);
+  if (isProcessorNode() &&
+      ((ID.node() ^ getNodeID()) >> getNonNodeNumberBits()) == 0)
+    return;
+  packetRoute.clear();
+  getOutgoingChanendDest(ID, &packetRoute);
+  for (XLink *xLink : packetRoute)
+    ++xLink->packetsSent;
 }
 
 bool Node::hasMatchingNodeID(ResourceID ID)
@@ -18,6 +18,7 @@ class SystemState;
 
 class Node;
 class ProcessorNode;
+class XLinkRoute;
 
 class XLink {
   friend class Node;
@@ -29,6 +30,16 @@ class XLink {
   uint8_t direction;
   uint16_t interTokenDelay;
   uint16_t interSymbolDelay;
+  /// Time at which the link is next free to transmit a token.
+  ticks_t busyUntil;
+  /// Number of tokens that can be sent before the receiver returns credit.
+  unsigned credits;
+  /// Routes waiting for credit on this link.
+  std::vector<XLinkRoute*> creditWaiters;
+  uint64_t packetsSent;
+  uint64_t tokensSent;
+  ticks_t busyTime;
+  ticks_t contentionTime;
 public:
   XLink();
   Node *getDestNode() { return destNode; }
@@ -46,6 +57,26 @@ public:
   void setInterSymbolDelay(uint16_t value) { interSymbolDelay = value; }
   uint16_t getInterSymbolDelay() const { return interSymbolDelay; }
   bool isConnected() const;
+  /// Returns the time taken to transmit a token with the current settings.
+  ticks_t getTokenTime() const;
+  /// Transmit a token that is ready to send at the specified time. Returns the
+  /// time at which the token has been received at the other end.
+  ticks_t transmitToken(ticks_t time);
+  bool hasCredit(unsigned tokens) const { return credits >= tokens; }
+  void takeCredit(unsigned tokens) { credits -= tokens; }
+  /// Return credit for tokens that have left the receive buffer, waking any
+  /// routes waiting for credit.
+  void returnCredit(ticks_t time, unsigned tokens);
+  /// Register a route to be notified when credit is returned.
+  void waitForCredit(XLinkRoute *route);
+  /// Number of packets routed over the link.
+  uint64_t getPacketsSent() const { return packetsSent; }
+  /// Number of tokens sent. Only counted when link timing is modelled.
+  uint64_t getTokensSent() const { return tokensSent; }
+  /// Total time spent transmitting tokens.
+  ticks_t getBusyTime() const { return busyTime; }
+  /// Total time tokens waited for the link to finish sending other tokens.
+  ticks_t getContentionTime() const { return contentionTime; }
 };
 
 class Node {
@@ -63,6 +94,8 @@ public:
   SystemState *parent;
   SSwitch sswitch;
   unsigned nodeNumberBits;
+  /// Links crossed by the packet being counted.
+  std::vector<XLink*> packetRoute;
   XLink *getXLinkForDirection(unsigned direction);
 protected:
   void setNodeNumberBits(unsigned value);
@@ -83,16 +116,23 @@ public:
   uint32_t getNodeID() const { return nodeID; }
   bool hasMatchingNodeID(ResourceID ID);
   SSwitch *getSSwitch() { return &sswitch; }
+  const SSwitch *getSSwitch() const { return &sswitch; }
   unsigned getNumXLinks() const { return xLinks.size(); }
   XLink &getXLink(unsigned num) { return xLinks[num]; }
   const XLink &getXLink(unsigned num) const { return xLinks[num]; }
   void connectXLink(unsigned num, Node *destNode, unsigned destNum);
   /// Find the destination of a packet with the specified resource ID that was
-  /// received on a link from another node.
-  ChanEndpoint *getIncomingChanendDest(ResourceID ID);
+  /// received on a link from another node. If route is non null the links
+  /// traversed are appended to it.
+  ChanEndpoint *getIncomingChanendDest(ResourceID ID,
+                                       std::vector<XLink*> *route = 0);
   /// Find the destination of a packet sent to the specified resource ID from
-  /// this node.
-  virtual ChanEndpoint *getOutgoingChanendDest(ResourceID ID);
+  /// this node. If route is non null the links traversed are appended to it.
+  virtual ChanEndpoint *getOutgoingChanendDest(ResourceID ID,
+                                               std::vector<XLink*> *route = 0);
+  /// Count a packet sent from this node to the specified resource ID on each
+  /// link it crosses. Should be called once the route has been opened.
+  void countPacketSent(ResourceID ID);
   virtual ChanEndpoint *getLocalChanendDest(ResourceID ID) = 0;
   uint8_t getDirection(unsigned num) const { return directions[num]; }
   void setDirection(unsigned num, uint8_t value) { directions[num] = value; }
@@ -62,10 +62,12 @@ public:
   const std::string &getName() const { return name; }
   PropertyDescriptor &addProperty(const PropertyDescriptor &p);
   const PropertyDescriptor *getProperty(const std::string &name) const;
-  void createInstance(SystemState &system,
-                      PortConnectionManager &connectionManager,
-                      const Properties &properties) const {
-    (*create)(system, connectionManager, properties);
+  /// Create the peripheral. Returns null, after reporting the error, if the
+  /// peripheral can't be created.
+  Peripheral *createInstance(SystemState &system,
+                             PortConnectionManager &connectionManager,
+                             const Properties &properties) const {
+    return (*create)(system, connectionManager, properties);
   }
   typedef AccessSecondIterator<
     std::map<std::string,PropertyDescriptor>::const_iterator> iterator;
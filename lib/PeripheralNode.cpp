@@ -25,13 +25,16 @@ void PeripheralNode::finalize()
   Node::finalize();
 }
 
-ChanEndpoint *PeripheralNode::getOutgoingChanendDest(ResourceID ID)
+ChanEndpoint *PeripheralNode::
+getOutgoingChanendDest(ResourceID ID, std::vector<XLink*> *route)
 {
   // All outgoing messages are routed over the link, regardless of the ID.
   XLink &xlink = getXLink(0);
   if (!xlink.isConnected())
     return nullptr;
-  return xlink.getDestNode()->getOutgoingChanendDest(ID);
+  if (route)
+    route->push_back(&xlink);
+  return xlink.getDestNode()->getOutgoingChanendDest(ID, route);
 }
 
 ChanEndpoint *PeripheralNode::getLocalChanendDest(ResourceID ID)
@@ -14,7 +14,8 @@ class PeripheralNode : public Node {
 public:
   PeripheralNode();
   void finalize() override;
-  ChanEndpoint *getOutgoingChanendDest(ResourceID ID) override;
+  ChanEndpoint *getOutgoingChanendDest(ResourceID ID,
+                                       std::vector<XLink*> *route) override;
   ChanEndpoint *getLocalChanendDest(ResourceID ID) override;
 };
 
@@ -8,11 +8,15 @@
 #include "Core.h"
 #include "PortNames.h"
 #include <algorithm>
+#include <cstdlib>
+#include <iostream>
 
 using axe::Port;
 using axe::Signal;
 using axe::Resource;
 
+bool Port::checkFastForward = false;
+
 Port::Port() :
   EventableResource(RES_TYPE_PORT),
   data(0),
@@ -22,6 +26,7 @@ Port::Port() :
   portCounter(0),
   loopback(nullptr),
   tracer(nullptr),
+  watcher(nullptr),
   pausedOut(nullptr),
   pausedIn(nullptr),
   pausedSync(nullptr),
@@ -225,6 +230,9 @@ handlePinsChange(Signal value, ticks_t time)
   if (tracer != nullptr) {
     tracer->seePinsChange(value, time);
   }
+  if (watcher != nullptr) {
+    watcher->seePinsChange(value, time);
+  }
 }
 
 void Port::
@@ -305,6 +313,10 @@ void Port::updateNoExternalChange(unsigned numEdges)
 
   if (outputPort) {
     while (validShiftRegEntries != 0 || portShiftCount != shiftRegEntries) {
+      numEdges -= fastForwardShiftReg(numEdges);
+      if (numEdges == 0) {
+        return;
+      }
       seeEdge(nextEdge++);
       if (--numEdges == 0) {
         return;
@@ -335,6 +347,10 @@ void Port::updateNoExternalChange(unsigned numEdges)
       }
     }
     while (validShiftRegEntries != 0 || portShiftCount != shiftRegEntries) {
+      numEdges -= fastForwardShiftReg(numEdges);
+      if (numEdges == 0) {
+        return;
+      }
       seeEdge(nextEdge++);
       if (--numEdges == 0) {
         return;
@@ -404,6 +420,10 @@ void Port::updateNoExternalChange(unsigned numEdges)
       }
     }
     while (!transferRegValid || portShiftCount != shiftRegEntries) {
+      numEdges -= fastForwardShiftReg(numEdges);
+      if (numEdges == 0) {
+        return;
+      }
       seeEdge(nextEdge++);
       if (--numEdges == 0) {
         return;
@@ -419,6 +439,10 @@ void Port::updateNoExternalChange(unsigned numEdges)
   while (!transferRegValid || portShiftCount != shiftRegEntries ||
          shiftReg != steadyStateShiftReg ||
          transferReg != steadyStateShiftReg) {
+    numEdges -= fastForwardShiftReg(numEdges);
+    if (numEdges == 0) {
+      return;
+    }
     seeEdge(nextEdge++);
     if (--numEdges == 0) {
       return;
@@ -474,6 +498,129 @@ uint32_t Port::computeSteadyStateInputShiftReg()
   return val;
 }
 
+bool Port::pinsObserved() const
+{
+  return loopback != nullptr || tracer != nullptr || watcher != nullptr ||
+         !sourceOf.empty() || !readyInOf.empty();
+}
+
+bool Port::needsEagerUpdate() const
+{
+  return (pausedIn != nullptr) || (pausedOut != nullptr) ||
+         (pausedSync != nullptr) || eventsPermitted() || useReadyOut() ||
+         readyOut || pinsObserved();
+}
+
+bool Port::canFastForwardShiftReg()
+{
+  if (timeRegValid) {
+    return false;
+  }
+  if (useReadyOut()) {
+    // Ready out only changes on the edge that fills or empties the shift
+    // register if it is already up to date. An input port only samples while
+    // ready out is asserted.
+    if (readyOut != computeReadyOut() || (!outputPort && !readyOut)) {
+      return false;
+    }
+  }
+  Signal readyInValue = clock->getReadyInValue();
+  if (readyInValue.isClock()) {
+    return false;
+  }
+  if (useReadyIn() && (!readyIn || readyInValue.getValue(time) == 0)) {
+    return false;
+  }
+  if (outputPort) {
+    return validShiftRegEntries != 0;
+  }
+  return !getEffectiveDataPortInputPinsValue().isClock() &&
+         validShiftRegEntries < portShiftCount &&
+         !shouldRealignShiftRegister();
+}
+
+unsigned Port::edgesUntilShiftRegBoundary() const
+{
+  // The shift register is emptied on a falling edge and filled on a sampling
+  // edge.
+  Edge::Type boundaryEdge = outputPort ? Edge::FALLING : samplingEdge;
+  unsigned numBoundaryEdges = outputPort ?
+    validShiftRegEntries : portShiftCount - validShiftRegEntries;
+  if (nextEdge->type == boundaryEdge) {
+    return (numBoundaryEdges - 1) * 2;
+  }
+  return numBoundaryEdges * 2 - 1;
+}
+
+unsigned Port::fastForwardShiftReg(unsigned maxEdges)
+{
+  if (!canFastForwardShiftReg()) {
+    return 0;
+  }
+  unsigned numEdges = std::min(maxEdges, edgesUntilShiftRegBoundary());
+  if (numEdges == 0) {
+    return 0;
+  }
+  if (!checkFastForward) {
+    fastForwardShiftRegNoCheck(numEdges);
+    return numEdges;
+  }
+  uint32_t oldShiftReg = shiftReg;
+  unsigned oldValidShiftRegEntries = validShiftRegEntries;
+  uint16_t oldPortCounter = portCounter;
+  bool oldReadyIn = readyIn;
+  bool oldReadyOut = readyOut;
+  EdgeIterator oldNextEdge = nextEdge;
+  ticks_t oldTime = time;
+  fastForwardShiftRegNoCheck(numEdges);
+  uint32_t expectedShiftReg = shiftReg;
+  unsigned expectedValidShiftRegEntries = validShiftRegEntries;
+  uint16_t expectedPortCounter = portCounter;
+  bool expectedReadyIn = readyIn;
+  ticks_t expectedTime = time;
+  shiftReg = oldShiftReg;
+  validShiftRegEntries = oldValidShiftRegEntries;
+  portCounter = oldPortCounter;
+  readyIn = oldReadyIn;
+  nextEdge = oldNextEdge;
+  time = oldTime;
+  for (unsigned i = 0; i < numEdges; i++) {
+    seeEdge(nextEdge++);
+  }
+  if (shiftReg != expectedShiftReg ||
+      validShiftRegEntries != expectedValidShiftRegEntries ||
+      portCounter != expectedPortCounter || readyIn != expectedReadyIn ||
+      readyOut != oldReadyOut || time != expectedTime) {
+    std::cerr << "Error: closed form update of " << getName()
+              << " over " << numEdges << " edges at time " << oldTime
+              << " differs from seeing each edge\n";
+    std::abort();
+  }
+  return numEdges;
+}
+
+void Port::fastForwardShiftRegNoCheck(unsigned numEdges)
+{
+  unsigned numFalling = (numEdges + static_cast<unsigned int>(nextEdge->type == Edge::FALLING)) / 2;
+  unsigned numSampling = (numEdges + static_cast<unsigned int>(nextEdge->type == samplingEdge)) / 2;
+  if (outputPort) {
+    // Nothing observes the pins or they don't change, otherwise the port would
+    // have been scheduled to run at an earlier edge.
+    shiftReg = shiftOutputShiftReg(shiftReg, numFalling);
+    validShiftRegEntries -= numFalling;
+  } else {
+    uint32_t value = getEffectiveDataPortInputPinsValue(time);
+    shiftReg = shiftInputShiftReg(shiftReg, value, numSampling);
+    validShiftRegEntries += numSampling;
+  }
+  portCounter += numFalling;
+  nextEdge += numEdges;
+  time = (nextEdge - 1)->time;
+  if (numSampling != 0) {
+    readyIn = clock->getReadyInValue(time) != 0u;
+  }
+}
+
 void Port::updateSlow(ticks_t newTime)
 {
   while (nextEdge->time <= newTime) {
@@ -505,6 +652,41 @@ nextShiftRegOutputPort(uint32_t old)
   return retval;
 }
 
+uint32_t Port::
+nextShiftRegInputPort(uint32_t old, uint32_t value) const
+{
+  return (old >> getPortWidth()) |
+         (value << (getTransferWidth() - getPortWidth()));
+}
+
+uint32_t Port::
+shiftOutputShiftReg(uint32_t value, unsigned numShifts)
+{
+  // Once every entry holds the last value the shift register stops changing
+  // so at most 32 / width shifts need to be simulated.
+  for (unsigned i = 0; i < numShifts; i++) {
+    uint32_t next = nextShiftRegOutputPort(value);
+    if (next == value) {
+      break;
+    }
+    value = next;
+  }
+  return value;
+}
+
+uint32_t Port::
+shiftInputShiftReg(uint32_t old, uint32_t value, unsigned numShifts) const
+{
+  for (unsigned i = 0; i < numShifts; i++) {
+    uint32_t next = nextShiftRegInputPort(old, value);
+    if (next == old) {
+      break;
+    }
+    old = next;
+  }
+  return old;
+}
+
 void Port::
 seeFallingEdgeOutputPort()
 {
@@ -586,8 +768,7 @@ seeSamplingEdge()
   if (useReadyIn() && !readyIn) { return; }
 
   uint32_t currentValue = getEffectiveDataPortInputPinsValue(time);
-  shiftReg >>= getPortWidth();
-  shiftReg |= currentValue << (getTransferWidth() - getPortWidth());
+  shiftReg = nextShiftRegInputPort(shiftReg, currentValue);
   validShiftRegEntries++;
 
   if (shouldRealignShiftRegister()) {
@@ -1121,11 +1302,19 @@ void Port::scheduleUpdateIfNeededOutputPort()
     return scheduleUpdate(nextEdge->time);
   }
   if (!readyOutIsInSteadyState()) {
+    if (!pinsObserved() && canFastForwardShiftReg()) {
+      // Ready out doesn't change until the shift register empties.
+      return scheduleUpdate((nextEdge + edgesUntilShiftRegBoundary())->time);
+    }
     return scheduleUpdate((nextEdge + 1)->time);
   }
   bool readyInKnownZero = useReadyIn() && clock->getReadyInValue() == Signal(0);
   if (!readyInKnownZero) {
     if (nextShiftRegOutputPort(shiftReg) != shiftReg) {
+      if (!pinsObserved() && canFastForwardShiftReg()) {
+        // No one sees the pins change until the shift register empties.
+        return scheduleUpdate((nextEdge + edgesUntilShiftRegBoundary())->time);
+      }
       return scheduleUpdate((nextEdge + 1)->time);
     }
     if (useReadyOut() && readyOut) {
@@ -1154,7 +1343,12 @@ void Port::scheduleUpdateIfNeededInputPort()
 
   // Next edge is falling edge
   } else if (!readyOutIsInSteadyState()) {
-    scheduleUpdate(nextEdge->time);
+    if (pausedOut == nullptr && canFastForwardShiftReg()) {
+      // Ready out doesn't change until the shift register fills.
+      scheduleUpdate((nextEdge + edgesUntilShiftRegBoundary())->time);
+    } else {
+      scheduleUpdate(nextEdge->time);
+    }
   } else if (pausedOut != nullptr && !timeRegValid) {
     scheduleUpdate(nextEdge->time);
   } else if (timeRegValid) {
@@ -1175,6 +1369,10 @@ void Port::scheduleUpdateIfNeededInputPort()
       if (nextSamplingEdge->type != samplingEdge) {
         ++nextSamplingEdge;
       }
+      if (canFastForwardShiftReg()) {
+        // Wait for the sampling edge that fills the shift register.
+        nextSamplingEdge += 2 * (portShiftCount - validShiftRegEntries - 1);
+      }
       scheduleUpdate(nextSamplingEdge->time);
     }
   }
@@ -1193,6 +1391,11 @@ void Port::scheduleUpdateIfNeeded()
       return scheduleUpdate(nextEdge->time);
     }
   }
+  if (!needsEagerUpdate()) {
+    // No one can see the port's state until a thread next accesses the port,
+    // which calls update() first.
+    return;
+  }
   if (outputPort) {
     scheduleUpdateIfNeededOutputPort();
   } else {
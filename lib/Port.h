@@ -18,7 +18,7 @@ namespace axe {
 class Thread;
 class ClockBlock;
 
-class Port : public EventableResource, public PortInterface {
+class Port final : public EventableResource, public PortInterface {
 public:
   enum ReadyMode {
     NOREADY,
@@ -44,6 +44,8 @@ private:
   uint16_t portCounter;
   PortInterface *loopback;
   PortInterface *tracer;
+  /// Notified of pin changes on behalf of run predicates.
+  PortInterface *watcher;
   /// Ready out ports.
   std::set<Port*> readyOutPorts;
   /// Thread paused on an output instruction.
@@ -99,6 +101,9 @@ private:
   MasterSlave masterSlave;
   PortType portType;
   Signal pinsInputValue;
+  /// Check each closed form update of the shift register against seeing the
+  /// edges one at a time.
+  static bool checkFastForward;
 
   /// Return the value currently being output to the ports pins.
   Signal getPinsOutputValue() const;
@@ -119,6 +124,23 @@ private:
   /// Called whenever the readyOut value changes.
   void handleReadyOutChange(bool value, ticks_t time);
   uint32_t computeSteadyStateInputShiftReg();
+  /// Return whether anything is notified when the pins change.
+  bool pinsObserved() const;
+  /// Return whether the port must be updated as edges occur. Otherwise the
+  /// port's state is computed when it is next accessed.
+  bool needsEagerUpdate() const;
+  /// Return whether the edges up to the edge that fills (input) or empties
+  /// (output) the shift register can be skipped by fastForwardShiftReg().
+  bool canFastForwardShiftReg();
+  /// Return the number of edges before the edge that fills (input) or empties
+  /// (output) the shift register.
+  unsigned edgesUntilShiftRegBoundary() const;
+  /// Skip up to maxEdges edges before the edge that fills or empties the
+  /// shift register, computing the shift register, the number of valid
+  /// entries and the port counter in closed form instead of seeing each edge.
+  /// Returns the number of edges skipped.
+  unsigned fastForwardShiftReg(unsigned maxEdges);
+  void fastForwardShiftRegNoCheck(unsigned numEdges);
   /// Update the port to the specified time. The port must be clocked off a
   /// fixed frequency clock.
   void updateSlow(ticks_t newTime);
@@ -174,11 +196,21 @@ private:
   }
   bool seeEventEnable(ticks_t time) override;
 
+  uint32_t nextShiftRegInputPort(uint32_t old, uint32_t value) const;
+  /// Return the shift register after shifting out numShifts times.
+  uint32_t shiftOutputShiftReg(uint32_t value, unsigned numShifts);
+  /// Return the shift register after shifting in value numShifts times.
+  uint32_t shiftInputShiftReg(uint32_t old, uint32_t value,
+                              unsigned numShifts) const;
+
   void seeFallingEdge();
   void seeSamplingEdge();
   void seeFallingEdgeOutputPort();
 public:
   Port();
+  /// Enable checking of closed form shift register updates. A mismatch is
+  /// reported and aborts the simulation.
+  static void setCheckFastForward(bool value) { checkFastForward = value; }
   std::string getName() const;
   Signal getEffectiveInputPinsValue() const {
     return getEffectiveValue(getPinsValue());
@@ -209,8 +241,20 @@ public:
   void clearPortTime(Thread &thread, ticks_t time);
 
   PortInterface *getLoopback() const { return loopback; }
-  void setLoopback(PortInterface *p) { loopback = p; }
-  void setTracer(PortInterface *p) { tracer = p; }
+  // Unobserved ports aren't scheduled so reschedule when an observer is
+  // added.
+  void setLoopback(PortInterface *p) {
+    loopback = p;
+    scheduleUpdateIfNeeded();
+  }
+  void setTracer(PortInterface *p) {
+    tracer = p;
+    scheduleUpdateIfNeeded();
+  }
+  void setWatcher(PortInterface *p) {
+    watcher = p;
+    scheduleUpdateIfNeeded();
+  }
   
   unsigned getPortWidth() const
   {
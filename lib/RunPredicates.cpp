@@ -0,0 +1,214 @@
+// Copyright (c) 2012, Richard Osborne, All rights reserved
+// This software is freely distributable under a derivative of the
+// University of Illinois/NCSA Open Source License posted in
+// LICENSE.txt and at <http://github.xcore.com/>
+
+#include "RunPredicates.h"
+#include "SystemState.h"
+#include "ProcessorNode.h"
+#include "Core.h"
+#include "Chanend.h"
+#include "Port.h"
+#include "Signal.h"
+#include <algorithm>
+
+using namespace axe;
+
+void RunPredicates::PortWatcher::
+seePinsChange(const Signal &value, ticks_t time)
+{
+  parent.seePinsChange(port, value, time);
+}
+
+void RunPredicates::updateMemoryWatches(Core &core)
+{
+  core.clearMemoryPredicateWatches();
+  for (const MemoryPredicate &predicate : memoryPredicates) {
+    if (predicate.core == &core)
+      core.watchMemoryPredicate(predicate.address);
+  }
+}
+
+void RunPredicates::updatePortWatcher(Port &port)
+{
+  bool watched =
+    std::any_of(portPredicates.begin(), portPredicates.end(),
+                [&](const PortPredicate &p) { return p.port == &port; });
+  if (!watched) {
+    port.setWatcher(nullptr);
+    portWatchers.erase(&port);
+    return;
+  }
+  std::unique_ptr<PortWatcher> &watcher = portWatchers[&port];
+  if (!watcher) {
+    watcher.reset(new PortWatcher(*this, port));
+    port.setWatcher(watcher.get());
+  }
+}
+
+void RunPredicates::updateChanendObservers()
+{
+  bool observed = !chanendOutputHooks.empty();
+  for (Node *node : system.getNodes()) {
+    if (!node->isProcessorNode())
+      continue;
+    for (Core *core : static_cast<ProcessorNode*>(node)->getCores()) {
+      for (Chanend &chanend : core->getChanends())
+        chanend.setOutputObserved(observed);
+    }
+  }
+}
+
+void RunPredicates::requestStop(unsigned id, ticks_t time)
+{
+  RunnableQueue &scheduler = system.getScheduler();
+  if (scheduler.contains(*this)) {
+    // Keep the earliest stop.
+    if (wakeUpTime <= time)
+      return;
+    scheduler.remove(*this);
+  }
+  stopID = id;
+  scheduler.push(*this, time);
+}
+
+unsigned RunPredicates::
+addMemoryPredicate(Core &core, uint32_t address, uint32_t mask,
+                   uint32_t value)
+{
+  if ((address & 3) || !core.isValidRamAddress(address))
+    return 0;
+  MemoryPredicate predicate = { nextID++, &core, address, mask, value & mask };
+  memoryPredicates.push_back(predicate);
+  updateMemoryWatches(core);
+  return predicate.id;
+}
+
+unsigned RunPredicates::
+addPortPredicate(Port &port, uint32_t mask, uint32_t value)
+{
+  PortPredicate predicate = { nextID++, &port, mask, value & mask, PortHook() };
+  portPredicates.push_back(predicate);
+  updatePortWatcher(port);
+  return predicate.id;
+}
+
+unsigned RunPredicates::addThreadCountPredicate(Core &core, unsigned count)
+{
+  ThreadCountPredicate predicate = { nextID++, &core, count };
+  threadCountPredicates.push_back(predicate);
+  return predicate.id;
+}
+
+unsigned RunPredicates::addPortHook(Port &port, const PortHook &hook)
+{
+  PortPredicate predicate = { nextID++, &port, 0, 0, hook };
+  portPredicates.push_back(predicate);
+  updatePortWatcher(port);
+  return predicate.id;
+}
+
+unsigned RunPredicates::addChanendOutputHook(const ChanendHook &hook)
+{
+  ChanendOutputHook entry = { nextID++, hook };
+  chanendOutputHooks.push_back(entry);
+  if (chanendOutputHooks.size() == 1)
+    updateChanendObservers();
+  return entry.id;
+}
+
+template <class T> static typename std::vector<T>::iterator
+findPredicate(std::vector<T> &predicates, unsigned id)
+{
+  return std::find_if(predicates.begin(), predicates.end(),
+                      [=](const T &p) { return p.id == id; });
+}
+
+bool RunPredicates::remove(unsigned id)
+{
+  auto memoryIt = findPredicate(memoryPredicates, id);
+  if (memoryIt != memoryPredicates.end()) {
+    Core &core = *memoryIt->core;
+    memoryPredicates.erase(memoryIt);
+    updateMemoryWatches(core);
+    return true;
+  }
+  auto portIt = findPredicate(portPredicates, id);
+  if (portIt != portPredicates.end()) {
+    Port &port = *portIt->port;
+    portPredicates.erase(portIt);
+    updatePortWatcher(port);
+    return true;
+  }
+  auto threadCountIt = findPredicate(threadCountPredicates, id);
+  if (threadCountIt != threadCountPredicates.end()) {
+    threadCountPredicates.erase(threadCountIt);
+    return true;
+  }
+  auto chanendIt = findPredicate(chanendOutputHooks, id);
+  if (chanendIt != chanendOutputHooks.end()) {
+    chanendOutputHooks.erase(chanendIt);
+    if (chanendOutputHooks.empty())
+      updateChanendObservers();
+    return true;
+  }
+  return false;
+}
+
+void RunPredicates::checkMemory(Core &core, Thread &thread)
+{
+  for (const MemoryPredicate &predicate : memoryPredicates) {
+    if (predicate.core != &core ||
+        (core.loadRamWord(predicate.address) & predicate.mask) !=
+          predicate.value)
+      continue;
+    // The store has completed so the thread can resume at the next
+    // instruction.
+    thread.schedule();
+    throw PredicateException(thread.time, predicate.id);
+  }
+}
+
+void RunPredicates::
+seePinsChange(Port &port, const Signal &value, ticks_t time)
+{
+  uint32_t pins = value.getValue(time);
+  for (const PortPredicate &predicate : portPredicates) {
+    if (predicate.port != &port)
+      continue;
+    bool stop = predicate.hook ? predicate.hook(port, pins, time) :
+                                 (pins & predicate.mask) == predicate.value;
+    if (stop)
+      requestStop(predicate.id, time);
+  }
+}
+
+void RunPredicates::seeThreadFreed(Core &core, ticks_t time)
+{
+  if (threadCountPredicates.empty())
+    return;
+  unsigned numInUse = 0;
+  for (Thread &thread : core.getThreads()) {
+    if (thread.isInUse())
+      ++numInUse;
+  }
+  for (const ThreadCountPredicate &predicate : threadCountPredicates) {
+    if (predicate.core == &core && predicate.count == numInUse)
+      requestStop(predicate.id, time);
+  }
+}
+
+void RunPredicates::
+seeChanendOutput(Thread &thread, Chanend &chanend, uint32_t value,
+                 ChanendOutputType type, ticks_t time)
+{
+  for (const ChanendOutputHook &entry : chanendOutputHooks) {
+    if (entry.hook(thread, chanend, value, type, time))
+      requestStop(entry.id, time);
+  }
+}
+
+void RunPredicates::run(ticks_t time)
+{
+  throw PredicateException(time, stopID);
+}
@@ -0,0 +1,134 @@
+// Copyright (c) 2012, Richard Osborne, All rights reserved
+// This software is freely distributable under a derivative of the
+// University of Illinois/NCSA Open Source License posted in
+// LICENSE.txt and at <http://github.xcore.com/>
+
+#ifndef _RunPredicates_h
+#define _RunPredicates_h
+
+#include "Runnable.h"
+#include "PortInterface.h"
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+#include <stdint.h>
+
+namespace axe {
+
+class SystemState;
+class Core;
+class Thread;
+class Port;
+class Chanend;
+
+/// Conditions that stop the simulation when they become true and hooks that
+/// are called as the simulation runs. Predicates are checked when the state
+/// they depend on changes so there is no cost while the simulation runs
+/// elsewhere. Each predicate and hook is identified by a non zero ID which is
+/// reported in the StopReason when it stops the simulation.
+///
+/// Stops requested from inside resources can't unwind the stack immediately
+/// since the caller may be compiled code. Instead the class schedules itself
+/// at the time of the stop and throws a PredicateException when it runs.
+class RunPredicates : public Runnable {
+public:
+  enum ChanendOutputType {
+    DATA_TOKEN,
+    CONTROL_TOKEN,
+    WORD
+  };
+  /// Hooks return whether the simulation should stop. Hooks must not add or
+  /// remove predicates.
+  typedef std::function<bool(Port &port, uint32_t value, ticks_t time)>
+    PortHook;
+  typedef std::function<bool(Thread &thread, Chanend &chanend, uint32_t value,
+                             ChanendOutputType type, ticks_t time)>
+    ChanendHook;
+private:
+  struct MemoryPredicate {
+    unsigned id;
+    Core *core;
+    uint32_t address;
+    uint32_t mask;
+    uint32_t value;
+  };
+  /// A predicate on the value of the pins of a port, or if hook is set a hook
+  /// called each time the pins change.
+  struct PortPredicate {
+    unsigned id;
+    Port *port;
+    uint32_t mask;
+    uint32_t value;
+    PortHook hook;
+  };
+  struct ThreadCountPredicate {
+    unsigned id;
+    Core *core;
+    unsigned count;
+  };
+  struct ChanendOutputHook {
+    unsigned id;
+    ChanendHook hook;
+  };
+  /// Forwards pin changes on a port to the predicates.
+  class PortWatcher : public PortInterface {
+    RunPredicates &parent;
+    Port &port;
+  public:
+    PortWatcher(RunPredicates &pa, Port &po) : parent(pa), port(po) {}
+    void seePinsChange(const Signal &value, ticks_t time) override;
+  };
+
+  SystemState &system;
+  unsigned nextID;
+  /// The predicate that caused the pending stop.
+  unsigned stopID;
+  std::vector<MemoryPredicate> memoryPredicates;
+  std::vector<PortPredicate> portPredicates;
+  std::vector<ThreadCountPredicate> threadCountPredicates;
+  std::vector<ChanendOutputHook> chanendOutputHooks;
+  std::map<Port*, std::unique_ptr<PortWatcher>> portWatchers;
+
+  void updateMemoryWatches(Core &core);
+  void updatePortWatcher(Port &port);
+  void updateChanendObservers();
+  void seePinsChange(Port &port, const Signal &value, ticks_t time);
+  /// Stop the simulation at the specified time.
+  void requestStop(unsigned id, ticks_t time);
+public:
+  RunPredicates(SystemState &s) : system(s), nextID(1), stopID(0) {}
+  RunPredicates(const RunPredicates &) = delete;
+
+  /// Stop when a store makes (word & mask) == value for the aligned word at
+  /// the specified address. Returns 0 if the address is invalid.
+  unsigned addMemoryPredicate(Core &core, uint32_t address, uint32_t mask,
+                              uint32_t value);
+  /// Stop when the pins of the port change such that (pins & mask) == value.
+  unsigned addPortPredicate(Port &port, uint32_t mask, uint32_t value);
+  /// Stop when a thread is freed leaving count threads in use on the core.
+  unsigned addThreadCountPredicate(Core &core, unsigned count);
+  /// Call the hook each time the pins of the port change.
+  unsigned addPortHook(Port &port, const PortHook &hook);
+  /// Call the hook each time a chanend outputs data. Chanends with an
+  /// observer take the slow path on output.
+  unsigned addChanendOutputHook(const ChanendHook &hook);
+  /// Remove a predicate or hook. Returns false if the ID is unknown.
+  bool remove(unsigned id);
+
+  /// Called after a thread stores to a word watched by a memory predicate.
+  /// If a predicate holds the thread is rescheduled and a PredicateException
+  /// is thrown. Must only be called from the interpreter.
+  void checkMemory(Core &core, Thread &thread);
+  /// Called after a thread on the core is freed.
+  void seeThreadFreed(Core &core, ticks_t time);
+  /// Called when a thread outputs data on a chanend with an observer.
+  void seeChanendOutput(Thread &thread, Chanend &chanend, uint32_t value,
+                        ChanendOutputType type, ticks_t time);
+
+  void run(ticks_t time) override;
+};
+
+} // End axe namespace
+
+#endif // _RunPredicates_h
@@ -18,6 +18,8 @@
 #include "Node.h"
 #include "Core.h"
 #include "BitManip.h"
+#include <algorithm>
+#include <cstdlib>
 #include <queue>
 #include <iostream>
 
@@ -85,75 +87,57 @@ unsigned SDRAMModeReg::getCASLatency() const
   return (reg >> 4) & 0x7;
 }
 
-class SDRAM : public Peripheral {
-  enum class Command {
-    NOP,
-    ACTIVE,
-    READ,
-    WRITE,
-    BURST_TERMINATE,
-    PRECHARGE,
-    AUTO_REFRESH,
-    LOAD_MODE_REGISTER,
-  };
-  std::vector<uint16_t> mem;
-  std::queue<std::pair<uint16_t,ticks_t>> pendingReads;
+enum class SDRAMCommand {
+  NOP,
+  ACTIVE,
+  READ,
+  WRITE,
+  BURST_TERMINATE,
+  PRECHARGE,
+  AUTO_REFRESH,
+  LOAD_MODE_REGISTER,
+};
+
+/// The memory and the state of the current burst. The pin level and
+/// transaction level models each have their own copy so they can be compared.
+class SDRAMState {
   SDRAMConfig config;
-  Command currentCommand;
+public:
+  std::vector<uint16_t> mem;
+  SDRAMCommand currentCommand;
   uint16_t currentColumn;
   uint16_t currentRow;
   uint32_t currentBank;
   uint16_t counter;
-  uint8_t edgeNumber;
   SDRAMModeReg modeReg;
-  PortSignalTracker A;
-  PortSignalTracker BA;
-  PortSignalTracker CAS;
-  PortInterfaceMemberFuncDelegate<SDRAM> CLKProxy;
-  PortHandleClockProxy CLKClock;
-  PortSignalTracker DQ;
-  PortInterface *DQPort;
-  PortSignalTracker RAS;
-  PortSignalTracker WE;
-  bool useLDQM;
-  PortSignalTracker LDQM;
-  bool useUDQM;
-  PortSignalTracker UDQM;
-  uint32_t getMemoryIndex(unsigned burstLength) const;
-  Command getCommand(ticks_t time) const;
-  bool getLDQMValue(ticks_t time) const;
-  bool getUDQMValue(ticks_t time) const;
-  uint16_t getReadWriteMask(ticks_t time) const;
-  void seeCLKChange(const Signal &value, ticks_t time);
-public:
-  SDRAM(RunnableQueue &scheduler, SDRAMConfig config);
 
-  void connectA(PortConnectionWrapper p) { p.attach(&A); }
-  void connectBA(PortConnectionWrapper p) { p.attach(&BA); }
-  void connectCAS(PortConnectionWrapper p) { p.attach(&CAS); }
-  void connectCLK(PortConnectionWrapper p) { p.attach(&CLKClock); }
-  void connectDQ(PortConnectionWrapper p) {
-    p.attach(&DQ);
-    DQPort = p.getInterface();
+  SDRAMState(const SDRAMConfig &config);
+  uint32_t getMemoryIndex(unsigned burstLength) const;
+  void startCommand(SDRAMCommand newCommand, uint32_t a, uint32_t ba);
+  bool inBurst() const {
+    return currentCommand == SDRAMCommand::READ ||
+           currentCommand == SDRAMCommand::WRITE;
   }
-  void connectRAS(PortConnectionWrapper p) { p.attach(&RAS); }
-  void connectWE(PortConnectionWrapper p) { p.attach(&WE); }
-  void connectLDQM(PortConnectionWrapper p) { useLDQM = true; p.attach(&LDQM); }
-  void connectUDQM(PortConnectionWrapper p) { useUDQM = true; p.attach(&UDQM); }
+  /// Returns the number of beats left in the current burst.
+  uint64_t getRemainingBeats() const;
+  uint16_t readBeat(uint16_t mask);
+  void writeBeat(bool we, uint16_t mask, uint16_t data);
+  /// Advance the burst without reading or writing.
+  void skipBeats(uint64_t beats);
 };
 
-SDRAM::SDRAM(RunnableQueue &scheduler, SDRAMConfig config) :
+SDRAMState::SDRAMState(const SDRAMConfig &config) :
   config(config),
-  currentCommand(Command::NOP),
-  edgeNumber(0),
-  CLKProxy(*this, &SDRAM::seeCLKChange),
-  CLKClock(scheduler, CLKProxy),
-  DQPort(nullptr)
+  currentCommand(SDRAMCommand::NOP),
+  currentColumn(0),
+  currentRow(0),
+  currentBank(0),
+  counter(0)
 {
   mem.resize(config.getNumEntries());
 }
 
-uint32_t SDRAM::getMemoryIndex(unsigned burstLength) const
+uint32_t SDRAMState::getMemoryIndex(unsigned burstLength) const
 {
   uint16_t column;
   if (burstLength == 0) {
@@ -180,7 +164,232 @@ uint32_t SDRAM::getMemoryIndex(unsigned burstLength) const
   return index;
 }
 
-SDRAM::Command SDRAM::getCommand(ticks_t time) const
+void SDRAMState::startCommand(SDRAMCommand newCommand, uint32_t a,
+                              uint32_t ba)
+{
+  switch (newCommand) {
+  case SDRAMCommand::ACTIVE:
+    currentRow = a & ((1 << config.rowBits) - 1);
+    break;
+  case SDRAMCommand::AUTO_REFRESH:
+  case SDRAMCommand::NOP:
+  case SDRAMCommand::PRECHARGE:
+    break;
+  case SDRAMCommand::LOAD_MODE_REGISTER:
+    modeReg.set(a);
+    break;
+  case SDRAMCommand::READ:
+  case SDRAMCommand::WRITE:
+    currentColumn = a & ((1 << config.columnBits) - 1);
+    currentBank = ba & ((1 << config.bankBits) - 1);
+    counter = 0;
+    break;
+  case SDRAMCommand::BURST_TERMINATE:
+    break;
+  }
+  if (newCommand != SDRAMCommand::NOP) {
+    currentCommand = newCommand;
+  }
+}
+
+uint64_t SDRAMState::getRemainingBeats() const
+{
+  if (!inBurst())
+    return 0;
+  unsigned burstLength = modeReg.getReadBurstLength();
+  if (burstLength == 0)
+    return UINT64_MAX;
+  return burstLength - counter;
+}
+
+uint16_t SDRAMState::readBeat(uint16_t mask)
+{
+  unsigned burstLength = modeReg.getReadBurstLength();
+  uint16_t data = mem[getMemoryIndex(burstLength)] & mask;
+  ++counter;
+  if (burstLength != 0 && counter == burstLength)
+    currentCommand = SDRAMCommand::NOP;
+  return data;
+}
+
+void SDRAMState::writeBeat(bool we, uint16_t mask, uint16_t data)
+{
+  unsigned burstLength = modeReg.getReadBurstLength();
+  if (we) {
+    uint32_t index = getMemoryIndex(burstLength);
+    uint16_t old = mem[index];
+    mem[index] ^= (old ^ data) & mask;
+  }
+  ++counter;
+  if (burstLength != 0 && counter == burstLength)
+    currentCommand = SDRAMCommand::NOP;
+}
+
+void SDRAMState::skipBeats(uint64_t beats)
+{
+  unsigned burstLength = modeReg.getReadBurstLength();
+  counter += beats;
+  if (burstLength != 0 && counter == burstLength)
+    currentCommand = SDRAMCommand::NOP;
+}
+
+enum class SDRAMModel {
+  /// Decode the pins on every clock edge.
+  PIN,
+  /// Only look at the pins when they change and handle the beats of a burst
+  /// in bulk.
+  TRANSACTION,
+  /// Run both models and check they drive the same values at the same times.
+  CHECK
+};
+
+class SDRAM;
+
+/// Tracks the signal on an input of the SDRAM. The transaction level model
+/// must catch up to the time of the change before the signal is updated.
+class SDRAMInputTracker : public PortSignalTracker {
+  SDRAM &parent;
+public:
+  SDRAMInputTracker(SDRAM &p) : parent(p) {}
+  void seePinsChange(const Signal &s, ticks_t time) override;
+};
+
+class SDRAM : public Peripheral, public Runnable {
+  RunnableQueue &scheduler;
+  SDRAMConfig config;
+  SDRAMModel model;
+  SDRAMInputTracker A;
+  SDRAMInputTracker BA;
+  SDRAMInputTracker CAS;
+  PortInterfaceMemberFuncDelegate<SDRAM> CLK;
+  SDRAMInputTracker DQ;
+  PortInterface *DQPort;
+  SDRAMInputTracker RAS;
+  SDRAMInputTracker WE;
+  bool useLDQM;
+  SDRAMInputTracker LDQM;
+  bool useUDQM;
+  SDRAMInputTracker UDQM;
+
+  // Pin level model.
+  std::unique_ptr<SDRAMState> pinState;
+  std::queue<std::pair<uint16_t,ticks_t>> pendingReads;
+  uint8_t edgeNumber;
+  PortInterfaceMemberFuncDelegate<SDRAM> CLKProxy;
+  PortHandleClockProxy CLKClock;
+
+  // Transaction level model.
+  std::unique_ptr<SDRAMState> transactionState;
+  /// Words read by the transaction level model and the number of the rising
+  /// edge after which they are driven on the next falling edge.
+  std::queue<std::pair<uint16_t,uint64_t>> pendingTransactionReads;
+  Signal CLKSignal;
+  /// Number of rising edges seen by the transaction level model.
+  uint64_t transactionEdgeNumber;
+  /// If the clock is free running, the time of the first rising edge the
+  /// transaction level model hasn't seen yet.
+  ticks_t nextRisingEdge;
+
+  // Values driven by each model in check mode.
+  std::queue<std::pair<uint16_t,ticks_t>> pinOutputs;
+  std::queue<std::pair<uint16_t,ticks_t>> transactionOutputs;
+  /// Times of the last rising and falling edges seen by the pin level model.
+  ticks_t lastPinRisingEdge;
+  ticks_t lastPinFallingEdge;
+
+  SDRAMCommand getCommand(ticks_t time) const;
+  bool getLDQMValue(ticks_t time) const;
+  bool getUDQMValue(ticks_t time) const;
+  uint16_t getReadWriteMask(ticks_t time) const;
+  /// Update the state for a rising edge of the clock. Returns true and sets
+  /// data if a word is read.
+  bool seeRisingEdge(SDRAMState &state, ticks_t time, uint16_t &data);
+  void seeCLKChange(const Signal &value, ticks_t time);
+  void seeCLKSignalChange(const Signal &value, ticks_t time);
+
+  bool usePinModel() const { return model != SDRAMModel::TRANSACTION; }
+  bool useTransactionModel() const { return model != SDRAMModel::PIN; }
+  /// Handle the rising edges starting at the specified time over which the
+  /// inputs stay the same. Returns the number of edges handled, which may be
+  /// less than maxEdges.
+  uint64_t seeTransactionRisingEdges(ticks_t time, uint64_t maxEdges);
+  ticks_t getTransactionReadTime(uint64_t edge) const;
+  void driveTransactionRead(uint16_t data, ticks_t time);
+  /// Compare the values driven by both models. Values driven by one model
+  /// before the specified time must have been driven by the other.
+  void compareOutputs(ticks_t time);
+  /// Compare the values left unmatched and the memory of both models once
+  /// the simulation has finished.
+  void checkFinalState();
+public:
+  SDRAM(RunnableQueue &scheduler, SDRAMConfig config, SDRAMModel model);
+  ~SDRAM();
+
+  /// Process the rising edges of a free running clock before the specified
+  /// time.
+  void catchUp(ticks_t time);
+  /// Schedule the transaction level model to drive the next word read.
+  void scheduleTransactionUpdate();
+  void run(ticks_t time) override;
+
+  void connectA(PortConnectionWrapper p) { p.attach(&A); }
+  void connectBA(PortConnectionWrapper p) { p.attach(&BA); }
+  void connectCAS(PortConnectionWrapper p) { p.attach(&CAS); }
+  void connectCLK(PortConnectionWrapper p) { p.attach(&CLK); }
+  void connectDQ(PortConnectionWrapper p) {
+    p.attach(&DQ);
+    DQPort = p.getInterface();
+  }
+  void connectRAS(PortConnectionWrapper p) { p.attach(&RAS); }
+  void connectWE(PortConnectionWrapper p) { p.attach(&WE); }
+  void connectLDQM(PortConnectionWrapper p) { useLDQM = true; p.attach(&LDQM); }
+  void connectUDQM(PortConnectionWrapper p) { useUDQM = true; p.attach(&UDQM); }
+};
+
+void SDRAMInputTracker::seePinsChange(const Signal &s, ticks_t time)
+{
+  parent.catchUp(time);
+  PortSignalTracker::seePinsChange(s, time);
+  parent.scheduleTransactionUpdate();
+}
+
+SDRAM::SDRAM(RunnableQueue &s, SDRAMConfig config, SDRAMModel model) :
+  scheduler(s),
+  config(config),
+  model(model),
+  A(*this),
+  BA(*this),
+  CAS(*this),
+  CLK(*this, &SDRAM::seeCLKSignalChange),
+  DQ(*this),
+  DQPort(nullptr),
+  RAS(*this),
+  WE(*this),
+  useLDQM(false),
+  LDQM(*this),
+  useUDQM(false),
+  UDQM(*this),
+  edgeNumber(0),
+  CLKProxy(*this, &SDRAM::seeCLKChange),
+  CLKClock(s, CLKProxy),
+  transactionEdgeNumber(0),
+  nextRisingEdge(0),
+  lastPinRisingEdge(0),
+  lastPinFallingEdge(0)
+{
+  if (usePinModel())
+    pinState.reset(new SDRAMState(config));
+  if (useTransactionModel())
+    transactionState.reset(new SDRAMState(config));
+}
+
+SDRAM::~SDRAM()
+{
+  if (model == SDRAMModel::CHECK)
+    checkFinalState();
+}
+
+SDRAMCommand SDRAM::getCommand(ticks_t time) const
 {
   uint32_t cmd = 0;
   if (WE.getSignal().getValue(time))
@@ -193,21 +402,21 @@ SDRAM::Command SDRAM::getCommand(ticks_t time) const
   default:
     assert(0 && "Unexpected cmd");
   case 0:
-    return Command::LOAD_MODE_REGISTER;
+    return SDRAMCommand::LOAD_MODE_REGISTER;
   case 1:
-    return Command::AUTO_REFRESH;
+    return SDRAMCommand::AUTO_REFRESH;
   case 2:
-    return Command::PRECHARGE;
+    return SDRAMCommand::PRECHARGE;
   case 3:
-    return Command::ACTIVE;
+    return SDRAMCommand::ACTIVE;
   case 4:
-    return Command::WRITE;
+    return SDRAMCommand::WRITE;
   case 5:
-    return Command::READ;
+    return SDRAMCommand::READ;
   case 6:
-    return Command::BURST_TERMINATE;
+    return SDRAMCommand::BURST_TERMINATE;
   case 7:
-    return Command::NOP;
+    return SDRAMCommand::NOP;
   }
 }
 
@@ -239,83 +448,262 @@ uint16_t SDRAM::getReadWriteMask(ticks_t time) const
   return mask;
 }
 
+bool SDRAM::seeRisingEdge(SDRAMState &state, ticks_t time, uint16_t &data)
+{
+  SDRAMCommand newCommand = getCommand(time);
+  state.startCommand(newCommand, A.getSignal().getValue(time),
+                     BA.getSignal().getValue(time));
+  switch (state.currentCommand) {
+  default:
+    return false;
+  case SDRAMCommand::READ:
+    data = state.readBeat(getReadWriteMask(time));
+    return true;
+  case SDRAMCommand::WRITE:
+    state.writeBeat(WE.getSignal().getValue(time), getReadWriteMask(time),
+                    DQ.getSignal().getValue(time));
+    return false;
+  }
+}
+
 void SDRAM::seeCLKChange(const Signal &value, ticks_t time)
 {
   if (value.getValue(time)) {
     // Rising edge.
-    Command newCommand = getCommand(time);
-    switch (newCommand) {
-    case Command::ACTIVE:
-      currentRow = A.getSignal().getValue(time) & ((1 << config.rowBits) - 1);
-      break;
-    case Command::AUTO_REFRESH:
-    case Command::NOP:
-    case Command::PRECHARGE:
-      break;
-    case Command::LOAD_MODE_REGISTER:
-      modeReg.set(A.getSignal().getValue(time));
-      break;
-    case Command::READ:
-      currentColumn =
-        A.getSignal().getValue(time) & ((1 << config.columnBits) - 1);
-      currentBank =
-        BA.getSignal().getValue(time) & ((1 << config.bankBits) - 1);
-      counter = 0;
-      break;
-    case Command::WRITE:
-      currentColumn =
-        A.getSignal().getValue(time) & ((1 << config.columnBits) - 1);
-      currentBank =
-        BA.getSignal().getValue(time) & ((1 << config.bankBits) - 1);
-      counter = 0;
-      break;
-    case Command::BURST_TERMINATE:
-      break;
-    }
-    if (newCommand != Command::NOP) {
-      currentCommand = newCommand;
-    }
-    switch (currentCommand) {
-    default:
-      break;
-    case Command::READ:
-      {
-        uint16_t mask = getReadWriteMask(time);
-        unsigned burstLength = modeReg.getReadBurstLength();
-        uint16_t data = mem[getMemoryIndex(burstLength)] & mask;
-        uint8_t readEdge = edgeNumber + modeReg.getCASLatency();
-        pendingReads.push(std::make_pair(data, readEdge));
-        ++counter;
-        if (burstLength != 0 && counter == burstLength)
-          currentCommand = Command::NOP;
-      }
-      break;
-    case Command::WRITE:
-      {
-        unsigned burstLength = modeReg.getReadBurstLength();
-        if (WE.getSignal().getValue(time)) {
-          uint16_t mask = getReadWriteMask(time);
-          uint32_t index = getMemoryIndex(burstLength);
-          uint16_t old = mem[index];
-          uint16_t data = DQ.getSignal().getValue(time);
-          mem[index] ^= (old ^ data) & mask;
-        }
-        ++counter;
-        if (burstLength != 0 && counter == burstLength)
-          currentCommand = Command::NOP;
-      }
-      break;
+    uint16_t data;
+    if (seeRisingEdge(*pinState, time, data)) {
+      uint8_t readEdge = edgeNumber + pinState->modeReg.getCASLatency();
+      pendingReads.push(std::make_pair(data, readEdge));
     }
     ++edgeNumber;
+    lastPinRisingEdge = time;
   } else {
     // Falling edge.
+    lastPinFallingEdge = time;
     if (!pendingReads.empty() && pendingReads.front().second == edgeNumber) {
       DQPort->seePinsChange(Signal(pendingReads.front().first), time);
+      if (model == SDRAMModel::CHECK) {
+        pinOutputs.push(std::make_pair(pendingReads.front().first, time));
+        compareOutputs(time);
+      }
       pendingReads.pop();
     }
   }
 }
 
+void SDRAM::seeCLKSignalChange(const Signal &value, ticks_t time)
+{
+  if (usePinModel())
+    CLKClock.seePinsChange(value, time);
+  if (!useTransactionModel())
+    return;
+  catchUp(time);
+  uint32_t oldValue = CLKSignal.getValue(time ? time - 1 : time);
+  uint32_t newValue = value.getValue(time);
+  CLKSignal = value;
+  if (newValue != oldValue) {
+    if (newValue) {
+      seeTransactionRisingEdges(time, 1);
+    } else if (!pendingTransactionReads.empty() &&
+               pendingTransactionReads.front().second ==
+                 transactionEdgeNumber - 1) {
+      driveTransactionRead(pendingTransactionReads.front().first, time);
+      pendingTransactionReads.pop();
+    }
+  }
+  if (CLKSignal.isClock())
+    nextRisingEdge = CLKSignal.getNextEdge(time, Edge::RISING).time;
+  scheduleTransactionUpdate();
+}
+
+uint64_t SDRAM::seeTransactionRisingEdges(ticks_t time, uint64_t maxEdges)
+{
+  SDRAMState &state = *transactionState;
+  SDRAMCommand command = getCommand(time);
+  if (command != SDRAMCommand::NOP) {
+    uint16_t data;
+    if (seeRisingEdge(state, time, data)) {
+      unsigned latency = state.modeReg.getCASLatency();
+      if (latency != 0) {
+        pendingTransactionReads.push(
+          std::make_pair(data, transactionEdgeNumber + latency - 1));
+      }
+    }
+    ++transactionEdgeNumber;
+    // A read or write restarts the burst on every edge it is held for.
+    // Repeating any other command has no further effect.
+    if (command == SDRAMCommand::READ || command == SDRAMCommand::WRITE)
+      return 1;
+    transactionEdgeNumber += maxEdges - 1;
+    return maxEdges;
+  }
+  uint64_t beats = std::min(maxEdges, state.getRemainingBeats());
+  uint16_t mask = getReadWriteMask(time);
+  if (state.currentCommand == SDRAMCommand::READ) {
+    unsigned latency = state.modeReg.getCASLatency();
+    if (latency == 0) {
+      // Reads are never driven with a latency of 0.
+      state.skipBeats(beats);
+    } else {
+      for (uint64_t i = 0; i < beats; i++) {
+        uint16_t data = state.readBeat(mask);
+        pendingTransactionReads.push(
+          std::make_pair(data, transactionEdgeNumber + i + latency - 1));
+      }
+    }
+  } else if (state.currentCommand == SDRAMCommand::WRITE) {
+    // The data doesn't change so a full page burst only needs to write each
+    // column once.
+    uint64_t writes = std::min<uint64_t>(beats, 1 << config.columnBits);
+    bool we = WE.getSignal().getValue(time);
+    uint16_t data = DQ.getSignal().getValue(time);
+    for (uint64_t i = 0; i < writes; i++) {
+      state.writeBeat(we, mask, data);
+    }
+    state.skipBeats(beats - writes);
+  }
+  // Edges after the end of the burst have no effect.
+  transactionEdgeNumber += maxEdges;
+  return maxEdges;
+}
+
+void SDRAM::catchUp(ticks_t time)
+{
+  if (!useTransactionModel() || !CLKSignal.isClock())
+    return;
+  uint32_t period = CLKSignal.getPeriod();
+  while (nextRisingEdge < time) {
+    uint64_t edges = (time - nextRisingEdge + period - 1) / period;
+    nextRisingEdge += seeTransactionRisingEdges(nextRisingEdge, edges) *
+                      period;
+  }
+}
+
+ticks_t SDRAM::getTransactionReadTime(uint64_t edge) const
+{
+  // Reads are driven on the falling edge after the rising edge.
+  int64_t edgesAhead = edge - transactionEdgeNumber;
+  return nextRisingEdge + edgesAhead * CLKSignal.getPeriod() +
+         CLKSignal.getHalfPeriod();
+}
+
+void SDRAM::driveTransactionRead(uint16_t data, ticks_t time)
+{
+  if (model == SDRAMModel::CHECK) {
+    transactionOutputs.push(std::make_pair(data, time));
+    compareOutputs(time);
+    return;
+  }
+  DQPort->seePinsChange(Signal(data), time);
+}
+
+void SDRAM::scheduleTransactionUpdate()
+{
+  if (!useTransactionModel())
+    return;
+  // Only wake up to drive reads. Everything else is handled when the inputs
+  // change.
+  const SDRAMState &state = *transactionState;
+  unsigned latency = state.modeReg.getCASLatency();
+  bool readNext = false;
+  if (CLKSignal.isClock() && latency != 0) {
+    SDRAMCommand command = getCommand(nextRisingEdge);
+    readNext = command == SDRAMCommand::READ ||
+               (command == SDRAMCommand::NOP &&
+                state.currentCommand == SDRAMCommand::READ);
+  }
+  if (CLKSignal.isClock() && !pendingTransactionReads.empty()) {
+    scheduler.push(*this, getTransactionReadTime(
+                            pendingTransactionReads.front().second));
+  } else if (readNext) {
+    scheduler.push(*this, getTransactionReadTime(transactionEdgeNumber +
+                                                 latency - 1));
+  } else if (scheduler.contains(*this)) {
+    scheduler.remove(*this);
+  }
+}
+
+void SDRAM::run(ticks_t time)
+{
+  catchUp(time);
+  while (!pendingTransactionReads.empty() &&
+         getTransactionReadTime(pendingTransactionReads.front().second) <=
+           time) {
+    driveTransactionRead(pendingTransactionReads.front().first, time);
+    pendingTransactionReads.pop();
+  }
+  scheduleTransactionUpdate();
+}
+
+static void
+reportUnmatchedOutput(const char *model, const char *otherModel,
+                      const std::pair<uint16_t,ticks_t> &output)
+{
+  std::cerr << std::hex << std::showbase << "Error: SDRAM " << model
+            << " level model drove " << output.first << std::dec
+            << " at time " << output.second << ", " << otherModel
+            << " level model drove nothing\n";
+  std::abort();
+}
+
+void SDRAM::compareOutputs(ticks_t time)
+{
+  while (!pinOutputs.empty() && !transactionOutputs.empty()) {
+    const std::pair<uint16_t,ticks_t> &expected = pinOutputs.front();
+    const std::pair<uint16_t,ticks_t> &actual = transactionOutputs.front();
+    if (expected != actual) {
+      std::cerr << std::hex << std::showbase
+                << "Error: SDRAM transaction level model drove "
+                << actual.first << std::dec << " at time " << actual.second
+                << std::hex << ", pin level model drove " << expected.first
+                << std::dec << " at time " << expected.second << "\n";
+      std::abort();
+    }
+    pinOutputs.pop();
+    transactionOutputs.pop();
+  }
+  // Both models drive a value at the same time, but either may see that
+  // time first.
+  if (!pinOutputs.empty() && pinOutputs.front().second < time)
+    reportUnmatchedOutput("pin", "transaction", pinOutputs.front());
+  if (!transactionOutputs.empty() && transactionOutputs.front().second < time)
+    reportUnmatchedOutput("transaction", "pin", transactionOutputs.front());
+}
+
+void SDRAM::checkFinalState()
+{
+  // Bring the transaction level model up to the last edges seen by the pin
+  // level model. Anything it drove after them can't be compared.
+  catchUp(lastPinRisingEdge + 1);
+  while (CLKSignal.isClock() && !pendingTransactionReads.empty()) {
+    ticks_t readTime =
+      getTransactionReadTime(pendingTransactionReads.front().second);
+    if (readTime > lastPinFallingEdge)
+      break;
+    driveTransactionRead(pendingTransactionReads.front().first, readTime);
+    pendingTransactionReads.pop();
+  }
+  compareOutputs(lastPinFallingEdge);
+  if (!pinOutputs.empty())
+    reportUnmatchedOutput("pin", "transaction", pinOutputs.front());
+  if (!transactionOutputs.empty() &&
+      transactionOutputs.front().second <= lastPinFallingEdge)
+    reportUnmatchedOutput("transaction", "pin", transactionOutputs.front());
+  const std::vector<uint16_t> &expected = pinState->mem;
+  const std::vector<uint16_t> &actual = transactionState->mem;
+  auto mismatch = std::mismatch(expected.begin(), expected.end(),
+                                actual.begin());
+  if (mismatch.first != expected.end()) {
+    std::cerr << std::hex << std::showbase
+              << "Error: SDRAM transaction level model memory holds "
+              << *mismatch.second << " at index "
+              << (mismatch.first - expected.begin())
+              << ", pin level model memory holds " << *mismatch.first
+              << std::dec << "\n";
+    std::abort();
+  }
+}
+
 static Peripheral *
 createSDRAM(SystemState &system, PortConnectionManager &connectionManager,
             const Properties &properties)
@@ -324,7 +712,21 @@ createSDRAM(SystemState &system, PortConnectionManager &connectionManager,
   config.columnBits = 8;
   config.rowBits = 12;
   config.bankBits = 2;
-  auto p = new SDRAM(system.getScheduler(), config);
+  SDRAMModel model = SDRAMModel::PIN;
+  if (const Property *property = properties.get("model")) {
+    std::string name = property->getAsString();
+    if (name == "pin") {
+      model = SDRAMModel::PIN;
+    } else if (name == "transaction") {
+      model = SDRAMModel::TRANSACTION;
+    } else if (name == "check") {
+      model = SDRAMModel::CHECK;
+    } else {
+      std::cerr << "Error: unknown SDRAM model \"" << name << "\"\n";
+      std::exit(1);
+    }
+  }
+  auto p = new SDRAM(system.getScheduler(), config, model);
   p->connectA(connectionManager.get(properties, "a"));
   p->connectBA(connectionManager.get(properties, "ba"));
   p->connectCAS(connectionManager.get(properties, "cas"));
@@ -354,5 +756,6 @@ std::unique_ptr<PeripheralDescriptor> axe::getPeripheralDescriptorSDRAM()
   p->addProperty(PropertyDescriptor::portProperty("udqm"));
   p->addProperty(PropertyDescriptor::portProperty("ras")).setRequired(true);
   p->addProperty(PropertyDescriptor::portProperty("we")).setRequired(true);
+  p->addProperty(PropertyDescriptor::stringProperty("model"));
   return p;
 }
@@ -17,24 +17,110 @@
 #include "Node.h"
 #include "Core.h"
 #include "PortHandleClockProxy.h"
+#include <algorithm>
 #include <fstream>
 #include <iostream>
-#include <cstdlib>
+#include <memory>
+#include <vector>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
 
 using namespace axe;
 
+static bool readAt(int fd, void *buf, size_t size, off_t offset)
+{
+#ifdef _WIN32
+  return _lseek(fd, offset, SEEK_SET) == offset &&
+         _read(fd, buf, size) == int(size);
+#else
+  return pread(fd, buf, size, offset) == ssize_t(size);
+#endif
+}
+
+static bool writeAt(int fd, const void *buf, size_t size, off_t offset)
+{
+#ifdef _WIN32
+  return _lseek(fd, offset, SEEK_SET) == offset &&
+         _write(fd, buf, size) == int(size);
+#else
+  return pwrite(fd, buf, size, offset) == ssize_t(size);
+#endif
+}
+
+static bool resizeFile(int fd, off_t size)
+{
+#ifdef _WIN32
+  return _chsize(fd, size) == 0;
+#else
+  return ftruncate(fd, size) == 0;
+#endif
+}
+
+/// Models a SPI flash device. Where supported, the image is mapped into
+/// memory privately so it is only read from disk as it is accessed and is
+/// never modified. Otherwise it is read into memory.
+///
+/// Programs and erases can optionally be written back to an overlay file so
+/// they persist between runs. The overlay file holds a copy of each sector
+/// that has been modified at the same offset as in the image, followed by a
+/// bitmap with a bit per sector that is set if the sector is in the overlay.
+/// Sectors that have not been modified are left as holes in the file.
 class SPIFlash : public Peripheral {
   void seeSCLKChange(const Signal &value, ticks_t time);
   void seeSSChange(const Signal &value, ticks_t time);
   enum State {
     WAIT_FOR_CMD,
     WAIT_FOR_ADDRESS,
+    WAIT_FOR_DUMMY,
     READ,
+    READ_STATUS,
+    PROGRAM,
+    WAIT_FOR_DESELECT,
     UNKNOWN_CMD
   };
+  enum Command {
+    CMD_PAGE_PROGRAM = 0x02,
+    CMD_READ = 0x03,
+    CMD_WRITE_DISABLE = 0x04,
+    CMD_READ_STATUS = 0x05,
+    CMD_WRITE_ENABLE = 0x06,
+    CMD_FAST_READ = 0x0b,
+    CMD_SECTOR_ERASE = 0x20,
+    CMD_CHIP_ERASE_ALT = 0x60,
+    CMD_CHIP_ERASE = 0xc7,
+    CMD_BLOCK_ERASE = 0xd8,
+  };
+  enum {
+    PAGE_SIZE = 256,
+    SECTOR_SIZE = 4096,
+    BLOCK_SIZE = 65536,
+    STATUS_WEL = 1 << 1
+  };
   State state;
-  unsigned char *mem;
+  uint8_t command;
+  uint8_t *mem;
   unsigned memSize;
+  int overlayFD;
+  std::string overlayName;
+  /// Bit per sector, set if the sector is in the overlay file.
+  std::vector<uint8_t> overlayBitmap;
+  /// Bit per sector, set if the sector has been modified by the current
+  /// command.
+  std::vector<uint8_t> dirtySectors;
+  std::vector<unsigned> dirtySectorList;
+  bool writeEnable;
   PortInterface *MISO;
   PortSignalTracker MOSITracker;
   PortInterfaceMemberFuncDelegate<SPIFlash> SCLKProxy;
@@ -52,20 +138,40 @@ class SPIFlash : public Peripheral {
   uint32_t readAddress;
 
   void reset();
+  void seeByte(uint8_t value);
+  uint8_t getNextSendByte();
+  /// Perform the actions of the current command that take place when the
+  /// device is deselected.
+  void finishCommand();
+  void erase(uint32_t address, unsigned size);
+  void markDirty(uint32_t address, unsigned size);
+  void writeBackDirtySectors();
+  void closeFile();
+  void closeOverlay();
+  unsigned getNumSectors() const {
+    return (memSize + SECTOR_SIZE - 1) / SECTOR_SIZE;
+  }
 public:
   SPIFlash(RunnableQueue &scheduler, PortConnectionWrapper MISO,
            PortConnectionWrapper MOSI, PortConnectionWrapper SCLK,
            PortConnectionWrapper SS);
   ~SPIFlash();
-  void openFile(const std::string &s);
+  /// Open the flash image. Returns false and prints an error on failure.
+  bool openFile(const std::string &s);
+  /// Open the overlay file, creating it if it doesn't exist. Returns false
+  /// and prints an error on failure.
+  bool openOverlay(const std::string &s);
 };
 
 SPIFlash::
 SPIFlash(RunnableQueue &scheduler, PortConnectionWrapper miso,
          PortConnectionWrapper mosi, PortConnectionWrapper sclk,
          PortConnectionWrapper ss) :
+  command(0),
   mem(0),
   memSize(0),
+  overlayFD(-1),
+  writeEnable(false),
   MISO(miso.getInterface()),
   SCLKProxy(*this, &SPIFlash::seeSCLKChange),
   SSProxy(*this, &SPIFlash::seeSSChange),
@@ -83,12 +189,34 @@ SPIFlash(RunnableQueue &scheduler, PortConnectionWrapper miso,
 
 SPIFlash::~SPIFlash()
 {
-  delete[] mem;
+  closeFile();
+  closeOverlay();
+}
+
+void SPIFlash::closeFile()
+{
+  if (mem) {
+#ifdef _WIN32
+    delete[] mem;
+#else
+    munmap(mem, memSize);
+#endif
+  }
+  mem = 0;
+  memSize = 0;
+}
+
+void SPIFlash::closeOverlay()
+{
+  if (overlayFD >= 0)
+    close(overlayFD);
+  overlayFD = -1;
 }
 
 void SPIFlash::reset()
 {
   state = WAIT_FOR_CMD;
+  command = 0;
   receiveReg = 0;
   receivedBits = 0;
   receivedAddressBytes = 0;
@@ -97,6 +225,83 @@ void SPIFlash::reset()
   sendBitsRemaining = 0;
 }
 
+void SPIFlash::seeByte(uint8_t value)
+{
+  switch (state) {
+  case WAIT_FOR_CMD:
+    command = value;
+    switch (command) {
+    default:
+      state = UNKNOWN_CMD;
+      break;
+    case CMD_READ:
+    case CMD_FAST_READ:
+    case CMD_PAGE_PROGRAM:
+    case CMD_SECTOR_ERASE:
+    case CMD_BLOCK_ERASE:
+      state = WAIT_FOR_ADDRESS;
+      break;
+    case CMD_READ_STATUS:
+      state = READ_STATUS;
+      break;
+    case CMD_WRITE_ENABLE:
+    case CMD_WRITE_DISABLE:
+    case CMD_CHIP_ERASE:
+    case CMD_CHIP_ERASE_ALT:
+      state = WAIT_FOR_DESELECT;
+      break;
+    }
+    break;
+  case WAIT_FOR_ADDRESS:
+    readAddress = (readAddress << 8) | value;
+    if (++receivedAddressBytes == 3) {
+      switch (command) {
+      default:
+        state = WAIT_FOR_DESELECT;
+        break;
+      case CMD_READ:
+        state = READ;
+        break;
+      case CMD_FAST_READ:
+        state = WAIT_FOR_DUMMY;
+        break;
+      case CMD_PAGE_PROGRAM:
+        state = writeEnable ? PROGRAM : UNKNOWN_CMD;
+        break;
+      }
+    }
+    break;
+  case WAIT_FOR_DUMMY:
+    state = READ;
+    break;
+  case PROGRAM:
+    if (mem) {
+      // Programming can only clear bits. The address wraps within the page.
+      uint32_t address = readAddress % memSize;
+      mem[address] &= value;
+      markDirty(address, 1);
+      readAddress = (readAddress & ~(PAGE_SIZE - 1)) |
+                    ((readAddress + 1) & (PAGE_SIZE - 1));
+    }
+    break;
+  case READ:
+  case READ_STATUS:
+  case WAIT_FOR_DESELECT:
+  case UNKNOWN_CMD:
+    // Do nothing.
+    break;
+  }
+}
+
+uint8_t SPIFlash::getNextSendByte()
+{
+  if (state == READ_STATUS)
+    return writeEnable ? STATUS_WEL : 0;
+  if (!mem)
+    return 0;
+  return mem[readAddress++ % memSize];
+}
+
 void SPIFlash::seeSCLKChange(const Signal &value, ticks_t time)
 {
   unsigned newValue = value.getValue(time);
@@ -109,32 +314,16 @@ void SPIFlash::seeSCLKChange(const Signal &value, ticks_t time)
     // Rising edge.
     receiveReg = (receiveReg << 1) | MOSITracker.getSignal().getValue(time);
     if (++receivedBits == 8) {
-      switch (state) {
-      case WAIT_FOR_CMD:
-        if (receiveReg == 0x3)
-          state = WAIT_FOR_ADDRESS;
-        else
-          state = UNKNOWN_CMD;
-        break;
-      case WAIT_FOR_ADDRESS:
-        readAddress = (readAddress << 8) | receiveReg;
-        if (++receivedAddressBytes == 3) {
-          state = READ;
-        }
-      case READ:
-      case UNKNOWN_CMD:
-        // Do nothing.
-        break;
-      }
+      seeByte(receiveReg);
       receiveReg = 0;
       receivedBits = 0;
     }
   } else {
     // Falling edge.
-    if (state == READ) {
+    if (state == READ || state == READ_STATUS) {
       // Output
-      if (mem && sendBitsRemaining == 0) {
-        sendReg = mem[readAddress++ % memSize];
+      if (sendBitsRemaining == 0) {
+        sendReg = getNextSendByte();
         sendBitsRemaining = 8;
       }
       unsigned newValue = (sendReg >> 7) & 1;
@@ -154,18 +343,114 @@ void SPIFlash::seeSSChange(const Signal &value, ticks_t time)
   if (newValue == SSValue)
     return;
   SSValue = newValue;
-  if (SSValue == 1)
+  if (SSValue == 1) {
+    finishCommand();
     reset();
+  }
 }
 
-void SPIFlash::openFile(const std::string &s)
+void SPIFlash::finishCommand()
 {
-  delete[] mem;
+  // Commands other than page program only take effect if the device is
+  // deselected after a whole number of bytes.
+  bool complete = state == WAIT_FOR_DESELECT && receivedBits == 0;
+  switch (command) {
+  default:
+    break;
+  case CMD_WRITE_ENABLE:
+    if (complete)
+      writeEnable = true;
+    break;
+  case CMD_WRITE_DISABLE:
+    if (complete)
+      writeEnable = false;
+    break;
+  case CMD_PAGE_PROGRAM:
+    // Programs and erases complete instantly and clear the write enable
+    // latch.
+    if (state == PROGRAM)
+      writeEnable = false;
+    break;
+  case CMD_SECTOR_ERASE:
+    if (complete && writeEnable) {
+      erase(readAddress & ~(SECTOR_SIZE - 1), SECTOR_SIZE);
+      writeEnable = false;
+    }
+    break;
+  case CMD_BLOCK_ERASE:
+    if (complete && writeEnable) {
+      erase(readAddress & ~(BLOCK_SIZE - 1), BLOCK_SIZE);
+      writeEnable = false;
+    }
+    break;
+  case CMD_CHIP_ERASE:
+  case CMD_CHIP_ERASE_ALT:
+    if (complete && writeEnable) {
+      erase(0, memSize);
+      writeEnable = false;
+    }
+    break;
+  }
+  writeBackDirtySectors();
+}
+
+void SPIFlash::erase(uint32_t address, unsigned size)
+{
+  if (!mem || address >= memSize)
+    return;
+  size = std::min(size, memSize - address);
+  std::memset(&mem[address], 0xff, size);
+  markDirty(address, size);
+}
+
+void SPIFlash::markDirty(uint32_t address, unsigned size)
+{
+  if (overlayFD < 0)
+    return;
+  for (unsigned sector = address / SECTOR_SIZE,
+       end = (address + size - 1) / SECTOR_SIZE; sector <= end; ++sector) {
+    uint8_t bit = 1 << (sector % 8);
+    if (dirtySectors[sector / 8] & bit)
+      continue;
+    dirtySectors[sector / 8] |= bit;
+    dirtySectorList.push_back(sector);
+  }
+}
+
+void SPIFlash::writeBackDirtySectors()
+{
+  if (overlayFD < 0)
+    return;
+  for (unsigned sector : dirtySectorList) {
+    uint8_t bit = 1 << (sector % 8);
+    dirtySectors[sector / 8] &= ~bit;
+    off_t offset = off_t(sector) * SECTOR_SIZE;
+    size_t size = std::min<size_t>(SECTOR_SIZE, memSize - offset);
+    overlayBitmap[sector / 8] |= bit;
+    if (!writeAt(overlayFD, &mem[offset], size, offset) ||
+        !writeAt(overlayFD, &overlayBitmap[sector / 8], 1,
+                 memSize + sector / 8)) {
+      // The flash contents seen by the simulation are still correct, they
+      // just won't persist.
+      std::cerr << "Warning: failed to write \"" << overlayName << "\": "
+                << std::strerror(errno) << ", further changes to the flash "
+                << "will not be saved\n";
+      closeOverlay();
+      break;
+    }
+  }
+  dirtySectorList.clear();
+}
+
+bool SPIFlash::openFile(const std::string &s)
+{
+  closeFile();
+#ifdef _WIN32
   std::ifstream file(s.c_str(),
                      std::ios::in|std::ios::binary|std::ios::ate);
   if (!file) {
     std::cerr << "Error opening \"" << s << "\"\n";
-    std::exit(1);
+    return false;
   }
   memSize = file.tellg();
   mem = new uint8_t[memSize];
@@ -173,9 +458,75 @@ void SPIFlash::openFile(const std::string &s)
   file.read(reinterpret_cast<char*>(mem), memSize);
   if (!file) {
     std::cerr << "Error reading \"" << s << "\"\n";
-    std::exit(1);
+    return false;
+  }
+#else
+  int fd = open(s.c_str(), O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) != 0) {
+    std::cerr << "Error opening \"" << s << "\"\n";
+    if (fd >= 0)
+      close(fd);
+    return false;
+  }
+  if (st.st_size != 0) {
+    // Changes to a private mapping are never written to the file.
+    void *addr = mmap(0, st.st_size, PROT_READ|PROT_WRITE, MAP_PRIVATE, fd,
+                      0);
+    if (addr == MAP_FAILED) {
+      std::cerr << "Error reading \"" << s << "\"\n";
+      close(fd);
+      return false;
+    }
+    mem = static_cast<uint8_t*>(addr);
+    memSize = st.st_size;
   }
-  file.close();
+  close(fd);
+#endif
+  return true;
+}
+
+bool SPIFlash::openOverlay(const std::string &s)
+{
+  overlayName = s;
+  overlayFD = open(s.c_str(), O_RDWR|O_CREAT|O_BINARY, 0666);
+  struct stat st;
+  if (overlayFD < 0 || fstat(overlayFD, &st) != 0) {
+    std::cerr << "Error opening \"" << s << "\"\n";
+    return false;
+  }
+  unsigned numSectors = getNumSectors();
+  overlayBitmap.assign((numSectors + 7) / 8, 0);
+  dirtySectors.assign(overlayBitmap.size(), 0);
+  off_t size = off_t(memSize) + overlayBitmap.size();
+  if (st.st_size == 0) {
+    if (!resizeFile(overlayFD, size)) {
+      std::cerr << "Error writing \"" << s << "\"\n";
+      return false;
+    }
+    return true;
+  }
+  if (st.st_size != size) {
+    std::cerr << "Error: overlay \"" << s << "\" doesn't match the size of "
+              << "the flash image\n";
+    return false;
+  }
+  if (!readAt(overlayFD, &overlayBitmap[0], overlayBitmap.size(), memSize)) {
+    std::cerr << "Error reading \"" << s << "\"\n";
+    return false;
+  }
+  // Copy the sectors from the overlay over the image.
+  for (unsigned sector = 0; sector < numSectors; ++sector) {
+    if (!(overlayBitmap[sector / 8] & (1 << (sector % 8))))
+      continue;
+    off_t offset = off_t(sector) * SECTOR_SIZE;
+    size_t sectorSize = std::min<size_t>(SECTOR_SIZE, memSize - offset);
+    if (!readAt(overlayFD, &mem[offset], sectorSize, offset)) {
+      std::cerr << "Error reading \"" << s << "\"\n";
+      return false;
+    }
+  }
+  return true;
 }
 
 static Peripheral *
@@ -187,9 +538,14 @@ createSPIFlash(SystemState &system, PortConnectionManager &connectionManager,
   PortConnectionWrapper SCLK = connectionManager.get(properties, "sclk");
   PortConnectionWrapper SS = connectionManager.get(properties, "ss");
   std::string file = properties.get("filename")->getAsString();
-  SPIFlash *p = new SPIFlash(system.getScheduler(), MISO, MOSI, SCLK, SS);
-  p->openFile(file);
-  return p;
+  std::unique_ptr<SPIFlash> p(
+    new SPIFlash(system.getScheduler(), MISO, MOSI, SCLK, SS));
+  if (!p->openFile(file))
+    return nullptr;
+  const Property *overlay = properties.get("overlay");
+  if (overlay && !p->openOverlay(overlay->getAsString()))
+    return nullptr;
+  return p.release();
 }
 
 std::unique_ptr<PeripheralDescriptor> axe::getPeripheralDescriptorSPIFlash()
@@ -202,5 +558,6 @@ std::unique_ptr<PeripheralDescriptor> axe::getPeripheralDescriptorSPIFlash()
   p->addProperty(PropertyDescriptor::portProperty("ss")).setRequired(true);
   p->addProperty(PropertyDescriptor::stringProperty("filename"))
     .setRequired(true);
+  p->addProperty(PropertyDescriptor::stringProperty("overlay"));
   return p;
 }
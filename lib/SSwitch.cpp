@@ -123,6 +123,7 @@ void SSwitch::handleRequest(ticks_t time, const Request &request)
   }
   if (junkPacket)
     return;
+  parent->countPacketSent(destID);
   sendingResponse = true;
   sentTokens = 0;
   responseLength = 0;
@@ -139,6 +140,8 @@ void SSwitch::handleRequest(ticks_t time, const Request &request)
   if (!dest->canAcceptTokens(responseLength)) {
     assert(0 && "TODO");
   }
+  ++stats.packetsSent;
+  stats.tokensSent += responseLength;
   for (unsigned i = 0; i < responseLength; i++) {
     if (buf[i].isControl()) {
       dest->receiveCtrlToken(time, buf[i].getValue());
@@ -173,6 +176,7 @@ bool SSwitch::canAcceptTokens(unsigned tokens)
 
 void SSwitch::receiveDataToken(ticks_t time, uint8_t value)
 {
+  ++stats.tokensReceived;
   if (junkIncomingTokens) {
     return;
   }
@@ -185,6 +189,7 @@ void SSwitch::receiveDataToken(ticks_t time, uint8_t value)
 
 void SSwitch::receiveDataTokens(ticks_t time, uint8_t *values, unsigned num)
 {
+  stats.tokensReceived += num;
   if (junkIncomingTokens) {
     return;
   }
@@ -199,6 +204,7 @@ void SSwitch::receiveDataTokens(ticks_t time, uint8_t *values, unsigned num)
 
 void SSwitch::receiveCtrlToken(ticks_t time, uint8_t value)
 {
+  ++stats.tokensReceived;
   switch (value) {
   case CT_END:
     Request request;
@@ -37,3 +37,10 @@ StopReason StopReason::getExit(ticks_t time, int status)
   retval.status = status;
   return retval;
 }
+
+StopReason StopReason::getPredicate(ticks_t time, unsigned predicate)
+{
+  StopReason retval(PREDICATE, time);
+  retval.predicate = predicate;
+  return retval;
+}
@@ -20,7 +20,8 @@ public:
     WATCHPOINT,
     TIMEOUT,
     EXIT,
-    NO_RUNNABLE_THREADS
+    NO_RUNNABLE_THREADS,
+    PREDICATE
   };
 private:
   Type type;
@@ -28,6 +29,7 @@ private:
   union {
     Thread *thread;
     int status;
+    unsigned predicate;
   };
   StopReason(Type ty, ticks_t t) : type(ty), time(t) {}
 public:
@@ -41,12 +43,17 @@ public:
     assert(type == EXIT);
     return status;
   }
+  unsigned getPredicate() const {
+    assert(type == PREDICATE);
+    return predicate;
+  }
 
   static StopReason getTimeout(ticks_t time);
   static StopReason getBreakpoint(ticks_t time, Thread &thread);
   static StopReason getWatchpoint(ticks_t time, Thread &thread);
   static StopReason getExit(ticks_t time, int status);
   static StopReason getNoRunnableThreads(ticks_t time);
+  static StopReason getPredicate(ticks_t time, unsigned predicate);
 };
 
 } // End axe namespace
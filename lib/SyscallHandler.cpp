@@ -6,6 +6,7 @@
 #include "Exceptions.h"
 #include "Core.h"
 #include "SyscallHandler.h"
+#include "ConsoleSink.h"
 #include <cstdio>
 #include <cstdlib>
 #include <ctime>
@@ -92,8 +93,8 @@ defaultDescribeExceptionCallback(const Thread &, uint32_t, uint32_t,
   return false;
 }
 
-SyscallHandler::SyscallHandler() :
-  fds(new int[MAX_FDS]), doneSyscallsRequired(1),
+SyscallHandler::SyscallHandler(ConsoleSink &c) :
+  fds(new int[MAX_FDS]), console(c), doneSyscallsRequired(1),
   loadImageCallback(&defaultLoadImageCallback),
   describeExceptionCallback(&defaultDescribeExceptionCallback)
 {
@@ -101,6 +102,12 @@ SyscallHandler::SyscallHandler() :
   fds[0] = dup(STDIN_FILENO);
   fds[1] = dup(STDOUT_FILENO);
   fds[2] = dup(STDERR_FILENO);
+  consoleSources[0] = 0;
+  useConsole[0] = false;
+  for (unsigned i = 1; i < 3; i++) {
+    consoleSources[i] = console.addSource(fds[i]);
+    useConsole[i] = true;
+  }
 
   for (unsigned i = 3; i<6; i++) {
     fds[i] = 0;
@@ -150,8 +157,8 @@ getBuffer(Thread &thread, uint32_t address, uint32_t size)
   return core.memPtr(address);
 }
 
-/// Returns a pointer to a buffer in memory of the given size.
-/// Returns 0 if the buffer address is invalid.
+/// Returns a pointer to a buffer in memory of the given size that is about to
+/// be written. Returns 0 if the buffer address is invalid.
 void *SyscallHandler::
 getRamBuffer(Thread &thread, uint32_t address, uint32_t size)
 {
@@ -159,6 +166,7 @@ getRamBuffer(Thread &thread, uint32_t address, uint32_t size)
   if (!core.isValidRamAddress(address) ||
       !core.isValidRamAddress(address + size))
     return 0;
+  core.markWritten(address, address + size);
   return core.ramBytePtr(address);
 }
 
@@ -232,6 +240,7 @@ bool SyscallHandler::convertLseekType(int whence, int &converted)
 
 void SyscallHandler::doException(const Thread &thread, uint32_t et, uint32_t ed)
 {
+  console.flush();
   std::cout << "Unhandled exception: ";
   std::string description;
   if (describeExceptionCallback(thread, et, ed, description)) {
@@ -335,6 +344,10 @@ SyscallHandler::SycallOutcome SyscallHandler::doOsCallClose(Thread &thread, int
     thread.regs[R0] = (uint32_t)-1;
     return SyscallHandler::CONTINUE;
   }
+  if (thread.regs[R1] < 3 && useConsole[thread.regs[R1]]) {
+    console.flush();
+    useConsole[thread.regs[R1]] = false;
+  }
   int close_retval = close(fds[thread.regs[R1]]);
   if (close_retval == 0) {
     fds[thread.regs[R1]] = (uint32_t)-1;
@@ -356,6 +369,8 @@ SyscallHandler::SycallOutcome SyscallHandler::doOsCallRead(Thread &thread, int &
     thread.regs[R0] = (uint32_t)-1;
     return SyscallHandler::CONTINUE;
   }
+  // Make sure any prompt is visible before waiting for input.
+  console.flush();
   thread.regs[R0] = read(fds[thread.regs[R1]], buf, thread.regs[R3]);
   return SyscallHandler::CONTINUE;
 }
@@ -373,6 +388,13 @@ SyscallHandler::SycallOutcome SyscallHandler::doOsCallWrite(Thread &thread, int
     thread.regs[R0] = (uint32_t)-1;
     return SyscallHandler::CONTINUE;
   }
+  if (thread.regs[R1] < 3 && useConsole[thread.regs[R1]]) {
+    console.output(consoleSources[thread.regs[R1]],
+                   static_cast<const char*>(buf), thread.regs[R3],
+                   thread.time);
+    thread.regs[R0] = thread.regs[R3];
+    return SyscallHandler::CONTINUE;
+  }
   thread.regs[R0] = write(fds[thread.regs[R1]], buf, thread.regs[R3]);
   return SyscallHandler::CONTINUE;
 }
@@ -457,6 +479,7 @@ SyscallHandler::SycallOutcome SyscallHandler::doOsCallSystem(Thread &thread, int
       return SyscallHandler::CONTINUE;
     }
   }
+  console.flush();
   thread.regs[R0] = std::system(command);
   return SyscallHandler::CONTINUE;
 }
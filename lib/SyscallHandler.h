@@ -14,11 +14,19 @@
 
 namespace axe {
 
+class ConsoleSink;
 class Core;
 
 class SyscallHandler {
 private:
   const std::unique_ptr<int[]> fds;
+  ConsoleSink &console;
+  /// Console source for the standard output and error of the client, indexed
+  /// by file descriptor.
+  unsigned consoleSources[3];
+  /// Whether writes to the standard output and error of the client go through
+  /// the console, indexed by file descriptor.
+  bool useConsole[3];
   std::set<Core*> doneSyscallsSeen;
   unsigned doneSyscallsRequired;
   struct {
@@ -43,7 +51,7 @@ public:
     CONTINUE,
     EXIT
   };
-  SyscallHandler();
+  SyscallHandler(ConsoleSink &console);
   
   void setCmdLine(int clientArgc, char **clientArgv);
   void setDoneSyscallsRequired(unsigned count);
@@ -19,6 +19,9 @@ using namespace Register;
 
 SystemState::SystemState(std::unique_ptr<Tracer> t) :
   currentRunnable(0),
+  timerWheel(scheduler),
+  runPredicates(*this),
+  xlinkModel(scheduler),
   rom(0),
   tracer(std::move(t))
 {
@@ -119,8 +122,10 @@ StopReason SystemState::run()
       runnable.run(runnable.wakeUpTime);
     }
   } catch (ExitException &ee) {
+    consoleSink.flush();
     return StopReason::getExit(ee.getTime(), ee.getStatus());
   } catch (TimeoutException &te) {
+    consoleSink.flush();
     if (scheduler.empty()) {
       if (tracer.get())
         tracer->noRunnableThreads(*this);
@@ -134,10 +139,16 @@ StopReason SystemState::run()
       exitTracer->timeout(*this, te.getTime());
     return StopReason::getTimeout(te.getTime());
   } catch (BreakpointException &be) {
+    consoleSink.flush();
     return StopReason::getBreakpoint(be.getTime(), be.getThread());
   } catch (WatchpointException &we) {
+    consoleSink.flush();
     return StopReason::getWatchpoint(we.getTime(), we.getThread());
+  } catch (PredicateException &pe) {
+    consoleSink.flush();
+    return StopReason::getPredicate(pe.getTime(), pe.getPredicate());
   }
+  consoleSink.flush();
   if (tracer.get())
     tracer->noRunnableThreads(*this);
   if (exitTracer.get())
@@ -12,7 +12,11 @@
 #include "JIT.h"
 #include "RunnableQueue.h"
 #include "Timeout.h"
+#include "TimerWheel.h"
+#include "RunPredicates.h"
 #include "SymbolInfo.h"
+#include "ConsoleSink.h"
+#include "XLinkModel.h"
 
 namespace axe {
 
@@ -54,6 +58,14 @@ public:
   Thread &getThread() const { return thread; }
 };
 
+class PredicateException : public StopException {
+  unsigned predicate;
+public:
+  PredicateException(ticks_t time, unsigned p) :
+    StopException(time), predicate(p) {}
+  unsigned getPredicate() const { return predicate; }
+};
+
 class SystemState {
   std::vector<Node*> nodes;
   RunnableQueue scheduler;
@@ -61,7 +73,11 @@ class SystemState {
   Runnable *currentRunnable;
   PendingEvent pendingEvent;
   Timeout timeoutRunnable;
+  TimerWheel timerWheel;
+  RunPredicates runPredicates;
   SymbolInfo symbolInfo;
+  ConsoleSink consoleSink;
+  XLinkModel xlinkModel;
 
   uint8_t *rom;
   std::unique_ptr<DecodeCache> romDecodeCache;
@@ -86,6 +102,9 @@ public:
 
   void finalize();
   RunnableQueue &getScheduler() { return scheduler; }
+  TimerWheel &getTimerWheel() { return timerWheel; }
+  ConsoleSink &getConsoleSink() { return consoleSink; }
+  XLinkModel &getXLinkModel() { return xlinkModel; }
   void addNode(std::unique_ptr<Node> n);
 
   SymbolInfo &getSymbolInfo() { return symbolInfo; }
@@ -97,6 +116,8 @@ public:
 
   ticks_t getLatestThreadTime() const;
 
+  RunPredicates &getRunPredicates() { return runPredicates; }
+
   void setTimeout(ticks_t time);
   void clearTimeout();
 
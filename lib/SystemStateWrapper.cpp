@@ -5,12 +5,18 @@
 
 #include "SystemStateWrapper.h"
 #include "SystemState.h"
+#include "ProcessorNode.h"
+#include "Core.h"
+#include <algorithm>
+#include <cstring>
 
 using namespace axe;
 
 SystemStateWrapper::
 SystemStateWrapper(std::unique_ptr<SystemState> s) :
-  system(std::move(s)), lastBreakpointThread(0), lastExitStatus(0), lastStopTime(0) {
+  system(std::move(s)), lastBreakpointThread(0), lastExitStatus(0), lastPredicate(0),
+  lastStopTime(0),
+  trackMemoryChanges(false) {
   
 }
 
@@ -20,6 +26,8 @@ StopReason::Type SystemStateWrapper::run(ticks_t numCycles) {
   } else {
     system->setTimeout(lastStopTime + numCycles);
   }
+  if (trackMemoryChanges)
+    clearWrittenGranules();
   StopReason stopReason = system->run();
   lastStopTime = stopReason.getTime();
   switch (stopReason.getType()) {
@@ -31,6 +39,60 @@ StopReason::Type SystemStateWrapper::run(ticks_t numCycles) {
   case StopReason::EXIT:
     lastExitStatus = stopReason.getStatus();
     break;
+  case StopReason::PREDICATE:
+    lastPredicate = stopReason.getPredicate();
+    break;
   }
   return stopReason.getType();
 }
+
+static_assert(SystemStateWrapper::CHANGED_MEMORY_GRANULE ==
+              1 << Core::WRITE_GRANULE_LOG2,
+              "Changed memory granule doesn't match the core");
+
+void SystemStateWrapper::setTrackWrites(bool enable)
+{
+  for (Node *node : system->getNodes()) {
+    if (!node->isProcessorNode())
+      continue;
+    for (Core *core : static_cast<ProcessorNode*>(node)->getCores())
+      core->setTrackWrites(enable);
+  }
+}
+
+void SystemStateWrapper::clearWrittenGranules()
+{
+  for (Node *node : system->getNodes()) {
+    if (!node->isProcessorNode())
+      continue;
+    for (Core *core : static_cast<ProcessorNode*>(node)->getCores())
+      core->clearWrittenGranules();
+  }
+}
+
+void SystemStateWrapper::setTrackMemoryChanges(bool enable)
+{
+  trackMemoryChanges = enable;
+  setTrackWrites(enable);
+}
+
+bool SystemStateWrapper::
+getChangedMemory(Core &core,
+                 std::vector<std::pair<uint32_t,uint32_t>> &ranges)
+{
+  if (!trackMemoryChanges)
+    return false;
+  const std::vector<uint8_t> &written = core.getWrittenGranules();
+  for (uint32_t i = 0, e = written.size(); i != e; ++i) {
+    if (!written[i])
+      continue;
+    uint32_t address = core.getRamBase() + i * CHANGED_MEMORY_GRANULE;
+    if (!ranges.empty() &&
+        ranges.back().first + ranges.back().second == address) {
+      ranges.back().second += CHANGED_MEMORY_GRANULE;
+    } else {
+      ranges.push_back(std::make_pair(address, CHANGED_MEMORY_GRANULE));
+    }
+  }
+  return true;
+}
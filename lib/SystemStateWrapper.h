@@ -9,23 +9,44 @@
 #include "StopReason.h"
 #include "Config.h"
 #include <memory>
+#include <vector>
 
 namespace axe {
 
 class SystemState;
 class Thread;
+class Core;
 
 class SystemStateWrapper {
   std::unique_ptr<SystemState> system;
   Thread *lastBreakpointThread;
   int lastExitStatus;
+  unsigned lastPredicate;
   ticks_t lastStopTime;
+  bool trackMemoryChanges;
+  void setTrackWrites(bool enable);
+  void clearWrittenGranules();
 public:
+  enum {
+    /// Granularity in bytes of the ranges returned by getChangedMemory().
+    CHANGED_MEMORY_GRANULE = 64
+  };
   SystemStateWrapper(std::unique_ptr<SystemState> s);
   SystemState *getSystemState() { return system.get(); }
   Thread *getThreadForLastBreakpoint() { return lastBreakpointThread; }
   int getLastExitStatus() const { return lastExitStatus; }
+  unsigned getLastPredicate() const { return lastPredicate; }
   StopReason::Type run(ticks_t numCycles);
+  /// Enable or disable tracking of the memory written between the simulation
+  /// being resumed and stopping.
+  void setTrackMemoryChanges(bool enable);
+  /// Get the ranges of the core's RAM that were written while the simulation
+  /// was last run as (address, length) pairs. Ranges are aligned to
+  /// CHANGED_MEMORY_GRANULE and may include granules that were written with
+  /// the value they already held. Returns false if memory changes aren't
+  /// tracked.
+  bool getChangedMemory(Core &core,
+                        std::vector<std::pair<uint32_t,uint32_t>> &ranges);
 };
 
 } // End namespace axe
@@ -18,8 +18,10 @@
 #include "ClockBlock.h"
 #include "InstructionOpcode.h"
 #include "InstructionProperties.h"
+#include <algorithm>
 #include <iostream>
 #include <cstdlib>
+#include <iterator>
 #include "Compiler.h"
 
 using namespace axe;
@@ -30,20 +32,16 @@ Thread::Thread() :
   parent(0),
   scheduler(0),
   dualIssue(false),
-  regs(Register::NUM_REGISTERS, 0),
-  regsBuffer(Register::NUM_REGISTERS, 0),
-  bufferInitialized(true)
+  numPendingRegWrites(0),
+  pendingRegMask(0)
 {
+  static_assert(Register::NUM_REGISTERS <= 32,
+                "pendingRegMask must have a bit per register");
   time = 0;
   pc = 0;
   instructionCounter = 0;
 
-  regs[KEP] = 0;
-  regs[KSP] = 0;
-  regs[SPC] = 0;
-  regs[SED] = 0;
-  regs[ET] = 0;
-  regs[ED] = 0;
+  std::fill(std::begin(regs), std::end(regs), 0);
   eeble() = false;
   ieble() = false;
   setInUse(false);
@@ -51,17 +49,11 @@ Thread::Thread() :
 
 void Thread::setDualIssue (bool di)
 {
-  // Bug in RETSP caused the write to the SP to be ignored.
-  // 1. RETSP enters; dual issue is true and bufferInitialized is true
-  // 2. RETSP turns off dual issue mode.
-  // 3. RETSP writes SP directly because 'dualIssue == false'
-  // 4. Next instruction swaps reg buffers because bufferInitialized is true
-  if (dualIssue && !di) {
-    if (bufferInitialized) {
-      regs.swap(regsBuffer);
-      bufferInitialized = false;
-    }
-  }
+  // Commit pending writes before leaving dual issue mode, otherwise writes
+  // made after the switch (e.g. RETSP writing the SP) would be overwritten
+  // when the pending writes are committed.
+  if (dualIssue && !di)
+    doPendingRegWrites();
 
   dualIssue = di;
 }
@@ -71,23 +63,13 @@ bool Thread::isDualIssue () const
   return dualIssue;
 }
 
-void Thread::writeRegister (int index, uint32_t value)
-{
-  if (!dualIssue) {
-    regs[index] = value;
-  } else {
-    if (!bufferInitialized) {
-      regsBuffer = regs;
-      bufferInitialized = true;
-    }
-    regsBuffer[index] = value;
-  }
-}
-
 uint32_t Thread::readRegisterForTrace (int index) const
 {
-  if (bufferInitialized) {
-    return regsBuffer[index];
+  if (pendingRegMask & (1U << index)) {
+    for (unsigned i = 0; i < numPendingRegWrites; i++) {
+      if (pendingRegWrites[i].index == unsigned(index))
+        return pendingRegWrites[i].value;
+    }
   }
   return regs[index];
 }
@@ -113,8 +95,7 @@ void Thread::seeRamDecodeCacheChange()
 
 void Thread::runJIT(uint32_t pc)
 {
-  if (isInRam())
-    getParent().runJIT(pc);
+  getParent().runJIT(decodeCache, pc);
 }
 
 void Thread::dump() const
@@ -140,6 +121,14 @@ uint32_t Thread::getReferenceTime () const
   return (uint32_t)((double)time / parent->getParent()->getReferenceDivide());
 }
 
+bool Thread::free()
+{
+  setInUse(false);
+  getParent().getParent()->getParent()->getRunPredicates()
+    .seeThreadFreed(getParent(), time);
+  return true;
+}
+
 void Thread::schedule()
 {
   getParent().getParent()->getParent()->schedule(*this);
@@ -209,8 +198,7 @@ void Thread::setPcFromAddress(uint32_t address)
 
 uint32_t Thread::getRealPc() const
 {
-  if (pc == parent->getInterpretOneAddr() ||
-      pc == parent->getRunJitAddr())
+  if (pc == getInterpretOneAddr() || pc == getRunJitAddr())
     return fromPc(pendingPc);
   return fromPc(pc);
 }
@@ -514,16 +502,22 @@ InstReturn Instruction_TSETMR_2r(Thread &thread) {
 }
 
 template<bool tracing> InstReturn Instruction_RUN_JIT(Thread &thread) {
-  CORE.runJIT(THREAD.pendingPc);
+  THREAD.runJIT(THREAD.pendingPc);
   THREAD.pc = THREAD.pendingPc;
   return InstReturn::END_TRACE;
 }
 
 template<bool tracing> InstReturn Instruction_BREAKPOINT(Thread &thread) {
+  if (!CORE.shouldStopAtBreakpoint(THREAD, THREAD.fromPc(THREAD.pc))) {
+    // The condition isn't met so execute the instruction and carry on.
+    THREAD.pendingPc = THREAD.pc;
+    THREAD.pc = THREAD.getInterpretOneAddr();
+    return InstReturn::CONTINUE;
+  }
   // Arrange for the current instruction to be interpreted so we don't hit the
   // breakpoint again when continuing.
   THREAD.pendingPc = THREAD.pc;
-  THREAD.pc = CORE.getInterpretOneAddr();
+  THREAD.pc = THREAD.getInterpretOneAddr();
   THREAD.waiting() = true;
   THREAD.schedule();
   throw (BreakpointException(TIME, THREAD));
@@ -552,13 +546,17 @@ static OPCODE_TYPE opcodeMapTracing[] = {
 #undef EMIT_INSTRUCTION_LIST
 };
 
+#define EMIT_SPECIALISED_INSTRUCTION_TABLE
+#include "InstructionGenOutput.inc"
+#undef EMIT_SPECIALISED_INSTRUCTION_TABLE
+
 template<bool tracing> InstReturn Instruction_DECODE(Thread &thread) {
   InstructionOpcode opc;
   Operands ops;
   uint32_t address = THREAD.fromPc(THREAD.pc);
   instructionDecode(CORE, address, opc, ops);
   instructionTransform(opc, ops, CORE, address, thread.isDualIssue());
-  THREAD.setOpcode(THREAD.pc, (tracing ? opcodeMapTracing : opcodeMap)[opc], ops,
+  THREAD.setOpcode(THREAD.pc, getInstructionFunction(opc, ops, tracing), ops,
                    instructionProperties[opc].size);
   return InstReturn::END_TRACE;
 }
@@ -587,7 +585,7 @@ InstReturn Thread::interpretOne()
 
 InstReturn Thread::singleStep()
 {
-  if (pc == parent->getInterpretOneAddr() || pc == parent->getRunJitAddr())
+  if (pc == getInterpretOneAddr() || pc == getRunJitAddr())
     pc = pendingPc;
   InstReturn K = interpretOne();
   SystemState *sys = getParent().getParent()->getParent();
@@ -605,17 +603,17 @@ InstReturn Thread::singleStep()
 }
 
 void Thread::getNextPC() {
-  if (pc == parent->getInterpretOneAddr() || pc == parent->getRunJitAddr())
+  if (pc == getInterpretOneAddr() || pc == getRunJitAddr())
     pc = pendingPc + 1;
   else
     pc++;
 }
 
-void Thread::doPendingRegWrites() {
-  if (bufferInitialized) {
-    regs.swap(regsBuffer);
-    bufferInitialized = false;
-  }
+void Thread::commitPendingRegWrites() {
+  for (unsigned i = 0; i < numPendingRegWrites; i++)
+    regs[pendingRegWrites[i].index] = pendingRegWrites[i].value;
+  numPendingRegWrites = 0;
+  pendingRegMask = 0;
 }
 
 void Thread::run(ticks_t time)
@@ -631,6 +629,15 @@ void Thread::run(ticks_t time)
   }
 }
 
+OPCODE_TYPE axe::getInstructionFunction(InstructionOpcode opc,
+                                        const Operands &ops, bool tracing) {
+  if (tracing)
+    return opcodeMapTracing[opc];
+  if (OPCODE_TYPE specialised = getSpecialisedInstruction(opc, ops))
+    return specialised;
+  return opcodeMap[opc];
+}
+
 OPCODE_TYPE axe::getInstruction_DECODE(bool tracing) {
   if (tracing)
     return &Instruction_DECODE<true>;
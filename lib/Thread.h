@@ -106,10 +106,18 @@ public:
   };
   typedef std::bitset<11> sr_t;
   bool dualIssue;
-  std::vector<uint32_t> regs;
-  // Buffer register writes in dual issue mode
-  std::vector<uint32_t> regsBuffer;
-  bool bufferInitialized;
+  uint32_t regs[Register::NUM_REGISTERS];
+  struct PendingRegWrite {
+    uint32_t index;
+    uint32_t value;
+  };
+  /// Register writes made in dual issue mode. These are committed to the
+  /// register file at the end of the bundle. Each register appears at most
+  /// once.
+  PendingRegWrite pendingRegWrites[Register::NUM_REGISTERS];
+  unsigned numPendingRegWrites;
+  /// Bitmask of the registers with an entry in pendingRegWrites.
+  uint32_t pendingRegMask;
   /// The program counter. Note that the pc will not be valid if the thread is
   /// executing since it is cached in the dispatch loop.
   uint32_t pc;
@@ -134,8 +142,39 @@ public:
   void setDualIssue (bool di);
   bool isDualIssue () const;
 
-  void writeRegister (int index, uint32_t value);
-  void doPendingRegWrites();
+  void writeRegister (int index, uint32_t value)
+  {
+    if (!dualIssue)
+      regs[index] = value;
+    else
+      logRegisterWrite(index, value);
+  }
+
+  /// Record a write to be committed at the end of the current bundle.
+  void logRegisterWrite(unsigned index, uint32_t value)
+  {
+    uint32_t bit = 1U << index;
+    if (pendingRegMask & bit) {
+      for (unsigned i = 0;; i++) {
+        if (pendingRegWrites[i].index == index) {
+          pendingRegWrites[i].value = value;
+          return;
+        }
+      }
+    }
+    pendingRegMask |= bit;
+    pendingRegWrites[numPendingRegWrites].index = index;
+    pendingRegWrites[numPendingRegWrites].value = value;
+    numPendingRegWrites++;
+  }
+
+  void doPendingRegWrites()
+  {
+    if (numPendingRegWrites != 0)
+      commitPendingRegWrites();
+  }
+
+  void commitPendingRegWrites();
 
   void addTime(ticks_t value);
 
@@ -153,11 +192,7 @@ public:
     return true;
   }
 
-  bool free() override
-  {
-    setInUse(false);
-    return true;
-  }
+  bool free() override;
 
   void setParent(Core &p);
   void getNextPC();
@@ -275,6 +310,14 @@ public:
     return decodeCache.toPc(pc);
   }
 
+  unsigned getRunJitAddr() const {
+    return decodeCache.getRunJitAddr();
+  }
+
+  unsigned getInterpretOneAddr() const {
+    return decodeCache.getInterpretOneAddr();
+  }
+
   void setOpcode(uint32_t pc, OPCODE_TYPE opc, unsigned size) {
     decodeCache.setOpcode(pc, opc, size);
   }
@@ -362,6 +405,11 @@ struct PendingEvent {
   ticks_t time;
 };
 
+/// Returns the handler used to execute the specified opcode. If there is a
+/// variant of the handler specialised on the register operands it is returned
+/// in preference to the generic handler.
+OPCODE_TYPE getInstructionFunction(InstructionOpcode opc, const Operands &ops,
+                                   bool tracing);
 OPCODE_TYPE getInstruction_DECODE(bool tracing);
 OPCODE_TYPE getInstruction_ILLEGAL_PC(bool tracing);
 OPCODE_TYPE getInstruction_ILLEGAL_PC_THREAD(bool tracing);
@@ -5,6 +5,9 @@
 
 #include "Timer.h"
 #include "Thread.h"
+#include "Core.h"
+#include "ProcessorNode.h"
+#include "SystemState.h"
 
 using namespace axe;
 
@@ -52,13 +55,19 @@ in(Thread &thread, ticks_t time, uint32_t &val)
   updateOwner(thread);
   if (!conditionMet(time)) {
     pausedIn = &thread;
-    scheduleUpdate(getEarliestReadyTime(time));
+    scheduleWakeUp(getEarliestReadyTime(time));
     return DESCHEDULE;
   }
   val = (uint32_t)(time / CYCLES_PER_TICK);
   return CONTINUE;
 }
 
+void Timer::scheduleWakeUp(ticks_t time)
+{
+  SystemState &system = *getOwner().getParent().getParent()->getParent();
+  system.getTimerWheel().schedule(wheelEntry, time);
+}
+
 ticks_t Timer::getEarliestReadyTime(ticks_t time) const
 {
   if (conditionMet(time))
@@ -87,6 +96,6 @@ bool Timer::seeEventEnable(ticks_t time)
     event(time);
     return true;
   }
-  scheduleUpdate(getEarliestReadyTime(time));
+  scheduleWakeUp(getEarliestReadyTime(time));
   return false;
 }
@@ -7,6 +7,7 @@
 #define _Timer_h_
 
 #include "Resource.h"
+#include "TimerWheel.h"
 
 namespace axe {
 
@@ -16,13 +17,17 @@ private:
   uint32_t data;
   /// Thread paused on an input instruction.
   Thread *pausedIn;
+  TimerWheel::Entry wheelEntry;
 
   /// Return whether the condition is met for the specified time.
   bool conditionMet(ticks_t time) const;
+  /// Run the timer at the time it becomes ready.
+  void scheduleWakeUp(ticks_t time);
 public:
   Timer() :
     EventableResource(RES_TYPE_TIMER),
-    pausedIn(0) {}
+    pausedIn(0),
+    wheelEntry(*this) {}
 
   bool alloc(Thread &t) override
   {
@@ -0,0 +1,147 @@
+// Copyright (c) 2012, Richard Osborne, All rights reserved
+// This software is freely distributable under a derivative of the
+// University of Illinois/NCSA Open Source License posted in
+// LICENSE.txt and at <http://github.xcore.com/>
+
+#include "TimerWheel.h"
+#include "RunnableQueue.h"
+#include "Timer.h"
+#include <algorithm>
+
+using namespace axe;
+
+static unsigned countTrailingZeros(uint64_t x)
+{
+#ifdef __GNUC__
+  return __builtin_ctzll(x);
+#else
+  unsigned i = 0;
+  for (; !(x & 1); x >>= 1)
+    i++;
+  return i;
+#endif
+}
+
+TimerWheel::TimerWheel(RunnableQueue &s) :
+  scheduler(s),
+  now(0)
+{
+  std::fill(std::begin(lists), std::end(lists), nullptr);
+  std::fill(std::begin(occupied), std::end(occupied), 0);
+}
+
+void TimerWheel::link(Entry &e)
+{
+  // Use the lowest level where the time only differs from the current time
+  // in the bits covered by the level.
+  int list = OVERFLOW_LIST;
+  for (unsigned level = 0; level < NUM_LEVELS; level++) {
+    unsigned shift = SLOT_BITS * (level + 1);
+    if ((e.time >> shift) != (now >> shift))
+      continue;
+    unsigned slot = (e.time >> (SLOT_BITS * level)) & (NUM_SLOTS - 1);
+    occupied[level] |= uint64_t(1) << slot;
+    list = level * NUM_SLOTS + slot;
+    break;
+  }
+  e.list = list;
+  e.prev = nullptr;
+  e.next = lists[list];
+  if (e.next)
+    e.next->prev = &e;
+  lists[list] = &e;
+}
+
+void TimerWheel::unlink(Entry &e)
+{
+  if (e.prev) {
+    e.prev->next = e.next;
+  } else {
+    lists[e.list] = e.next;
+    if (!e.next && e.list != OVERFLOW_LIST) {
+      occupied[e.list / NUM_SLOTS] &=
+        ~(uint64_t(1) << (e.list % NUM_SLOTS));
+    }
+  }
+  if (e.next)
+    e.next->prev = e.prev;
+  e.prev = e.next = nullptr;
+  e.list = -1;
+}
+
+int TimerWheel::getEarliestList() const
+{
+  // Every entry on a level is earlier than the entries on the levels above.
+  // Within a level, slots are ordered by time.
+  for (unsigned level = 0; level < NUM_LEVELS; level++) {
+    if (occupied[level])
+      return level * NUM_SLOTS + countTrailingZeros(occupied[level]);
+  }
+  return lists[OVERFLOW_LIST] ? OVERFLOW_LIST : -1;
+}
+
+ticks_t TimerWheel::getEarliestTime(int list) const
+{
+  ticks_t time = lists[list]->time;
+  for (Entry *e = lists[list]->next; e; e = e->next)
+    time = std::min(time, e->time);
+  return time;
+}
+
+void TimerWheel::schedule(Entry &e, ticks_t time)
+{
+  cancel(e);
+  if (time < now) {
+    // The wheel can't go back in time. This is rare so schedule the timer
+    // directly.
+    scheduler.push(e.timer, time);
+    return;
+  }
+  e.time = time;
+  link(e);
+  if (!scheduler.contains(*this) || time < wakeUpTime)
+    scheduler.push(*this, time);
+}
+
+void TimerWheel::cancel(Entry &e)
+{
+  if (e.list >= 0)
+    unlink(e);
+  else if (scheduler.contains(e.timer))
+    scheduler.remove(e.timer);
+}
+
+void TimerWheel::run(ticks_t time)
+{
+  due.clear();
+  int list;
+  while ((list = getEarliestList()) >= 0) {
+    ticks_t earliest = getEarliestTime(list);
+    if (earliest > time)
+      break;
+    // Advance to the earliest time and redistribute the entries of the list
+    // containing it to the lower levels.
+    now = earliest;
+    Entry *e = lists[list];
+    lists[list] = nullptr;
+    if (list != OVERFLOW_LIST)
+      occupied[list / NUM_SLOTS] &= ~(uint64_t(1) << (list % NUM_SLOTS));
+    while (e) {
+      Entry *next = e->next;
+      if (e->time <= time) {
+        e->prev = e->next = nullptr;
+        e->list = -1;
+        due.push_back(e);
+      } else {
+        link(*e);
+      }
+      e = next;
+    }
+  }
+  // Running a timer can schedule threads but can't reschedule timers, so the
+  // due list is not modified while it is iterated over.
+  for (Entry *e : due)
+    e->timer.run(e->time);
+  if ((list = getEarliestList()) >= 0)
+    scheduler.push(*this, getEarliestTime(list));
+}
@@ -0,0 +1,73 @@
+// Copyright (c) 2012, Richard Osborne, All rights reserved
+// This software is freely distributable under a derivative of the
+// University of Illinois/NCSA Open Source License posted in
+// LICENSE.txt and at <http://github.xcore.com/>
+
+#ifndef _TimerWheel_h_
+#define _TimerWheel_h_
+
+#include "Runnable.h"
+#include <vector>
+#include <stdint.h>
+
+namespace axe {
+
+class RunnableQueue;
+class Timer;
+
+/// Hierarchical timing wheel holding the times at which timers become ready.
+/// Each level has NUM_SLOTS slots, each covering NUM_SLOTS times the range of
+/// a slot on the level below. Times too far in the future are kept in an
+/// overflow list. The wheel is a runnable which is scheduled at the earliest
+/// time in the wheel, so timed waits add a single entry to the scheduler no
+/// matter how many timers are waiting.
+class TimerWheel : public Runnable {
+public:
+  enum {
+    SLOT_BITS = 6,
+    NUM_SLOTS = 1 << SLOT_BITS,
+    NUM_LEVELS = 4,
+    OVERFLOW_LIST = NUM_LEVELS * NUM_SLOTS,
+    NUM_LISTS = OVERFLOW_LIST + 1
+  };
+  /// Links embedded in each timer.
+  struct Entry {
+    Entry *prev;
+    Entry *next;
+    Timer &timer;
+    ticks_t time;
+    /// Index of the list containing the entry, -1 if not in the wheel.
+    int list;
+    Entry(Timer &t) : prev(0), next(0), timer(t), time(0), list(-1) {}
+  };
+private:
+  RunnableQueue &scheduler;
+  /// The time the wheel was last advanced to. All entries are at or after
+  /// this time.
+  ticks_t now;
+  Entry *lists[NUM_LISTS];
+  /// Bitmap of non empty slots of each level.
+  uint64_t occupied[NUM_LEVELS];
+  /// Entries that are due, kept to avoid allocating on each call to run().
+  std::vector<Entry*> due;
+
+  void link(Entry &e);
+  void unlink(Entry &e);
+  /// Returns the index of the list containing the earliest entry, or -1 if
+  /// the wheel is empty.
+  int getEarliestList() const;
+  ticks_t getEarliestTime(int list) const;
+public:
+  TimerWheel(RunnableQueue &s);
+  TimerWheel(const TimerWheel &) = delete;
+
+  /// Run the timer at the specified time, replacing any earlier request.
+  void schedule(Entry &e, ticks_t time);
+  void cancel(Entry &e);
+
+  void run(ticks_t time) override;
+};
+
+} // End axe namespace
+
+#endif // _TimerWheel_h_
@@ -16,7 +16,8 @@
 #include "Node.h"
 #include "Core.h"
 #include "BitManip.h"
-#include <iostream>
+#include "ConsoleSink.h"
+#include <cstdio>
 
 using namespace axe;
 
@@ -25,6 +26,8 @@ const unsigned DEFAULT_BIT_RATE = 115200;
 class UartRx : public PortInterface, public Runnable, public Peripheral {
 private:
   RunnableQueue &scheduler;
+  ConsoleSink &console;
+  unsigned consoleSource;
   unsigned currentPinValue;
   enum State {
     WAIT_FOR_HIGH,
@@ -49,16 +52,20 @@ private:
   unsigned byte;
   
   bool computeParity();
-  void receiveByte(unsigned byte);
+  void receiveByte(unsigned byte, ticks_t time);
   void scheduleUpdate(ticks_t time);
 public:
-  UartRx(RunnableQueue &s, PortConnectionWrapper p, ticks_t bitTime);
+  UartRx(RunnableQueue &s, ConsoleSink &c, PortConnectionWrapper p,
+         ticks_t bitTime);
   void seePinsChange(const Signal &value, ticks_t time) override;
   void run(ticks_t time) override;
 };
 
-UartRx::UartRx(RunnableQueue &s, PortConnectionWrapper p, ticks_t bt) :
+UartRx::UartRx(RunnableQueue &s, ConsoleSink &c, PortConnectionWrapper p,
+               ticks_t bt) :
   scheduler(s),
+  console(c),
+  consoleSource(c.addSource(fileno(stdout))),
   currentPinValue(0),
   bitTime(bt),
   numDataBits(8),
@@ -101,10 +108,10 @@ bool UartRx::computeParity()
   return value;
 }
 
-void UartRx::receiveByte(unsigned byte)
+void UartRx::receiveByte(unsigned byte, ticks_t time)
 {
-  std::cout << (char)byte;
-  std::cout.flush();
+  char c = byte;
+  console.output(consoleSource, &c, 1, time);
 }
 
 void UartRx::run(ticks_t time)
@@ -142,7 +149,7 @@ void UartRx::run(ticks_t time)
       if (bitNumber == numStopBits) {
         if (byteValid)
         state = WAIT_FOR_START;
-        receiveByte(byte);
+        receiveByte(byte, time);
       } else {
         scheduleUpdate(time + bitTime);
       }
@@ -163,7 +170,7 @@ createUartRx(SystemState &system, PortConnectionManager &connectionManager,
   ticks_t bitTime = (CYCLES_PER_TICK*100000000)/bitrate;
   PortConnectionWrapper port = connectionManager.get(properties, "port");
   UartRx *p =
-    new UartRx(system.getScheduler(), port, bitTime);
+    new UartRx(system.getScheduler(), system.getConsoleSink(), port, bitTime);
   return p;
 }
 
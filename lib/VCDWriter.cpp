@@ -0,0 +1,127 @@
+// Copyright (c) 2011, Richard Osborne, All rights reserved
+// This software is freely distributable under a derivative of the
+// University of Illinois/NCSA Open Source License posted in
+// LICENSE.txt and at <http://github.xcore.com/>
+
+#include "VCDWriter.h"
+#include "BitManip.h"
+#include <ctime>
+
+using namespace axe;
+
+VCDWriter::VCDWriter(const std::string &name) :
+  out(name.c_str(), std::fstream::out),
+  currentTime(0)
+{
+  emitDate();
+
+  out << "$version\n";
+  out << "  AXE (An XCore Emulator)\n";
+  out << "$end\n";
+
+  out << "$timescale\n";
+  out << "  100 ps\n";
+  out << "$end\n";
+}
+
+std::string VCDWriter::makeIdentifier(unsigned index)
+{
+  std::string identifier;
+  unsigned offset = '!';
+  unsigned base = '~' - '!' + 1;
+  if (index) {
+    while (index) {
+      identifier.push_back(offset + (index % base));
+      index /= base;
+    }
+  } else {
+    identifier.push_back(offset);
+  }
+  return identifier;
+}
+
+void VCDWriter::emitDate()
+{
+  time_t rawTime = std::time(0);
+  if (rawTime == -1)
+    return;
+  struct tm *timeinfo = localtime(&rawTime);
+  char buf[256];
+  if (std::strftime(buf, 256, "%B %d, %Y %X", timeinfo) == 0)
+    return;
+  out << "$date\n";
+  out << "  " << buf << '\n';
+  out << "$end\n";
+}
+
+void VCDWriter::beginScope(const std::string &name)
+{
+  out << "$scope\n";
+  out << "  module " << name << '\n';
+  out << "$end\n";
+}
+
+void VCDWriter::endScope()
+{
+  out << "$upscope $end\n";
+}
+
+void VCDWriter::declare(const std::string &name, unsigned width)
+{
+  Variable variable = { makeIdentifier(variables.size()), width };
+  out << "$var\n";
+  out << "  wire";
+  out << ' ' << std::dec << width;
+  out << ' ' << variable.identifier;
+  out << ' ' << name;
+  out << '\n';
+  out << "$end\n";
+  variables.push_back(variable);
+}
+
+void VCDWriter::endDeclarations()
+{
+  out << "$enddefinitions $end\n";
+  out << "$dumpvars\n";
+  for (unsigned i = 0, e = variables.size(); i != e; ++i) {
+    dumpValue(i, 0);
+  }
+  out << "$end\n";
+}
+
+void VCDWriter::dumpValue(unsigned index, uint32_t value)
+{
+  const Variable &variable = variables[index];
+  if (variable.width == 1) {
+    // Dumps of value changes to scalar variables shall not have any white space
+    // between the value and the identifier code.
+    out << (value & 1);
+  } else {
+    // Dumps of value changes to vectors shall not have any white space between
+    // the base letter and the value digits, but they shall have one white space
+    // between the value digits and the identifier code.
+    // The output format for each value is right-justified. Vector values appear
+    // in the shortest form possible: redundant bit values which result from
+    // left-extending values to fill a particular vector size are eliminated.
+    out << 'b';
+    if (value) {
+      for (int i = 31 - countLeadingZeros(value); i >= 0; i--) {
+        out << ((value & (1 << i)) ? '1' : '0');
+      }
+    } else {
+      out << '0';
+    }
+    out << ' ';
+  }
+  out << variable.identifier;
+  out << '\n';
+}
+
+void VCDWriter::writeChange(uint64_t time, unsigned index, uint32_t value)
+{
+  if (time != currentTime) {
+    out << '#' << time << '\n';
+    currentTime = time;
+  }
+  dumpValue(index, value);
+}
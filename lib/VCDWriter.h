@@ -0,0 +1,38 @@
+// Copyright (c) 2011, Richard Osborne, All rights reserved
+// This software is freely distributable under a derivative of the
+// University of Illinois/NCSA Open Source License posted in
+// LICENSE.txt and at <http://github.xcore.com/>
+
+#ifndef _VCDWriter_h_
+#define _VCDWriter_h_
+
+#include "WaveformWriter.h"
+#include <fstream>
+#include <vector>
+
+namespace axe {
+
+/// Writes waveforms as a textual Value Change Dump.
+class VCDWriter : public WaveformWriter {
+  struct Variable {
+    std::string identifier;
+    unsigned width;
+  };
+  std::fstream out;
+  std::vector<Variable> variables;
+  uint64_t currentTime;
+  static std::string makeIdentifier(unsigned index);
+  void emitDate();
+  void dumpValue(unsigned index, uint32_t value);
+public:
+  VCDWriter(const std::string &name);
+  void beginScope(const std::string &name) override;
+  void endScope() override;
+  void declare(const std::string &name, unsigned width) override;
+  void endDeclarations() override;
+  void writeChange(uint64_t time, unsigned index, uint32_t value) override;
+};
+
+} // End axe namespace
+
+#endif // _VCDWriter_h_
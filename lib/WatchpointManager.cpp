@@ -1,26 +1,105 @@
 #include "WatchpointManager.h"
 #include "Tracer.h"
+#include <algorithm>
 #include <set>
 
 using namespace axe;
 
+void WatchpointIntervalIndex::
+build(const std::set<Watchpoint> &watchpoints, WatchpointType type)
+{
+  entries.clear();
+  // The set is ordered by type and then by start address.
+  for (const Watchpoint &watchpoint : watchpoints) {
+    if (watchpoint.type != type)
+      continue;
+    Entry entry = { watchpoint.begin, watchpoint.end };
+    if (!entries.empty())
+      entry.maxEnd = std::max(entry.maxEnd, entries.back().maxEnd);
+    entries.push_back(entry);
+  }
+}
+
+bool WatchpointIntervalIndex::overlaps(uint32_t begin, uint32_t last) const
+{
+  // Find the last interval starting at or before last. The intervals up to
+  // and including it are the only ones that can overlap.
+  auto it = std::upper_bound(entries.begin(), entries.end(), last,
+                             [](uint32_t value, const Entry &entry) {
+                               return value < entry.begin;
+                             });
+  if (it == entries.begin())
+    return false;
+  --it;
+  return it->maxEnd >= begin;
+}
+
+void WatchpointManager::rebuild()
+{
+  readIndex.build(watchpoints, WatchpointType::READ);
+  writeIndex.build(watchpoints, WatchpointType::WRITE);
+  pageFilter.clear();
+  firstPage = 0;
+  if (watchpoints.empty())
+    return;
+  uint32_t minPage = UINT32_MAX;
+  uint32_t maxPage = 0;
+  for (const Watchpoint &watchpoint : watchpoints) {
+    minPage = std::min(minPage, watchpoint.begin >> PAGE_SIZE_LOG2);
+    maxPage = std::max(maxPage, watchpoint.end >> PAGE_SIZE_LOG2);
+  }
+  firstPage = minPage;
+  pageFilter.resize(maxPage - minPage + 1);
+  for (const Watchpoint &watchpoint : watchpoints) {
+    for (uint32_t page = watchpoint.begin >> PAGE_SIZE_LOG2,
+         last = watchpoint.end >> PAGE_SIZE_LOG2; page <= last; ++page) {
+      pageFilter[page - firstPage] |= getTypeMask(watchpoint.type);
+    }
+  }
+}
+
 void WatchpointManager::setWatchpoint(WatchpointType type, uint32_t lowAddr, uint32_t highAddr)
 {
   Watchpoint w = Watchpoint(type, lowAddr, highAddr);
   watchpoints.insert(w);
+  rebuild();
 }
 
 void WatchpointManager::unsetWatchpoint(WatchpointType type, uint32_t lowAddr, uint32_t highAddr)
 {
   watchpoints.erase(Watchpoint(type, lowAddr, highAddr));
+  rebuild();
 }
 
-bool WatchpointManager::isWatchpointAddress(WatchpointType t, uint32_t address, uint8_t ldst_size)
+void WatchpointManager::clearWatchpoints()
 {
-  for (const Watchpoint &watchpoint : watchpoints) {
-    if (t == watchpoint.type &&
-        (address + ldst_size > watchpoint.begin && address <= watchpoint.end))
+  watchpoints.clear();
+  rebuild();
+}
+
+bool WatchpointManager::
+isWatchpointAddressSlowPath(WatchpointType t, uint32_t address,
+                            uint8_t ldst_size) const
+{
+  switch (t) {
+  default:
+    return false;
+  case WatchpointType::READ:
+    return readIndex.overlaps(address, address + ldst_size - 1);
+  case WatchpointType::WRITE:
+    return writeIndex.overlaps(address, address + ldst_size - 1);
+  }
+}
+
+bool WatchpointManager::mayBeWatchpointRange(uint32_t begin, uint32_t end) const
+{
+  if (pageFilter.empty() || begin == end)
+    return false;
+  uint32_t last = end - 1;
+  for (uint32_t page = begin >> PAGE_SIZE_LOG2; ; ++page) {
+    if (mayBeWatchpointPage(page << PAGE_SIZE_LOG2))
       return true;
+    if (page == last >> PAGE_SIZE_LOG2)
+      return false;
   }
-  return false;
 }
@@ -3,6 +3,7 @@
 
 #include <cassert>
 #include <set>
+#include <vector>
 #include <stdint.h>
 
 namespace axe {
@@ -36,17 +37,72 @@ struct Watchpoint {
   }
 };
 
+/// Index of a set of closed intervals supporting overlap queries in
+/// O(log n). The intervals are sorted by their start and each entry records
+/// the maximum end of the intervals up to and including it.
+class WatchpointIntervalIndex {
+  struct Entry {
+    uint32_t begin;
+    uint32_t maxEnd;
+  };
+  std::vector<Entry> entries;
+public:
+  /// Rebuild the index from the watchpoints of the specified type.
+  void build(const std::set<Watchpoint> &watchpoints, WatchpointType type);
+  /// Returns whether any interval overlaps [begin, last].
+  bool overlaps(uint32_t begin, uint32_t last) const;
+};
+
 class WatchpointManager {
+public:
+  enum {
+    PAGE_SIZE_LOG2 = 10
+  };
 private:
   std::set<Watchpoint> watchpoints;
-  std::set<Watchpoint>::iterator watchpointsIterator;
+  WatchpointIntervalIndex readIndex;
+  WatchpointIntervalIndex writeIndex;
+  /// Page filter covering the pages from firstPage onwards. Each entry is a
+  /// bitwise OR of getTypeMask() for the types of watchpoints that overlap
+  /// the page. Empty if there are no watchpoints.
+  std::vector<uint8_t> pageFilter;
+  uint32_t firstPage;
+
+  static uint8_t getTypeMask(WatchpointType type) {
+    return 1 << static_cast<unsigned>(type);
+  }
+  uint8_t getPageFilter(uint32_t address) const {
+    uint32_t index = (address >> PAGE_SIZE_LOG2) - firstPage;
+    return index < pageFilter.size() ? pageFilter[index] : 0;
+  }
+  void rebuild();
+  bool isWatchpointAddressSlowPath(WatchpointType t, uint32_t address,
+                                   uint8_t ldst_size) const;
 public:
+  WatchpointManager() : firstPage(0) {}
   void setWatchpoint(WatchpointType type, uint32_t lowAddr, uint32_t highAddr);
   void unsetWatchpoint(WatchpointType type, uint32_t lowAddr, uint32_t highAddr);
-  void clearWatchpoints() { watchpoints.clear(); }
+  void clearWatchpoints();
   bool empty() const { return watchpoints.empty(); }
 
-  bool isWatchpointAddress(WatchpointType t, uint32_t address, uint8_t ldst_size);
+  bool isWatchpointAddress(WatchpointType t, uint32_t address,
+                           uint8_t ldst_size) const {
+    uint8_t mask = getTypeMask(t);
+    if (!(getPageFilter(address) & mask) &&
+        !(getPageFilter(address + ldst_size - 1) & mask))
+      return false;
+    return isWatchpointAddressSlowPath(t, address, ldst_size);
+  }
+
+  /// Returns whether the page containing the address overlaps a watchpoint
+  /// of any type.
+  bool mayBeWatchpointPage(uint32_t address) const {
+    return getPageFilter(address) != 0;
+  }
+
+  /// Returns whether any page overlapping [begin, end) overlaps a watchpoint
+  /// of any type.
+  bool mayBeWatchpointRange(uint32_t begin, uint32_t end) const;
 };
 
 }; // End axe namespace
@@ -8,11 +8,12 @@
 
 #include <vector>
 #include <map>
-#include <fstream>
+#include <memory>
 #include <string>
 #include <queue>
 #include "PortInterface.h"
 #include "Signal.h"
+#include "WaveformWriter.h"
 
 namespace axe {
 
@@ -22,20 +23,22 @@ class WaveformTracer;
 class WaveformTracerPort : public PortInterface {
   WaveformTracer *parent;
   Port *port;
-  std::string identifier;
+  unsigned index;
   Signal prev;
   ticks_t time;
 public:
-  WaveformTracerPort(WaveformTracer *w, Port *p, const std::string id) :
+  WaveformTracerPort(WaveformTracer *w, Port *p) :
     parent(w),
     port(p),
-    identifier(id),
+    index(0),
     prev(0),
     time(0) {}
   void update(ticks_t time);
   void seePinsChange(const Signal &value, ticks_t time) override;
   Port *getPort() { return port; }
-  const std::string &getIdentifier() const { return identifier; }
+  /// Index of the port's variable in the waveform.
+  unsigned getIndex() const { return index; }
+  void setIndex(unsigned i) { index = i; }
 };
 
 class WaveformTracer {
@@ -48,19 +51,13 @@ class WaveformTracer {
     }
   };
   std::priority_queue<Event> queue;
-  std::fstream out;
+  std::unique_ptr<WaveformWriter> writer;
   std::vector<WaveformTracerPort> ports;
   typedef std::map<std::string, std::vector<unsigned>> ModuleMap;
   ModuleMap modules;
   bool portsFinalized;
-  uint32_t currentTime;
-  std::string makeIdentifier(unsigned index);
-  void emitDate();
-  void emitDeclarations();
-  void dumpPortValue(const std::string &identifer, Port *port, uint32_t value);
-  void dumpInitialValues();
 public:
-  WaveformTracer(const std::string &name);
+  WaveformTracer(std::unique_ptr<WaveformWriter> w);
   void schedule(WaveformTracerPort *port, ticks_t time);
   void runUntil(ticks_t time);
   void add(const std::string &module, Port *port);
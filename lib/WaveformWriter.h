@@ -0,0 +1,30 @@
+// Copyright (c) 2012, Richard Osborne, All rights reserved
+// This software is freely distributable under a derivative of the
+// University of Illinois/NCSA Open Source License posted in
+// LICENSE.txt and at <http://github.xcore.com/>
+
+#ifndef _WaveformWriter_h_
+#define _WaveformWriter_h_
+
+#include <string>
+#include <stdint.h>
+
+namespace axe {
+
+/// Interface for writing a waveform file. Variables are declared first,
+/// grouped into scopes, and are then referred to by the order in which they
+/// were declared. All variables are initially zero. Times are in units of
+/// 100ps and never decrease.
+class WaveformWriter {
+public:
+  virtual ~WaveformWriter() {}
+  virtual void beginScope(const std::string &name) = 0;
+  virtual void endScope() = 0;
+  virtual void declare(const std::string &name, unsigned width) = 0;
+  virtual void endDeclarations() = 0;
+  virtual void writeChange(uint64_t time, unsigned index, uint32_t value) = 0;
+};
+
+} // End axe namespace
+
+#endif // _WaveformWriter_h_
@@ -0,0 +1,34 @@
+// Copyright (c) 2012, Richard Osborne, All rights reserved
+// This software is freely distributable under a derivative of the
+// University of Illinois/NCSA Open Source License posted in
+// LICENSE.txt and at <http://github.xcore.com/>
+
+#include "XLinkModel.h"
+#include "XLinkRoute.h"
+#include "Node.h"
+
+using namespace axe;
+
+XLinkModel::XLinkModel(RunnableQueue &s) :
+  scheduler(s),
+  enabled(false)
+{
+}
+
+XLinkModel::~XLinkModel()
+{
+}
+
+ChanEndpoint *XLinkModel::
+getChanendDest(Node &node, ChanEndpoint *source, ResourceID ID)
+{
+  links.clear();
+  ChanEndpoint *dest = node.getIncomingChanendDest(ID, &links);
+  if (!dest || links.empty())
+    return dest;
+  std::unique_ptr<XLinkRoute> &route = routes[RouteKey(source, dest)];
+  if (!route)
+    route.reset(new XLinkRoute(scheduler, dest));
+  route->setLinks(links);
+  return route.get();
+}
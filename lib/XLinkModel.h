@@ -0,0 +1,45 @@
+// Copyright (c) 2012, Richard Osborne, All rights reserved
+// This software is freely distributable under a derivative of the
+// University of Illinois/NCSA Open Source License posted in
+// LICENSE.txt and at <http://github.xcore.com/>
+
+#ifndef _XLinkModel_h_
+#define _XLinkModel_h_
+
+#include "Resource.h"
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace axe {
+
+class ChanEndpoint;
+class Node;
+class RunnableQueue;
+class XLink;
+class XLinkRoute;
+
+/// Models the time taken for tokens to cross XLinks. When disabled, tokens
+/// are delivered to channel ends on other nodes without delay.
+class XLinkModel {
+  RunnableQueue &scheduler;
+  bool enabled;
+  typedef std::pair<ChanEndpoint*, ChanEndpoint*> RouteKey;
+  std::map<RouteKey, std::unique_ptr<XLinkRoute>> routes;
+  /// Links crossed by the route being looked up.
+  std::vector<XLink*> links;
+public:
+  XLinkModel(RunnableQueue &scheduler);
+  ~XLinkModel();
+  void setEnabled(bool value) { enabled = value; }
+  bool isEnabled() const { return enabled; }
+  /// Returns the endpoint that the source on the specified node should send
+  /// to in order to reach the channel end with the specified ID. If the
+  /// destination is on another node this is the route to the destination.
+  ChanEndpoint *getChanendDest(Node &node, ChanEndpoint *source,
+                               ResourceID ID);
+};
+
+} // End axe namespace
+
+#endif // _XLinkModel_h_
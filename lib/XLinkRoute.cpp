@@ -0,0 +1,175 @@
+// Copyright (c) 2012, Richard Osborne, All rights reserved
+// This software is freely distributable under a derivative of the
+// University of Illinois/NCSA Open Source License posted in
+// LICENSE.txt and at <http://github.xcore.com/>
+
+#include "XLinkRoute.h"
+#include "Node.h"
+#include "RunnableQueue.h"
+#include "Token.h"
+
+using namespace axe;
+
+XLinkRoute::XLinkRoute(RunnableQueue &s, ChanEndpoint *d) :
+  scheduler(s),
+  dest(d),
+  sending(false),
+  claimPending(false),
+  junkPacket(false),
+  sourceWaiting(false),
+  waitingForDest(false)
+{
+  setJunkIncoming(false);
+}
+
+void XLinkRoute::setLinks(const std::vector<XLink*> &value)
+{
+  if (tokens.empty())
+    links = value;
+}
+
+bool XLinkRoute::openRoute()
+{
+  if (sending)
+    return true;
+  // Wait for the previous packet to be delivered and for the destination to
+  // be claimed.
+  if (!tokens.empty() || claimPending) {
+    sourceWaiting = true;
+    return false;
+  }
+  bool junk = false;
+  if (!dest->claim(this, junk)) {
+    claimPending = true;
+    sourceWaiting = true;
+    return false;
+  }
+  sending = true;
+  junkPacket = junk;
+  return true;
+}
+
+bool XLinkRoute::hasCredit(unsigned num)
+{
+  bool result = true;
+  for (XLink *link : links) {
+    if (!link->hasCredit(num)) {
+      link->waitForCredit(this);
+      result = false;
+    }
+  }
+  return result;
+}
+
+void XLinkRoute::notifySource(ticks_t time)
+{
+  if (!sourceWaiting)
+    return;
+  sourceWaiting = false;
+  if (ChanEndpoint *source = getSource())
+    source->notifyDestCanAcceptTokens(time, 0);
+}
+
+void XLinkRoute::
+transmit(ticks_t time, const uint8_t *values, unsigned num, bool isControl)
+{
+  bool wasEmpty = tokens.empty();
+  ticks_t arrival = time;
+  for (unsigned i = 0; i < num; i++) {
+    arrival = time;
+    for (XLink *link : links) {
+      link->takeCredit(1);
+      arrival = link->transmitToken(arrival);
+    }
+  }
+  // Tokens sent together are delivered together when the last one arrives.
+  for (unsigned i = 0; i < num; i++) {
+    InFlightToken token = { arrival, values[i], isControl };
+    tokens.push_back(token);
+  }
+  if (wasEmpty && !waitingForDest)
+    scheduler.push(*this, tokens.front().time);
+}
+
+void XLinkRoute::notifyCreditReturned(ticks_t time)
+{
+  notifySource(time);
+}
+
+void XLinkRoute::notifyDestClaimed(ticks_t time)
+{
+  claimPending = false;
+  notifySource(time);
+}
+
+void XLinkRoute::notifyDestCanAcceptTokens(ticks_t time, unsigned num)
+{
+  if (!waitingForDest)
+    return;
+  waitingForDest = false;
+  scheduler.push(*this, time);
+}
+
+bool XLinkRoute::canAcceptToken()
+{
+  return canAcceptTokens(1);
+}
+
+bool XLinkRoute::canAcceptTokens(unsigned num)
+{
+  if (!openRoute())
+    return false;
+  if (junkPacket || hasCredit(num))
+    return true;
+  sourceWaiting = true;
+  return false;
+}
+
+void XLinkRoute::receiveDataToken(ticks_t time, uint8_t value)
+{
+  if (!junkPacket)
+    transmit(time, &value, 1, false);
+}
+
+void XLinkRoute::receiveDataTokens(ticks_t time, uint8_t *values, unsigned num)
+{
+  if (!junkPacket)
+    transmit(time, values, num, false);
+}
+
+void XLinkRoute::receiveCtrlToken(ticks_t time, uint8_t value)
+{
+  if (!junkPacket)
+    transmit(time, &value, 1, true);
+  if (value == CT_END || value == CT_PAUSE) {
+    sending = false;
+    junkPacket = false;
+    release(time);
+  }
+}
+
+void XLinkRoute::run(ticks_t time)
+{
+  while (!tokens.empty() && tokens.front().time <= time) {
+    if (!dest->canAcceptToken()) {
+      waitingForDest = true;
+      return;
+    }
+    InFlightToken token = tokens.front();
+    tokens.pop_front();
+    if (token.isControl)
+      dest->receiveCtrlToken(time, token.value);
+    else
+      dest->receiveDataToken(time, token.value);
+    for (XLink *link : links) {
+      link->returnCredit(time, 1);
+    }
+  }
+  if (!tokens.empty()) {
+    scheduler.push(*this, tokens.front().time);
+    return;
+  }
+  // The source may be waiting to start the next packet.
+  if (!sending)
+    notifySource(time);
+}
@@ -0,0 +1,73 @@
+// Copyright (c) 2012, Richard Osborne, All rights reserved
+// This software is freely distributable under a derivative of the
+// University of Illinois/NCSA Open Source License posted in
+// LICENSE.txt and at <http://github.xcore.com/>
+
+#ifndef _XLinkRoute_h_
+#define _XLinkRoute_h_
+
+#include "ChanEndpoint.h"
+#include "Runnable.h"
+#include <deque>
+#include <vector>
+
+namespace axe {
+
+class RunnableQueue;
+class XLink;
+
+/// Carries the packets sent by one channel end to a channel end on another
+/// node, modelling the time taken to cross each XLink on the way. The source
+/// sends to the route as if it were the destination. Each token is serialised
+/// on every link it crosses, contending with tokens from other routes, and is
+/// delivered to the destination once it has crossed the last link. A token
+/// holds a credit on each link until it is delivered so a slow receiver
+/// applies back pressure to the links and the sender.
+class XLinkRoute : public ChanEndpoint, public Runnable {
+  struct InFlightToken {
+    /// Time at which the token reaches the destination.
+    ticks_t time;
+    uint8_t value;
+    bool isControl;
+  };
+  RunnableQueue &scheduler;
+  ChanEndpoint *dest;
+  std::vector<XLink*> links;
+  std::deque<InFlightToken> tokens;
+  /// Is the route to the destination claimed for the packet being sent?
+  bool sending;
+  /// Is the route waiting for the destination to be claimed?
+  bool claimPending;
+  /// Should the packet being sent be junked?
+  bool junkPacket;
+  /// Is the source waiting to be told it can send?
+  bool sourceWaiting;
+  /// Is delivery waiting for room in the destination?
+  bool waitingForDest;
+
+  bool openRoute();
+  bool hasCredit(unsigned tokens);
+  void transmit(ticks_t time, const uint8_t *values, unsigned num,
+                bool isControl);
+  void notifySource(ticks_t time);
+public:
+  XLinkRoute(RunnableQueue &scheduler, ChanEndpoint *dest);
+  ChanEndpoint *getDest() const { return dest; }
+  /// Update the links the route crosses. Ignored while tokens are in flight.
+  void setLinks(const std::vector<XLink*> &value);
+  /// Give notification that credit has been returned on one of the links.
+  void notifyCreditReturned(ticks_t time);
+
+  void notifyDestClaimed(ticks_t time) override;
+  void notifyDestCanAcceptTokens(ticks_t time, unsigned tokens) override;
+  bool canAcceptToken() override;
+  bool canAcceptTokens(unsigned tokens) override;
+  void receiveDataToken(ticks_t time, uint8_t value) override;
+  void receiveDataTokens(ticks_t time, uint8_t *values, unsigned num) override;
+  void receiveCtrlToken(ticks_t time, uint8_t value) override;
+  void run(ticks_t time) override;
+};
+
+} // End axe namespace
+
+#endif // _XLinkRoute_h_
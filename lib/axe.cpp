@@ -14,6 +14,8 @@
 #include "Thread.h"
 #include "StopReason.h"
 #include "Resource.h"
+#include "Chanend.h"
+#include "RunPredicates.h"
 
 #include "Tracer.h"
 #include "LoggingTracer.h"
@@ -145,14 +147,12 @@ void axeUnsetBreakpoint(AXECoreRef core, unsigned address)
 
 int axeSetWatchpoint(AXECoreRef core, unsigned int startAddress, unsigned int endAddress, AXEWatchpointType type)
 {
-  // We need to switch to "slow" tracing mode
   Core *c = unwrap(core);
   return c->setWatchpoint((WatchpointType)type, startAddress, endAddress);
 }
 
 void axeUnsetWatchpoint(AXECoreRef core, unsigned int startAddress, unsigned int endAddress, AXEWatchpointType type)
 {
-  // If there are no more watch points in the set, we should go back to "fast" non-tracing mode
   Core *c = unwrap(core);
   c->unsetWatchpoint((WatchpointType)type, startAddress, endAddress);
 }
@@ -216,6 +216,116 @@ static bool convertRegNum(AXERegister axeReg, Register::Reg &reg) {
   return false;
 }
 
+static BreakpointComparison::Op convertCompareOp(AXECompareOp op)
+{
+  switch (op) {
+  case AXE_COMPARE_EQ: return BreakpointComparison::EQ;
+  case AXE_COMPARE_NE: return BreakpointComparison::NE;
+  case AXE_COMPARE_LT: return BreakpointComparison::LT;
+  case AXE_COMPARE_LE: return BreakpointComparison::LE;
+  case AXE_COMPARE_GT: return BreakpointComparison::GT;
+  case AXE_COMPARE_GE: return BreakpointComparison::GE;
+  }
+  return BreakpointComparison::EQ;
+}
+
+int axeAddBreakpointRegisterCondition(AXECoreRef core, unsigned address,
+                                      AXERegister reg, AXECompareOp op,
+                                      unsigned value)
+{
+  BreakpointCondition *condition =
+    unwrap(core)->getBreakpointCondition(address);
+  if (!condition)
+    return 0;
+  BreakpointComparison::Op compareOp = convertCompareOp(op);
+  switch (reg) {
+  default:
+    {
+      Register::Reg regNum;
+      if (!convertRegNum(reg, regNum))
+        return 0;
+      condition->addComparison(
+        BreakpointComparison::getRegister(regNum, compareOp, value));
+      return 1;
+    }
+  case AXE_REG_PC:
+    condition->addComparison(
+      BreakpointComparison::get(BreakpointComparison::PC, compareOp, value));
+    return 1;
+  case AXE_REG_SR:
+    condition->addComparison(
+      BreakpointComparison::get(BreakpointComparison::SR, compareOp, value));
+    return 1;
+  }
+}
+
+int axeAddBreakpointMemoryCondition(AXECoreRef core, unsigned address,
+                                    unsigned memAddress, unsigned size,
+                                    AXECompareOp op, unsigned value)
+{
+  if (size != 1 && size != 2 && size != 4)
+    return 0;
+  BreakpointCondition *condition =
+    unwrap(core)->getBreakpointCondition(address);
+  if (!condition)
+    return 0;
+  condition->addComparison(
+    BreakpointComparison::getMemory(memAddress, size, convertCompareOp(op),
+                                    value));
+  return 1;
+}
+
+int axeSetBreakpointThreadFilter(AXECoreRef core, unsigned address,
+                                 int threadNum)
+{
+  BreakpointCondition *condition =
+    unwrap(core)->getBreakpointCondition(address);
+  if (!condition)
+    return 0;
+  condition->setThreadFilter(threadNum);
+  return 1;
+}
+
+int axeSetBreakpointIgnoreCount(AXECoreRef core, unsigned address,
+                                unsigned count)
+{
+  BreakpointCondition *condition =
+    unwrap(core)->getBreakpointCondition(address);
+  if (!condition)
+    return 0;
+  condition->setIgnoreCount(count);
+  return 1;
+}
+
+unsigned axeGetBreakpointHitCount(AXECoreRef core, unsigned address)
+{
+  BreakpointCondition *condition =
+    unwrap(core)->getBreakpointCondition(address);
+  if (!condition)
+    return 0;
+  return condition->getHitCount();
+}
+
+void axeClearBreakpointConditions(AXECoreRef core, unsigned address)
+{
+  if (BreakpointCondition *condition =
+        unwrap(core)->getBreakpointCondition(address))
+    *condition = BreakpointCondition();
+}
+
+int axeSetBreakpointCallback(AXECoreRef core, unsigned address,
+                             AXEBreakpointCallback callback, void *data)
+{
+  BreakpointCondition *condition =
+    unwrap(core)->getBreakpointCondition(address);
+  if (!condition)
+    return 0;
+  condition->setCallback([=](Thread &t) {
+    return callback(data, wrap(&t)) != 0;
+  });
+  return 1;
+}
+
 int axeWriteReg(AXEThreadRef thread, AXERegister axeReg, unsigned value)
 {
   switch (axeReg) {
@@ -265,6 +375,8 @@ static AXEStopReason convertStopReasonType(StopReason::Type reason)
     return AXE_STOP_EXIT;
   case StopReason::NO_RUNNABLE_THREADS:
     return AXE_STOP_NO_RUNNABLE_THREADS;
+  case StopReason::PREDICATE:
+    return AXE_STOP_PREDICATE;
   }
 }
 
@@ -274,7 +386,230 @@ AXEStopReason axeRun(AXESystemRef system, unsigned maxCycles)
   return convertStopReasonType(reason);
 }
 
+static RunPredicates &getRunPredicates(Core &core)
+{
+  return core.getParent()->getParent()->getRunPredicates();
+}
+
+static Port *lookupPort(Core &core, unsigned portID)
+{
+  ResourceID id(portID);
+  if (id.type() != RES_TYPE_PORT)
+    return 0;
+  return const_cast<Port*>(core.getPortByID(id));
+}
+
+unsigned axeAddMemoryPredicate(AXECoreRef core, unsigned address,
+                               unsigned mask, unsigned value)
+{
+  Core &c = *unwrap(core);
+  return getRunPredicates(c).addMemoryPredicate(c, address, mask, value);
+}
+
+unsigned axeAddPortPredicate(AXECoreRef core, unsigned portID, unsigned mask,
+                             unsigned value)
+{
+  Core &c = *unwrap(core);
+  Port *port = lookupPort(c, portID);
+  if (!port)
+    return 0;
+  return getRunPredicates(c).addPortPredicate(*port, mask, value);
+}
+
+unsigned axeAddThreadCountPredicate(AXECoreRef core, unsigned count)
+{
+  Core &c = *unwrap(core);
+  return getRunPredicates(c).addThreadCountPredicate(c, count);
+}
+
+unsigned axeAddPortCallback(AXECoreRef core, unsigned portID,
+                            AXEPortCallback callback, void *data)
+{
+  Core &c = *unwrap(core);
+  Port *port = lookupPort(c, portID);
+  if (!port)
+    return 0;
+  return getRunPredicates(c).addPortHook(*port,
+    [=](Port &, uint32_t value, ticks_t) {
+      return callback(data, core, portID, value) != 0;
+    });
+}
+
+unsigned axeAddChanendOutputCallback(AXESystemRef system,
+                                     AXEChanendOutputCallback callback,
+                                     void *data)
+{
+  RunPredicates &predicates =
+    unwrap(system)->getSystemState()->getRunPredicates();
+  return predicates.addChanendOutputHook(
+    [=](Thread &t, Chanend &chanend, uint32_t value,
+        RunPredicates::ChanendOutputType type, ticks_t) {
+      AXEChanendOutputType axeType = AXE_CHANEND_OUTPUT_TOKEN;
+      switch (type) {
+      case RunPredicates::DATA_TOKEN:
+        axeType = AXE_CHANEND_OUTPUT_TOKEN;
+        break;
+      case RunPredicates::CONTROL_TOKEN:
+        axeType = AXE_CHANEND_OUTPUT_CONTROL_TOKEN;
+        break;
+      case RunPredicates::WORD:
+        axeType = AXE_CHANEND_OUTPUT_WORD;
+        break;
+      }
+      return callback(data, wrap(&t), chanend.getID(), value, axeType) != 0;
+    });
+}
+
+void axeRemovePredicate(AXESystemRef system, unsigned id)
+{
+  unwrap(system)->getSystemState()->getRunPredicates().remove(id);
+}
+
+unsigned axeGetLastPredicate(AXESystemRef system)
+{
+  return unwrap(system)->getLastPredicate();
+}
+
+static void readThreadState(Thread &t, AXEThreadState &state)
+{
+  AXEThreadRef thread = wrap(&t);
+  state.core = wrap(&t.getParent());
+  state.thread = thread;
+  state.threadID = t.getNum();
+  for (unsigned i = 0; i < AXE_NUM_REGISTERS; i++) {
+    state.regs[i] = axeReadReg(thread, static_cast<AXERegister>(i));
+  }
+}
+
+static unsigned readThreadStates(Core &core, AXEThreadState *states,
+                                 unsigned maxThreads, unsigned count)
+{
+  for (unsigned i = 0; i < NUM_THREADS; i++) {
+    Thread &t = core.getThread(i);
+    if (!t.isInUse())
+      continue;
+    if (count < maxThreads)
+      readThreadState(t, states[count]);
+    ++count;
+  }
+  return count;
+}
+
+unsigned axeReadCoreThreadStates(AXECoreRef core, AXEThreadState *states,
+                                 unsigned maxThreads)
+{
+  return readThreadStates(*unwrap(core), states, maxThreads, 0);
+}
+
+unsigned axeReadSystemThreadStates(AXESystemRef system,
+                                   AXEThreadState *states,
+                                   unsigned maxThreads)
+{
+  SystemState *sys = unwrap(system)->getSystemState();
+  unsigned count = 0;
+  for (Node *node : sys->getNodes()) {
+    if (!node->isProcessorNode())
+      continue;
+    for (Core *core : static_cast<ProcessorNode*>(node)->getCores()) {
+      count = readThreadStates(*core, states, maxThreads, count);
+    }
+  }
+  return count;
+}
+
+unsigned axeReadMemoryRegions(AXECoreRef core, const AXEMemoryRegion *regions,
+                              unsigned numRegions)
+{
+  Core *c = unwrap(core);
+  unsigned numRead = 0;
+  for (unsigned i = 0; i < numRegions; i++) {
+    if (c->readMemory(regions[i].address, regions[i].dst, regions[i].length))
+      ++numRead;
+  }
+  return numRead;
+}
+
+void axeSetTrackMemoryChanges(AXESystemRef system, int enable)
+{
+  unwrap(system)->setTrackMemoryChanges(enable);
+}
+
+int axeGetChangedMemory(AXESystemRef system, AXECoreRef core,
+                        AXEMemoryRange *ranges, unsigned maxRanges)
+{
+  std::vector<std::pair<uint32_t,uint32_t>> changed;
+  if (!unwrap(system)->getChangedMemory(*unwrap(core), changed))
+    return -1;
+  for (unsigned i = 0; i < changed.size() && i < maxRanges; i++) {
+    ranges[i].address = changed[i].first;
+    ranges[i].length = changed[i].second;
+  }
+  return changed.size();
+}
+
 AXEThreadRef axeGetThreadForLastBreakpoint(AXESystemRef system)
 {
   return wrap(unwrap(system)->getThreadForLastBreakpoint());
 }
+
+static Node *lookupNode(SystemState &sys, int jtagIndex)
+{
+  for (Node *node : sys.getNodes()) {
+    if (node->isProcessorNode() && node->getJtagIndex() == (unsigned)jtagIndex)
+      return node;
+  }
+  return 0;
+}
+
+static void convertStats(const ChanEndpointStats &from, AXEChanendStats &to)
+{
+  to.tokensSent = from.tokensSent;
+  to.packetsSent = from.packetsSent;
+  to.routeWaits = from.routeWaits;
+  to.blockedTime = from.blockedTime;
+  to.tokensReceived = from.tokensReceived;
+  to.packetsReceived = from.packetsReceived;
+  to.claimWaits = from.claimWaits;
+}
+
+int axeGetChanendStats(AXECoreRef core, unsigned chanendID,
+                       AXEChanendStats *stats)
+{
+  ResourceID ID(chanendID);
+  if (ID.type() != RES_TYPE_CHANEND)
+    return 0;
+  Resource *res = unwrap(core)->getResourceByID(ID);
+  if (!res)
+    return 0;
+  convertStats(static_cast<Chanend*>(res)->getStats(), *stats);
+  return 1;
+}
+
+int axeGetSSwitchStats(AXESystemRef system, int jtagIndex,
+                       AXEChanendStats *stats)
+{
+  Node *node = lookupNode(*unwrap(system)->getSystemState(), jtagIndex);
+  if (!node)
+    return 0;
+  convertStats(node->getSSwitch()->getStats(), *stats);
+  return 1;
+}
+
+int axeGetXLinkStats(AXESystemRef system, int jtagIndex, unsigned link,
+                     AXEXLinkStats *stats)
+{
+  Node *node = lookupNode(*unwrap(system)->getSystemState(), jtagIndex);
+  if (!node || link >= node->getNumXLinks())
+    return 0;
+  const XLink &xLink = node->getXLink(link);
+  stats->packetsSent = xLink.getPacketsSent();
+  stats->tokensSent = xLink.getTokensSent();
+  stats->busyTime = xLink.getBusyTime();
+  stats->contentionTime = xLink.getContentionTime();
+  return 1;
+}
+
+void axeSetXLinkTiming(AXESystemRef system, int enable)
+{
+  unwrap(system)->getSystemState()->getXLinkModel().setEnabled(enable != 0);
+}
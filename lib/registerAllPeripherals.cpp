@@ -9,6 +9,7 @@
 #include "SDRAM.h"
 #include "SPIFlash.h"
 #include "EthernetPhy.h"
+#include "Cosim.h"
 #include "PeripheralDescriptor.h"
 #include "Config.h"
 #if AXE_ENABLE_SDL
@@ -24,6 +25,7 @@ void axe::registerAllPeripherals()
   PeripheralRegistry::add(getPeripheralDescriptorSDRAM());
   PeripheralRegistry::add(getPeripheralDescriptorSPIFlash());
   PeripheralRegistry::add(getPeripheralDescriptorEthernetPhy());
+  PeripheralRegistry::add(getPeripheralDescriptorCosim());
 #if AXE_ENABLE_SDL
   PeripheralRegistry::add(getPeripheralDescriptorLCDScreen());
   PeripheralRegistry::add(getPeripheralDescriptorPS2Keyboard());
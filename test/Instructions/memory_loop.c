@@ -0,0 +1,65 @@
+/*
+ * RUN: xcc -O2 -target=XK-1A %s -o %t1.xe
+ * RUN: %sim %t1.xe
+ * RUN: xcc -O2 -target=XCORE-200-EXPLORER %s -o %t1.xe
+ * RUN: %sim %t1.xe
+ */
+
+#include <stdlib.h>
+
+#define VERIFY(x) do { if(!(x)) { _Exit(1); }} while(0)
+
+#define SIZE 1000
+
+int src[SIZE];
+int dst[SIZE];
+short shorts[SIZE];
+unsigned char bytes[SIZE];
+
+void copyForward(int *d, const int *s, int n)
+{
+  for (int i = 0; i < n; i++)
+    d[i] = s[i];
+}
+
+void copyBackward(int *d, const int *s, int n)
+{
+  for (int i = n - 1; i >= 0; i--)
+    d[i] = s[i];
+}
+
+int sumShorts(const short *p, int n)
+{
+  int total = 0;
+  for (int i = 0; i < n; i++)
+    total += p[i];
+  return total;
+}
+
+void fillBytes(unsigned char *p, int n, unsigned char value)
+{
+  for (int i = 0; i < n; i++)
+    p[i] = value;
+}
+
+int main()
+{
+  // Repeat so the loops are compiled and run many iterations.
+  for (int iter = 0; iter < 10; iter++) {
+    for (int i = 0; i < SIZE; i++) {
+      src[i] = i * 3 + iter;
+      shorts[i] = i - 500;
+    }
+    copyForward(dst, src, SIZE);
+    for (int i = 0; i < SIZE; i++)
+      VERIFY(dst[i] == i * 3 + iter);
+    copyBackward(dst, src + 1, SIZE - 1);
+    for (int i = 0; i < SIZE - 1; i++)
+      VERIFY(dst[i] == (i + 1) * 3 + iter);
+    VERIFY(sumShorts(shorts, SIZE) == -500);
+    fillBytes(bytes, SIZE, iter);
+    for (int i = 0; i < SIZE; i++)
+      VERIFY(bytes[i] == iter);
+  }
+  return 0;
+}
@@ -0,0 +1,29 @@
+// RUN: xcc -target=XK-1A %s -o %t1.xe
+// RUN: %sim %t1.xe > %t2.txt
+// RUN: cmp %t2.txt %s.expect
+// RUN: %sim --unbuffered-console %t1.xe > %t2.txt
+// RUN: cmp %t2.txt %s.expect
+// RUN: xcc -target=XCORE-200-EXPLORER %s -o %t1.xe
+// RUN: %sim %t1.xe > %t2.txt
+// RUN: cmp %t2.txt %s.expect
+// RUN: %sim --unbuffered-console %t1.xe > %t2.txt
+// RUN: cmp %t2.txt %s.expect
+
+#include <unistd.h>
+#include <string.h>
+
+static void put(const char *s)
+{
+  write(STDOUT_FILENO, s, strlen(s));
+}
+
+int main()
+{
+  put("one ");
+  put("two\nthree");
+  for (int i = 0; i < 5000; i++)
+    put(".");
+  put("\n");
+  put("no newline");
+  return 0;
+}
@@ -0,0 +1,16 @@
+// RUN: xcc -target=XK-1A %s -o %t1.xe
+// RUN: not timeout 5 %sim %t1.xe > %t2.txt
+// RUN: grep "no newline" %t2.txt
+
+#include <unistd.h>
+#include <string.h>
+
+int main()
+{
+  const char *s = "no newline";
+  write(STDOUT_FILENO, s, strlen(s));
+  // Output without a trailing newline must be written while the simulation
+  // is still running. axe is killed by timeout before it exits normally.
+  while (1) {}
+  return 0;
+}
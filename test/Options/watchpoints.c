@@ -0,0 +1,33 @@
+// RUN: xcc -O2 -target=XK-1A %s -o %t1.xe
+// RUN: axe %t1.xe --watch-write 0x18500 0x18502 > %t2.txt
+// RUN: grep -c "Watchpoint hit" %t2.txt | grep "^1$"
+// Overlapping ranges, each store is reported once.
+// RUN: axe %t1.xe --watch-write 0x18c00 0x18c02 --watch-write 0x18800 0x18ffe --watch-write 0x18500 0x18502 > %t2.txt
+// RUN: grep -c "Watchpoint hit" %t2.txt | grep "^513$"
+// Stores to a page with a read watchpoint aren't reported.
+// RUN: axe %t1.xe --watch-read 0x18600 0x18602 > %t2.txt
+// RUN: grep -c "Watchpoint hit" %t2.txt | grep "^1$"
+// RUN: axe %t1.xe --watch-write 0x19000 0x19002 > %t2.txt
+// RUN: not grep "Watchpoint hit" %t2.txt
+
+// The loops run long enough to be compiled by the JIT before the watched
+// addresses are reached.
+
+#include <stdlib.h>
+
+#define N 1024
+
+int main()
+{
+  volatile unsigned *p = (volatile unsigned *)0x18000;
+  unsigned sum = 0;
+  for (unsigned i = 0; i < N; i++) {
+    p[i] = i;
+  }
+  for (unsigned i = 0; i < N; i++) {
+    sum += p[i];
+  }
+  if (sum != N * (N - 1) / 2)
+    _Exit(1);
+  return 0;
+}
@@ -18,13 +18,22 @@ using namespace axe;
 Options::Options() :
   bootMode(BOOT_SIM),
   file(0),
+  waveformFormat(WAVEFORM_VCD),
   tracing(false),
   traceCycles(false),
   time(false),
   useColour(true),
   stats(false),
   warnPacketOvertake(false),
+  predecode(false),
+  checkPortFastForward(false),
+  bufferConsole(true),
+  consoleTimestamps(false),
+  xlinkTiming(false),
+  xlinkStats(false),
+  trafficStats(false),
   maxCycles(0),
+  jitCacheSize(0),
   clientArgc(0),
   clientArgv(0)
 {
@@ -49,6 +58,9 @@ static void printUsage(const char *ProgName) {
   "  --version                   Print version information and then exit.\n"
   "  --loopback PORT1 PORT2      Connect PORT1 to PORT2.\n"
   "  --vcd FILE                  Write VCD trace to FILE.\n"
+  "  --compressed-waveform FILE  Write compressed binary waveform to FILE.\n"
+  "  --waveform-port PORT        Only record PORT in the waveform. May be\n"
+  "                              repeated.\n"
   "  --boot-spi                  Specify boot from SPI\n"
   "  --rom FILE                  Specify boot rom.\n"
   "  --max-cycles <n>            Exit after <n> cycles\n"
@@ -57,6 +69,22 @@ static void printUsage(const char *ProgName) {
   "  --time                      Display elapsed time on exit.\n"
   "  --stats                     Display simulator statistics on exit.\n"
   "  --warn-packet-overtake      Warn about possible packet overtaking.\n"
+  "  --predecode                 Decode executable code when it is loaded.\n"
+  "  --jit-cache-size <n>        Limit JIT generated code to about <n> KiB. JIT\n"
+  "                              statistics are displayed on stderr on exit.\n"
+  "  --watch-read BEGIN END      Report reads of addresses BEGIN to END.\n"
+  "  --watch-write BEGIN END     Report writes to addresses BEGIN to END.\n"
+  "  --check-port-fast-forward   Check closed form port updates against\n"
+  "                              simulating each clock edge.\n"
+  "  --unbuffered-console        Write console output as soon as it is seen.\n"
+  "  --console-timestamps        Prefix each line of console output with the\n"
+  "                              time it was started.\n"
+  "  --xlink-timing              Model the bandwidth of XLinks and contention\n"
+  "                              between packets sharing them.\n"
+  "  --xlink-stats               Display XLink utilisation on exit. Implies\n"
+  "                              --xlink-timing.\n"
+  "  --traffic-stats             Display tokens, packets and blocked time for\n"
+  "                              each chanend, switch and XLink on exit.\n"
   "  --no-colour                 Dont use colour when printing trace output.\n"
   "\n"
   "Peripherals:\n";
@@ -186,6 +214,17 @@ static PeripheralDescriptor *parsePeripheralOption(const std::string arg)
 }
 
 
+static bool parseAddress(const char *s, uint32_t &address)
+{
+  char *endp;
+  errno = 0;
+  unsigned long value = std::strtoul(s, &endp, 0);
+  if (errno != 0 || *endp != '\0' || *s == '\0' || value > UINT32_MAX)
+    return false;
+  address = value;
+  return true;
+}
+
 static void printVersion()
 {
   std::cout << "AXE ";
@@ -228,12 +267,55 @@ void Options::parse(int argc, char **argv)
       }
       maxCycles = value;
       i++;
-    } else if (arg == "--vcd") {
+    } else if (arg == "--jit-cache-size") {
+      if (i + 1 >= argc) {
+        printUsage(argv[0]);
+        std::exit(1);
+      }
+      char *endp;
+      errno = 0;
+      long value = std::strtol(argv[i + 1], &endp, 10);
+      if (errno != 0 || *endp != '\0' || value < 0) {
+        std::cerr << "Error: failed to parse JIT cache size\n";
+        std::exit(1);
+      }
+      jitCacheSize = value;
+      i++;
+    } else if (arg == "--watch-read" || arg == "--watch-write") {
+      if (i + 2 >= argc) {
+        printUsage(argv[0]);
+        std::exit(1);
+      }
+      WatchpointArg watchpoint;
+      watchpoint.type = arg == "--watch-read" ? WatchpointType::READ :
+                                                WatchpointType::WRITE;
+      if (!parseAddress(argv[i + 1], watchpoint.begin) ||
+          !parseAddress(argv[i + 2], watchpoint.end) ||
+          watchpoint.end < watchpoint.begin) {
+        std::cerr << "Error: invalid watchpoint range\n";
+        std::exit(1);
+      }
+      watchpoints.push_back(watchpoint);
+      i += 2;
+    } else if (arg == "--vcd" || arg == "--compressed-waveform") {
       if (i + 1 > argc) {
         printUsage(argv[0]);
         std::exit(1);
       }
-      vcdFile = argv[i + 1];
+      waveformFile = argv[i + 1];
+      waveformFormat = arg == "--vcd" ? WAVEFORM_VCD : WAVEFORM_COMPRESSED;
+      i++;
+    } else if (arg == "--waveform-port") {
+      if (i + 1 >= argc) {
+        printUsage(argv[0]);
+        std::exit(1);
+      }
+      PortArg portArg;
+      if (!PortArg::parse(argv[i + 1], portArg)) {
+        std::cerr << "Error: Invalid port " << argv[i + 1] << '\n';
+        std::exit(1);
+      }
+      waveformPorts.push_back(portArg);
       i++;
     } else if (arg == "--loopback") {
       if (i + 2 >= argc) {
@@ -251,6 +333,21 @@ void Options::parse(int argc, char **argv)
       i++;
     } else if (arg == "--warn-packet-overtake") {
       warnPacketOvertake = true;
+    } else if (arg == "--predecode") {
+      predecode = true;
+    } else if (arg == "--check-port-fast-forward") {
+      checkPortFastForward = true;
+    } else if (arg == "--unbuffered-console") {
+      bufferConsole = false;
+    } else if (arg == "--console-timestamps") {
+      consoleTimestamps = true;
+    } else if (arg == "--xlink-timing") {
+      xlinkTiming = true;
+    } else if (arg == "--xlink-stats") {
+      xlinkTiming = true;
+      xlinkStats = true;
+    } else if (arg == "--traffic-stats") {
+      trafficStats = true;
     } else if (arg == "--boot-spi") {
       bootMode = BOOT_SPI;
     } else if (arg == "--args") {
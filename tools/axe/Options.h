@@ -8,6 +8,7 @@
 
 #include "Config.h"
 #include "PortArg.h"
+#include "WatchpointManager.h"
 #include <vector>
 #include <string>
 
@@ -18,24 +19,48 @@ class Properties;
 
 typedef std::vector<std::pair<PortArg, PortArg>> LoopbackPorts;
 
+struct WatchpointArg {
+  WatchpointType type;
+  uint32_t begin;
+  uint32_t end;
+};
+
 struct Options {
   enum BootMode {
     BOOT_SIM,
     BOOT_SPI
   };
+  enum WaveformFormat {
+    WAVEFORM_VCD,
+    WAVEFORM_COMPRESSED
+  };
   BootMode bootMode;
   LoopbackPorts loopbackPorts;
   std::vector<std::pair<PeripheralDescriptor*, Properties*>> peripherals;
   const char *file;
   std::string rom;
-  std::string vcdFile;
+  std::string waveformFile;
+  WaveformFormat waveformFormat;
+  /// Ports to record in the waveform, all ports if empty.
+  std::vector<PortArg> waveformPorts;
   bool tracing;
   bool traceCycles;
   bool time;
   bool useColour;
   bool stats;
   bool warnPacketOvertake;
+  bool predecode;
+  bool checkPortFastForward;
+  bool bufferConsole;
+  bool consoleTimestamps;
+  bool xlinkTiming;
+  bool xlinkStats;
+  bool trafficStats;
   ticks_t maxCycles;
+  /// Limit on the size of JIT generated code in KiB, 0 if unlimited.
+  unsigned long jitCacheSize;
+  /// Memory ranges to report accesses to.
+  std::vector<WatchpointArg> watchpoints;
   int clientArgc;
   char **clientArgv;
 
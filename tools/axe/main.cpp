@@ -7,27 +7,34 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <iostream>
+#include <iomanip>
 #include <cassert>
 #include <memory>
 #include <climits>
 #include <ctime>
 #include <cstdlib>
+#include <set>
 
 #include "AXEInitialize.h"
 #include "Tracer.h"
 #include "Resource.h"
 #include "Core.h"
+#include "Chanend.h"
+#include "Port.h"
 #include "SyscallHandler.h"
 #include "XE.h"
 #include "Config.h"
 #include "ProcessorNode.h"
 #include "SystemState.h"
 #include "WaveformTracer.h"
+#include "VCDWriter.h"
+#include "CompressedWaveformWriter.h"
 #include "registerAllPeripherals.h"
 #include "Options.h"
 #include "BootSequencer.h"
 #include "PortAliases.h"
 #include "PortConnectionManager.h"
+#include "Peripheral.h"
 #include "XEReader.h"
 #include "Property.h"
 #include "LoggingTracer.h"
@@ -71,24 +78,59 @@ connectLoopbackPorts(PortConnectionManager &connectionManager,
   return true;
 }
 
-static void connectWaveformTracer(Core &core, WaveformTracer &waveformTracer)
+static void connectWaveformTracer(Core &core, const std::set<Port*> &filter,
+                                  WaveformTracer &waveformTracer)
 {
   for (Port *port : core.getPorts()) {
-    waveformTracer.add(core.getCoreName(), port);
+    if (filter.empty() || filter.count(port))
+      waveformTracer.add(core.getCoreName(), port);
   }
 }
 
-static void
-connectWaveformTracer(SystemState &system, WaveformTracer &waveformTracer)
+static bool
+connectWaveformTracer(SystemState &system, const PortAliases &portAliases,
+                      const std::vector<PortArg> &portArgs,
+                      WaveformTracer &waveformTracer)
 {
+  std::set<Port*> filter;
+  for (const PortArg &arg : portArgs) {
+    Port *port;
+    unsigned beginOffset, endOffset;
+    if (!arg.lookup(system, portAliases, port, beginOffset, endOffset)) {
+      std::cerr << "Error: Invalid port ";
+      arg.dump(std::cerr);
+      std::cerr << '\n';
+      return false;
+    }
+    filter.insert(port);
+  }
   for (Node *node : system.getNodes()) {
     if (!node->isProcessorNode())
       continue;
     for (Core *core : static_cast<ProcessorNode*>(node)->getCores()) {
-      connectWaveformTracer(*core, waveformTracer);
+      connectWaveformTracer(*core, filter, waveformTracer);
     }
   }
   waveformTracer.finalizePorts();
+  return true;
+}
+
+static void
+setWatchpoints(SystemState &system, const std::vector<WatchpointArg> &args)
+{
+  for (Node *node : system.getNodes()) {
+    if (!node->isProcessorNode())
+      continue;
+    for (Core *core : static_cast<ProcessorNode*>(node)->getCores()) {
+      for (const WatchpointArg &arg : args) {
+        if (!core->setWatchpoint(arg.type, arg.begin, arg.end)) {
+          std::cerr << "Error: invalid watchpoint range 0x" << std::hex
+                    << arg.begin << " to 0x" << arg.end << std::dec << '\n';
+          std::exit(1);
+        }
+      }
+    }
+  }
 }
 
 static bool
@@ -176,6 +218,89 @@ static void displayElapsedTime(ticks_t simTime, clock_t realTime)
   std::cout << "Relative simulator speed: " << relativeSpeed << '\n';
 }
 
+static void displayJITStats(SystemState &sys, std::ostream &out)
+{
+  JIT &jit = sys.getJIT();
+  out << "JIT statistics:\n";
+  out << "---------------\n";
+  out << "Code cache usage: " << jit.getCacheUsage() << " bytes";
+  if (jit.getCacheSize() != 0)
+    out << " (limit " << jit.getCacheSize() << " bytes)";
+  out << '\n';
+  out << "Evictions: " << jit.getNumEvictions() << '\n';
+}
+
+static void displayXLinkStats(const SystemState &sys)
+{
+  ticks_t elapsed = sys.getLatestThreadTime();
+  std::cout << "XLink statistics:\n";
+  std::cout << "-----------------\n";
+  for (const Node *node : sys.getNodes()) {
+    for (unsigned i = 0, e = node->getNumXLinks(); i != e; ++i) {
+      const XLink &xLink = node->getXLink(i);
+      if (xLink.getTokensSent() == 0)
+        continue;
+      double utilisation = elapsed == 0 ? 0 :
+        100.0 * xLink.getBusyTime() / elapsed;
+      std::cout << "Node 0x" << std::hex << node->getNodeID() << std::dec
+                << " link " << i << ": " << xLink.getTokensSent()
+                << " tokens, " << std::fixed << std::setprecision(1)
+                << utilisation << "% utilisation\n";
+    }
+  }
+}
+
+static void displayEndpointStats(const ChanEndpointStats &stats)
+{
+  std::cout << "sent " << stats.tokensSent << " tokens in "
+            << stats.packetsSent << " packets (" << stats.routeWaits
+            << " route waits, blocked " << stats.blockedTime
+            << " cycles), received " << stats.tokensReceived << " tokens in "
+            << stats.packetsReceived << " packets (" << stats.claimWaits
+            << " waits)\n";
+}
+
+static void displayTrafficStats(SystemState &sys)
+{
+  std::cout << "Traffic statistics:\n";
+  std::cout << "-------------------\n";
+  std::cout << std::hex << std::setfill('0');
+  for (Node *node : sys.getNodes()) {
+    if (node->isProcessorNode()) {
+      for (Core *core : static_cast<ProcessorNode*>(node)->getCores()) {
+        for (Chanend &chanend : core->getChanends()) {
+          const ChanEndpointStats &stats = chanend.getStats();
+          if (stats.packetsSent == 0 && stats.tokensReceived == 0)
+            continue;
+          std::cout << "Chanend 0x" << std::setw(8) << chanend.getID()
+                    << std::dec << ": ";
+          displayEndpointStats(stats);
+          std::cout << std::hex;
+        }
+      }
+    }
+    const ChanEndpointStats &stats = node->getSSwitch()->getStats();
+    if (stats.tokensReceived != 0) {
+      std::cout << "SSwitch node 0x" << std::setw(4) << node->getNodeID()
+                << std::dec << ": ";
+      displayEndpointStats(stats);
+      std::cout << std::hex;
+    }
+    for (unsigned i = 0, e = node->getNumXLinks(); i != e; ++i) {
+      const XLink &xLink = node->getXLink(i);
+      if (xLink.getPacketsSent() == 0)
+        continue;
+      std::cout << "XLink node 0x" << std::setw(4) << node->getNodeID()
+                << std::dec << " link " << i << ": "
+                << xLink.getPacketsSent() << " packets, "
+                << xLink.getTokensSent() << " tokens, "
+                << xLink.getContentionTime() << " contention cycles\n";
+      std::cout << std::hex;
+    }
+  }
+  std::cout << std::dec << std::setfill(' ');
+}
+
 typedef std::vector<std::pair<PeripheralDescriptor*, Properties*>>
   PeripheralDescriptorWithPropertiesVector;
 
@@ -191,25 +316,51 @@ loop(const Options &options)
   PortAliases portAliases;
   xeReader.readPortAliases(portAliases);
   SystemState &sys = *statePtr;
+  // Keep console output in order with the trace.
+  sys.getConsoleSink().setBuffered(options.bufferConsole && !options.tracing);
+  sys.getConsoleSink().setTimestamps(options.consoleTimestamps);
+  sys.getXLinkModel().setEnabled(options.xlinkTiming);
   PortConnectionManager connectionManager(sys, portAliases);
 
   if (!connectLoopbackPorts(connectionManager, options.loopbackPorts)) {
     std::exit(1);
   }
+  setWatchpoints(sys, options.watchpoints);
 
   const PeripheralDescriptorWithPropertiesVector &peripherals =
     options.peripherals;
+  // Peripherals are destroyed before the system so they can finish their
+  // work when the simulation ends.
+  std::vector<std::unique_ptr<Peripheral>> peripheralInstances;
   for (auto &entry : peripherals) {
     if (!checkPeripheralPorts(connectionManager, entry.first, *entry.second)) {
       std::exit(1);
     }
-    entry.first->createInstance(sys, connectionManager, *entry.second);
+    Peripheral *peripheral =
+      entry.first->createInstance(sys, connectionManager, *entry.second);
+    if (!peripheral) {
+      std::exit(1);
+    }
+    peripheralInstances.emplace_back(peripheral);
   }
 
   std::unique_ptr<WaveformTracer> waveformTracer;
-  if (!options.vcdFile.empty()) {
-    waveformTracer.reset(new WaveformTracer(options.vcdFile));
-    connectWaveformTracer(sys, *waveformTracer);
+  if (!options.waveformFile.empty()) {
+    std::unique_ptr<WaveformWriter> writer;
+    switch (options.waveformFormat) {
+    default: assert(0 && "Unexpected waveform format");
+    case Options::WAVEFORM_VCD:
+      writer.reset(new VCDWriter(options.waveformFile));
+      break;
+    case Options::WAVEFORM_COMPRESSED:
+      writer.reset(new CompressedWaveformWriter(options.waveformFile));
+      break;
+    }
+    waveformTracer.reset(new WaveformTracer(std::move(writer)));
+    if (!connectWaveformTracer(sys, portAliases, options.waveformPorts,
+                               *waveformTracer)) {
+      std::exit(1);
+    }
   }
 
   if (!options.rom.empty()) {
@@ -223,6 +374,7 @@ loop(const Options &options)
   BootSequencer bootSequencer(sys);
   bootSequencer.getSyscallHandler()->setCmdLine(options.clientArgc,
                                                 options.clientArgv);
+  bootSequencer.setPredecode(options.predecode);
   bootSequencer.populateFromXE(xe);
   switch (options.bootMode) {
   default: assert(0 && "Unexpected bootmode");
@@ -235,6 +387,8 @@ loop(const Options &options)
   if (options.maxCycles != 0) {
     sys.setTimeout(options.maxCycles);
   }
+  sys.getJIT().setCacheSize(uint64_t(options.jitCacheSize) * 1024);
+  Port::setCheckFastForward(options.checkPortFastForward);
   ticks_t before;
   if (options.time)
     before = std::clock();
@@ -243,6 +397,17 @@ loop(const Options &options)
     ticks_t after = std::clock();
     displayElapsedTime(sys.getLatestThreadTime(), after - before);
   }
+  // The JIT is disabled while tracing, so also report the JIT statistics when
+  // only the cache size is given. These go to stderr to keep them apart from
+  // the output of the program.
+  if (options.stats)
+    displayJITStats(sys, std::cout);
+  else if (options.jitCacheSize != 0)
+    displayJITStats(sys, std::cerr);
+  if (options.xlinkStats)
+    displayXLinkStats(sys);
+  if (options.trafficStats)
+    displayTrafficStats(sys);
   return retval;
 }
 
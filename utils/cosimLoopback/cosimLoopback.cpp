@@ -0,0 +1,104 @@
+// Copyright (c) 2012, Richard Osborne, All rights reserved
+// This software is freely distributable under a derivative of the
+// University of Illinois/NCSA Open Source License posted in
+// LICENSE.txt and at <http://github.xcore.com/>
+
+// Stand-in peer for the cosim peripheral. Each change AXE drives on port 2n
+// is driven back on port 2n + 1 after a fixed delay.
+//
+// Usage: cosimLoopback DELAY SHM_NAME
+
+#include "axe-c/cosim.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <signal.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+template <typename T> static T loadAcquire(const T &x)
+{
+  return __atomic_load_n(&x, __ATOMIC_ACQUIRE);
+}
+
+template <typename T> static void storeRelease(T &x, T value)
+{
+  __atomic_store_n(&x, value, __ATOMIC_RELEASE);
+}
+
+static AXECosimShared *openShared(const char *name)
+{
+  int fd = shm_open(name, O_RDWR, 0);
+  if (fd < 0) {
+    std::fprintf(stderr, "Error: failed to open %s\n", name);
+    std::exit(1);
+  }
+  void *p = mmap(0, sizeof(AXECosimShared), PROT_READ | PROT_WRITE,
+                 MAP_SHARED, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED) {
+    std::fprintf(stderr, "Error: failed to map %s\n", name);
+    std::exit(1);
+  }
+  return static_cast<AXECosimShared*>(p);
+}
+
+static void push(AXECosimShared *shared, const AXECosimChange &change)
+{
+  AXECosimRing &ring = shared->fromPeer;
+  uint32_t tail = ring.tail;
+  while (tail - loadAcquire(ring.head) == AXE_COSIM_RING_SIZE)
+    sched_yield();
+  ring.changes[tail % AXE_COSIM_RING_SIZE] = change;
+  storeRelease(ring.tail, tail + 1);
+}
+
+int main(int argc, char **argv)
+{
+  if (argc != 3) {
+    std::fprintf(stderr, "Usage: %s DELAY SHM_NAME\n", argv[0]);
+    return 1;
+  }
+  uint64_t delay = std::strtoull(argv[1], 0, 10);
+  if (delay == 0) {
+    std::fprintf(stderr, "Error: delay must be non zero\n");
+    return 1;
+  }
+  AXECosimShared *shared = openShared(argv[2]);
+  while (loadAcquire(shared->magic) != AXE_COSIM_MAGIC)
+    sched_yield();
+  pid_t axePid = shared->axePid;
+  storeRelease<uint32_t>(shared->peerAttached, 1);
+  storeRelease<uint64_t>(shared->peerTime, delay);
+  AXECosimRing &ring = shared->toPeer;
+  while (true) {
+    // Read the time first so all changes before it are in the ring.
+    uint64_t axeTime = loadAcquire(shared->axeTime);
+    uint32_t head = ring.head;
+    uint32_t tail = loadAcquire(ring.tail);
+    for (; head != tail; ++head) {
+      AXECosimChange change = ring.changes[head % AXE_COSIM_RING_SIZE];
+      if (change.halfPeriod != 0) {
+        // Delay the clock by moving its phase.
+        change.value = (change.value + delay) % (2 * change.halfPeriod);
+      }
+      change.time += delay;
+      change.port ^= 1;
+      if ((change.port & 1) && change.port < shared->numPorts)
+        push(shared, change);
+    }
+    storeRelease(ring.head, head);
+    if (axeTime == UINT64_MAX)
+      return 0;
+    // Nothing AXE does from axeTime onwards can cause a change before
+    // axeTime + delay.
+    if (axeTime + delay > loadAcquire(shared->peerTime))
+      storeRelease<uint64_t>(shared->peerTime, axeTime + delay);
+    if (head == tail) {
+      if (kill(axePid, 0) != 0)
+        return 0;
+      sched_yield();
+    }
+  }
+}
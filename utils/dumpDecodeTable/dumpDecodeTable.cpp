@@ -0,0 +1,116 @@
+// Copyright (c) 2012, Richard Osborne, All rights reserved
+// This software is freely distributable under a derivative of the
+// University of Illinois/NCSA Open Source License posted in
+// LICENSE.txt and at <http://github.xcore.com/>
+
+// Decodes every 16 bit instruction word and every combination of first and
+// second word of a 32 bit instruction and prints, for each opcode, the number
+// of encodings that decode to it and a hash of those encodings and their
+// decoded operands. If instruction words are given on the command line only
+// those are decoded and the opcode and operands of each are printed. Used by
+// the tests to check the instruction decoder.
+
+#include "Instruction.h"
+#include "InstructionOpcode.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+
+using namespace axe;
+
+static const char *opcodeNames[] = {
+#define EMIT_INSTRUCTION_LIST
+#define DO_INSTRUCTION(inst) #inst,
+#include "InstructionGenOutput.inc"
+#undef EMIT_INSTRUCTION_LIST
+#undef DO_INSTRUCTION
+};
+
+namespace {
+struct OpcodeSummary {
+  uint64_t count;
+  uint64_t hash;
+  OpcodeSummary() : count(0), hash(UINT64_C(0xcbf29ce484222325)) {}
+  void add(uint32_t value) {
+    // FNV-1a.
+    for (unsigned i = 0; i < 4; i++) {
+      hash ^= (value >> (i * 8)) & 0xff;
+      hash *= UINT64_C(0x100000001b3);
+    }
+  }
+};
+} // End anonymous namespace
+
+static void
+decode(uint16_t low, uint16_t high, bool highValid, Node::Type type,
+       std::map<InstructionOpcode, OpcodeSummary> &summaries)
+{
+  InstructionOpcode opcode;
+  Operands operands;
+  std::memset(&operands, 0, sizeof(operands));
+  instructionDecode(low, high, highValid, opcode, operands, type);
+  OpcodeSummary &summary = summaries[opcode];
+  ++summary.count;
+  summary.add(highValid ? (high << 16 | low) : low);
+  for (unsigned i = 0; i < 6; i++)
+    summary.add(operands.ops[i]);
+}
+
+/// Decode a single instruction. Values above 0xffff are 32 bit instructions
+/// with the first word in the low 16 bits.
+static bool decodeWord(const char *arg, Node::Type type)
+{
+  char *end;
+  unsigned long value = std::strtoul(arg, &end, 0);
+  if (*arg == '\0' || *end != '\0' || value > 0xffffffff) {
+    std::fprintf(stderr, "Error: invalid instruction word \"%s\"\n", arg);
+    return false;
+  }
+  InstructionOpcode opcode;
+  Operands operands;
+  std::memset(&operands, 0, sizeof(operands));
+  instructionDecode(value & 0xffff, value >> 16, value > 0xffff, opcode,
+                    operands, type);
+  std::printf("%s", opcodeNames[opcode]);
+  for (unsigned i = 0; i < 6; i++)
+    std::printf(" %u", operands.ops[i]);
+  std::printf("\n");
+  return true;
+}
+
+int main(int argc, char **argv)
+{
+  if (argc < 2 ||
+      (std::strcmp(argv[1], "xs1") != 0 && std::strcmp(argv[1], "xs2") != 0)) {
+    std::fprintf(stderr, "Usage: dumpDecodeTable xs1|xs2 [word...]\n");
+    return 1;
+  }
+  Node::Type type = std::strcmp(argv[1], "xs1") == 0 ? Node::XS1_L :
+                                                        Node::XS2_A;
+  if (argc > 2) {
+    for (int i = 2; i < argc; i++) {
+      if (!decodeWord(argv[i], type))
+        return 1;
+    }
+    return 0;
+  }
+  std::map<InstructionOpcode, OpcodeSummary> summaries;
+  // Words with a major opcode of 0x1e or above are the first word of a 32 bit
+  // instruction.
+  const uint32_t firstLongWord = 0x1e << 11;
+  for (uint32_t low = 0; low < firstLongWord; low++) {
+    decode(low, 0, false, type, summaries);
+  }
+  for (uint32_t low = firstLongWord; low <= 0xffff; low++) {
+    for (uint32_t high = 0; high <= 0xffff; high++) {
+      decode(low, high, true, type, summaries);
+    }
+  }
+  for (const auto &entry : summaries) {
+    std::printf("%s %llu %016llx\n", opcodeNames[entry.first],
+                static_cast<unsigned long long>(entry.second.count),
+                static_cast<unsigned long long>(entry.second.hash));
+  }
+  return 0;
+}
@@ -0,0 +1,166 @@
+// Copyright (c) 2012, Richard Osborne, All rights reserved
+// This software is freely distributable under a derivative of the
+// University of Illinois/NCSA Open Source License posted in
+// LICENSE.txt and at <http://github.xcore.com/>
+
+// Decodes a waveform written by --compressed-waveform and prints it as text.
+// Each scope is printed as "scope NAME" followed by a "var NAME WIDTH" line
+// for each of its variables. Each value change is then printed as
+// "TIME NAME VALUE". See CompressedWaveformWriter.h for the format.
+
+#include "Config.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+#if AXE_ENABLE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace {
+class Reader {
+  const uint8_t *p;
+  const uint8_t *end;
+public:
+  Reader(const uint8_t *begin, const uint8_t *e) : p(begin), end(e) {}
+  bool atEnd() const { return p == end; }
+  bool readInteger(uint64_t &value);
+  bool readString(std::string &s);
+  bool readUInt32(uint32_t &value);
+  bool readBytes(const uint8_t *&data, size_t size);
+};
+} // End anonymous namespace
+
+bool Reader::readInteger(uint64_t &value)
+{
+  value = 0;
+  for (unsigned shift = 0; p != end && shift < 64; shift += 7) {
+    uint8_t byte = *p++;
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if (!(byte & 0x80))
+      return true;
+  }
+  return false;
+}
+
+bool Reader::readString(std::string &s)
+{
+  uint64_t size;
+  const uint8_t *data;
+  if (!readInteger(size) || !readBytes(data, size))
+    return false;
+  s.assign(reinterpret_cast<const char*>(data), size);
+  return true;
+}
+
+bool Reader::readUInt32(uint32_t &value)
+{
+  const uint8_t *data;
+  if (!readBytes(data, 4))
+    return false;
+  value = data[0] | (data[1] << 8) | (data[2] << 16) |
+          (static_cast<uint32_t>(data[3]) << 24);
+  return true;
+}
+
+bool Reader::readBytes(const uint8_t *&data, size_t size)
+{
+  if (static_cast<size_t>(end - p) < size)
+    return false;
+  data = p;
+  p += size;
+  return true;
+}
+
+static void error(const char *message)
+{
+  std::cerr << "Error: " << message << '\n';
+  std::exit(1);
+}
+
+static void dumpBlock(Reader reader, const std::vector<std::string> &names)
+{
+  uint64_t time;
+  if (!reader.readInteger(time))
+    error("truncated block");
+  while (!reader.atEnd()) {
+    uint64_t delta, index, value;
+    if (!reader.readInteger(delta) || !reader.readInteger(index) ||
+        !reader.readInteger(value))
+      error("truncated block");
+    if (index >= names.size())
+      error("value change for an undeclared variable");
+    time += delta;
+    std::printf("%llu %s %llu\n", static_cast<unsigned long long>(time),
+                names[index].c_str(), static_cast<unsigned long long>(value));
+  }
+}
+
+int main(int argc, char **argv)
+{
+  if (argc != 2) {
+    std::fprintf(stderr, "Usage: dumpWaveform FILE\n");
+    return 1;
+  }
+  std::ifstream in(argv[1], std::ifstream::in | std::ifstream::binary);
+  if (!in) {
+    std::cerr << "Error: cannot open \"" << argv[1] << "\"\n";
+    return 1;
+  }
+  std::vector<uint8_t> file((std::istreambuf_iterator<char>(in)),
+                            std::istreambuf_iterator<char>());
+  Reader reader(file.data(), file.data() + file.size());
+  const uint8_t *magic;
+  if (!reader.readBytes(magic, 8) || std::memcmp(magic, "AXEWAVE\1", 8) != 0)
+    error("not a compressed waveform");
+
+  std::vector<std::string> names;
+  uint64_t numScopes;
+  if (!reader.readInteger(numScopes))
+    error("truncated header");
+  for (uint64_t i = 0; i < numScopes; i++) {
+    std::string scope;
+    uint64_t numVars;
+    if (!reader.readString(scope) || !reader.readInteger(numVars))
+      error("truncated header");
+    std::printf("scope %s\n", scope.c_str());
+    for (uint64_t j = 0; j < numVars; j++) {
+      std::string name;
+      uint64_t width;
+      if (!reader.readString(name) || !reader.readInteger(width))
+        error("truncated header");
+      std::printf("var %s %llu\n", name.c_str(),
+                  static_cast<unsigned long long>(width));
+      names.push_back(name);
+    }
+  }
+
+  std::vector<uint8_t> decoded;
+  while (!reader.atEnd()) {
+    uint32_t rawSize, storedSize;
+    const uint8_t *data;
+    if (!reader.readUInt32(rawSize) || !reader.readUInt32(storedSize) ||
+        !reader.readBytes(data, storedSize))
+      error("truncated block header");
+    if (storedSize == rawSize) {
+      dumpBlock(Reader(data, data + rawSize), names);
+      continue;
+    }
+#if AXE_ENABLE_ZLIB
+    decoded.resize(rawSize);
+    uLongf decodedSize = rawSize;
+    if (uncompress(decoded.data(), &decodedSize, data, storedSize) != Z_OK ||
+        decodedSize != rawSize)
+      error("corrupt compressed block");
+    dumpBlock(Reader(decoded.data(), decoded.data() + rawSize), names);
+#else
+    error("compressed blocks are not supported without zlib");
+#endif
+  }
+  return 0;
+}
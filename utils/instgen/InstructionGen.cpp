@@ -12,6 +12,7 @@
 #include <cctype>
 #include <cassert>
 #include "InstructionProperties.h"
+#include "InstructionDecodeTable.h"
 
 // TODO emit line markers.
 
@@ -165,6 +166,8 @@ private:
   bool mayDeschedule:1;
   bool disableJit:1;
   bool enableMemCheckOpt:1;
+  bool specialiseOperands:1;
+  bool mayAccessThreadState:1;
 public:
   Instruction(const std::string &n,
               unsigned s,
@@ -191,7 +194,9 @@ public:
     mayYield(false),
     mayDeschedule(false),
     disableJit(false),
-    enableMemCheckOpt(false)
+    enableMemCheckOpt(false),
+    specialiseOperands(false),
+    mayAccessThreadState(false)
   {
   }
   const std::string &getName() const { return name; }
@@ -226,6 +231,8 @@ public:
   bool getMayDeschedule() const { return mayDeschedule; }
   bool getDisableJit() const { return disableJit; }
   bool getEnableMemCheckOpt() const { return enableMemCheckOpt; }
+  bool getSpecialiseOperands() const { return specialiseOperands; }
+  bool getMayAccessThreadState() const { return mayAccessThreadState; }
   Instruction &addImplicitOp(ImplicitOp reg, OpType type) {
     assert(type != imm);
     implicitOps.push_back(reg);
@@ -297,6 +304,16 @@ public:
     enableMemCheckOpt = true;
     return *this;
   }
+  Instruction &setSpecialiseOperands() {
+    specialiseOperands = true;
+    return *this;
+  }
+  /// Mark the instruction as accessing the state of the thread or core
+  /// (THREAD / CORE) other than through its operands.
+  Instruction &setMayAccessThreadState() {
+    mayAccessThreadState = true;
+    return *this;
+  }
 };
 
 class InstructionRefs {
@@ -310,6 +327,7 @@ public:
   InstructionRefs &setCanEvent();
   InstructionRefs &setUnimplemented();
   InstructionRefs &setEnableMemCheckOpt();
+  InstructionRefs &setMayAccessThreadState();
 };
 
 InstructionRefs &InstructionRefs::
@@ -375,6 +393,15 @@ setEnableMemCheckOpt()
   return *this;
 }
 
+InstructionRefs &InstructionRefs::
+setMayAccessThreadState()
+{
+  for (Instruction *inst : refs) {
+    inst->setMayAccessThreadState();
+  }
+  return *this;
+}
+
 std::vector<Instruction*> instructions;
 
 Instruction &inst(const std::string &name,
@@ -469,14 +496,26 @@ isFixedRegister(const Instruction &inst, unsigned i, ImplicitOp &value)
   return true;
 }
 
+/// Returns whether operand i is an explicit register operand.
+static bool
+isRegisterOperand(const Instruction &inst, unsigned i)
+{
+  return i < inst.getNumExplicitOperands() && inst.getOperands()[i] != imm;
+}
+
 static std::string
-getOperandName(const Instruction &inst, unsigned i)
+getOperandName(const Instruction &inst, unsigned i, bool specialised = false)
 {
   ImplicitOp reg;
   if (isFixedRegister(inst, i, reg)) {
     return getImplicitOpName(reg);
   }
   std::ostringstream buf;
+  if (specialised && isRegisterOperand(inst, i)) {
+    // Register operands of specialised functions are template parameters.
+    buf << "reg" << i;
+    return buf.str();
+  }
   auto opsSize = inst.getOperands().size() - inst.getImplicitOps().size();
   const char *opMacro = "OP";
   buf << opMacro << '(' << i << ')';
@@ -677,8 +716,10 @@ void CodeEmitter::emitNested(const std::string &code)
 
 class FunctionCodeEmitter : public CodeEmitter {
   bool jit;
+  bool specialised;
 public:
-  FunctionCodeEmitter(bool isJit) : jit(isJit) {}
+  FunctionCodeEmitter(bool isJit, bool isSpecialised = false) :
+    jit(isJit), specialised(isSpecialised) {}
   const Instruction *inst;
   void emitCycles();
   void emitRegWriteBack();
@@ -709,8 +750,43 @@ private:
   bool shouldEmitMemoryChecks() {
     return !jit || !inst->getEnableMemCheckOpt();
   }
+  /// JIT functions are passed the register file so the JIT can substitute a
+  /// copy it keeps in host registers.
+  const char *getRegisterFileName() const {
+    return jit ? "regs" : "THREAD.regs";
+  }
+  void emitWatchpointBailout(const char *type, const char *addr,
+                             unsigned size);
+  void emitMemoryPredicateBailout(const char *addr, unsigned size);
 };
 
+/// JIT code can't throw the watchpoint exception. Instead if the access hits
+/// a watchpoint return to the interpreter before the access so the
+/// interpreter executes the instruction and reports the watchpoint.
+void FunctionCodeEmitter::
+emitWatchpointBailout(const char *type, const char *addr, unsigned size)
+{
+  std::cout << "  if (CORE.hitWatchpoint(WatchpointType::" << type << ", ";
+  std::cout << addr << ", " << size << ")) {\n";
+  std::cout << "    THREAD.pendingPc = THREAD.pc;\n";
+  std::cout << "    THREAD.pc = THREAD.getInterpretOneAddr();\n";
+  std::cout << "    return InstReturn::END_TRACE;\n";
+  std::cout << "  }\n";
+}
+
+/// Likewise stores to words watched by memory predicates are interpreted so
+/// the predicates are checked after the store.
+void FunctionCodeEmitter::
+emitMemoryPredicateBailout(const char *addr, unsigned size)
+{
+  std::cout << "  if (CORE.hitMemoryPredicate(" << addr << ", " << size;
+  std::cout << ")) {\n";
+  std::cout << "    THREAD.pendingPc = THREAD.pc;\n";
+  std::cout << "    THREAD.pc = THREAD.getInterpretOneAddr();\n";
+  std::cout << "    return InstReturn::END_TRACE;\n";
+  std::cout << "  }\n";
+}
+
 void FunctionCodeEmitter::emitBare(const std::string &s)
 {
   emitNested(s);
@@ -745,19 +821,16 @@ void FunctionCodeEmitter::emitRegWriteBack()
         }
         if (inst->getSize() == 2) {
           // Inlined THREAD.writeRegister( getOperandName(*inst, i), op i )
-          auto reg_index = getOperandName(*inst, i);
+          auto reg_index = getOperandName(*inst, i, specialised);
           std::cout << "if (!THREAD.dualIssue) {\n";
-          std::cout << "  THREAD.regs[" << reg_index << "] = op" << i << ";\n";
+          std::cout << "  " << getRegisterFileName() << "[" << reg_index;
+          std::cout << "] = op" << i << ";\n";
           std::cout << "} else {\n";
-          std::cout << "  if (!THREAD.bufferInitialized) {\n";
-          std::cout << "    THREAD.regsBuffer = THREAD.regs;\n";
-          std::cout << "    THREAD.bufferInitialized = true;\n";
-          std::cout << "  }\n";
-          std::cout << "  THREAD.regsBuffer[" << reg_index << "] = op" << i << ";\n";
+          std::cout << "  THREAD.logRegisterWrite(" << reg_index << ", op" << i << ");\n";
           std::cout << "}\n";
         } else {
-          std::cout << "THREAD.regs[" << getOperandName(*inst, i);
-          std::cout << "] = ";
+          std::cout << getRegisterFileName() << "[";
+          std::cout << getOperandName(*inst, i, specialised) << "] = ";
           std::cout << "op" << i << ";\n";
         }
       }
@@ -792,15 +865,13 @@ void FunctionCodeEmitter::emitRegWritePending()
 {
   if (inst->getSize() == 2) {
     // Inlined if (THREAD.pc %2 == 0) { THREAD.doPendingRegWrites(); }
-    std::cout << "  if (THREAD.bufferInitialized && THREAD.pc % 2 == 0) {\n";
-    std::cout << "    THREAD.regs.swap(THREAD.regsBuffer);\n";
-    std::cout << "    THREAD.bufferInitialized = false;\n";
+    std::cout << "  if (THREAD.numPendingRegWrites != 0 && THREAD.pc % 2 == 0) {\n";
+    std::cout << "    THREAD.commitPendingRegWrites();\n";
     std::cout << "  }\n";
   } else {
     // Inlined THREAD.doPendingRegWrites()
-    std::cout << "  if (THREAD.bufferInitialized) {\n";
-    std::cout << "    THREAD.regs.swap(THREAD.regsBuffer);\n";
-    std::cout << "    THREAD.bufferInitialized = false;\n";
+    std::cout << "  if (THREAD.numPendingRegWrites != 0) {\n";
+    std::cout << "    THREAD.commitPendingRegWrites();\n";
     std::cout << "  }\n";
   }
 }
@@ -960,6 +1031,10 @@ emitStore(const std::string &argString, LoadStoreType type)
     std::cout << "(StoreAddr)) {\n";
     emitException("ET_LOAD_STORE, StoreAddr");
     std::cout << "  }\n";
+    if (jit) {
+      emitWatchpointBailout("WRITE", "StoreAddr", getLoadStoreSize(type));
+      emitMemoryPredicateBailout("StoreAddr", getLoadStoreSize(type));
+    }
   }
 
   std::cout << "  STORE_" << getLoadStoreTypeName(type);
@@ -968,18 +1043,21 @@ emitStore(const std::string &argString, LoadStoreType type)
   std::cout << ", StoreAddr);\n";
 
   if (shouldEmitMemoryChecks()) {
-    unsigned ldst_size = getLoadStoreSize(type);
-
-
     std::cout << "  if (INVALIDATE_" << getLoadStoreTypeName(type);
     std::cout << "(StoreAddr)) {\n";
     std::cout << "    retval = InstReturn::END_TRACE;\n";
     std::cout << "  }\n";
+  }
+  if (shouldEmitMemoryChecks() && !jit) {
+    unsigned ldst_size = getLoadStoreSize(type);
     std::cout << "  if (CORE.hitWatchpoint(WatchpointType::WRITE, StoreAddr, " << ldst_size << ")) {\n";
     std::cout << "    watchpointHit = true;";
     std::cout << "    watchpointType = WatchpointType::WRITE;\n";
     std::cout << "    watchpointAddr = StoreAddr;\n";
     std::cout << "  }\n";
+    std::cout << "  if (CORE.hitMemoryPredicate(StoreAddr, " << ldst_size << ")) {\n";
+    std::cout << "    memoryPredicateHit = true;\n";
+    std::cout << "  }\n";
   }
 
   std::cout << "}\n";
@@ -1001,7 +1079,8 @@ emitLoad(const std::string &argString, LoadStoreType type)
   std::cout << ";\n";
 
   if (shouldEmitMemoryChecks()) {
-
+    if (jit)
+      emitWatchpointBailout("READ", "LoadAddr", getLoadStoreSize(type));
     std::cout << "  if (CHECK_ADDR_RAM_" << getLoadStoreTypeName(type);
     std::cout << "(LoadAddr)) {\n";
     std::cout << "    LoadResult = LOAD_RAM_" << getLoadStoreTypeName(type);
@@ -1020,7 +1099,7 @@ emitLoad(const std::string &argString, LoadStoreType type)
   emitNested(dest);
   std::cout << " = LoadResult;";
 
-  if(shouldEmitMemoryChecks()) {
+  if (shouldEmitMemoryChecks() && !jit) {
     unsigned ldst_size = getLoadStoreSize(type);
     std::cout << "  if (CORE.hitWatchpoint(WatchpointType::READ, LoadAddr, " << ldst_size << ")) {\n";
     std::cout << "    watchpointHit = true;";
@@ -1218,21 +1297,45 @@ static std::string getOperandDeclarationType(Instruction &inst, unsigned i)
   return "uint32_t";
 }
 
-static void emitInstFunction(Instruction &inst, bool jit)
+static std::string getSpecialisedInstFunctionName(Instruction &inst)
+{
+  return getInstFunctionName(inst) + "_specialised";
+}
+
+/// Emit the function implementing an instruction. If specialised is true the
+/// function is templated on the register numbers of its explicit register
+/// operands instead of reading them from the decode cache.
+static void emitInstFunction(Instruction &inst, bool jit,
+                             bool specialised = false)
 {
   if (inst.getCustom() || (jit && inst.getDisableJit()))
     return;
   assert((inst.getSize() & 1) == 0 && "Unexpected instruction size");
-  if (jit)
+  assert(!(jit && specialised));
+  if (jit) {
     std::cout << "extern \"C\" ";
+  } else {
+    std::cout << "template <bool tracing";
+    if (specialised) {
+      for (unsigned i = 0, e = inst.getNumExplicitOperands(); i != e; ++i) {
+        if (isRegisterOperand(inst, i))
+          std::cout << ", unsigned reg" << i;
+      }
+    }
+    std::cout << ">\n";
+  }
+  std::cout << "InstReturn ";
+  if (specialised)
+    std::cout << getSpecialisedInstFunctionName(inst);
   else
-    std::cout << "template <bool tracing>\n";
-  std::cout << "InstReturn " << getInstFunctionName(inst) << '(';
+    std::cout << getInstFunctionName(inst);
+  std::cout << '(';
   std::cout << "Thread &thread";
   if (jit) {
     std::cout << ", uint32_t nextPc";
     std::cout << ", const uint32_t ramBase";
     std::cout << ", const uint32_t ramSizeLog2";
+    std::cout << ", uint32_t *regs";
     for (unsigned i = 0, e = inst.getNumExplicitOperands(); i != e; ++i) {
       std::cout << ", uint32_t field" << i;
     }
@@ -1247,11 +1350,14 @@ static void emitInstFunction(Instruction &inst, bool jit)
       std::cout << "uint32_t nextPc = THREAD.pc + " << inst.getSize()/2;
       std::cout << ";\n";
     }
-    std::cout << "bool watchpointHit = false;\n";
-    std::cout << "WatchpointType watchpointType = WatchpointType::UNSET;\n";
-    std::cout << "uint32_t watchpointAddr = 0;";
+    if (!jit) {
+      std::cout << "bool watchpointHit = false;\n";
+      std::cout << "WatchpointType watchpointType = WatchpointType::UNSET;\n";
+      std::cout << "uint32_t watchpointAddr = 0;";
+      std::cout << "bool memoryPredicateHit = false;\n";
+    }
 
-    FunctionCodeEmitter emitter(jit);
+    FunctionCodeEmitter emitter(jit, specialised);
     emitter.setInstruction(inst);
     emitter.emitRegWritePending();
     if (inst.getYieldBefore()) {
@@ -1272,7 +1378,8 @@ static void emitInstFunction(Instruction &inst, bool jit)
         if (isSR(inst, i)) {
           std::cout << " = THREAD.sr";
         } else {
-          std::cout << " = THREAD.regs[" << getOperandName(inst, i) << ']';
+          std::cout << " = " << (jit ? "regs" : "THREAD.regs") << '[';
+          std::cout << getOperandName(inst, i, specialised) << ']';
         }
         break;
       case imm:
@@ -1293,20 +1400,33 @@ static void emitInstFunction(Instruction &inst, bool jit)
     emitter.emitUpdateExecutionFrequency();
 
 
-    std::cout << "if(watchpointHit) {\n";
-    std::cout << "    throw axe::WatchpointException(watchpointType, watchpointAddr, THREAD, THREAD.time);";
-    std::cout << "}\n";
+    if (!jit) {
+      std::cout << "if(memoryPredicateHit) {\n";
+      std::cout << "    CORE.checkMemoryPredicates(THREAD);\n";
+      std::cout << "}\n";
+      std::cout << "if(watchpointHit) {\n";
+      std::cout << "    throw axe::WatchpointException(watchpointType, watchpointAddr, THREAD, THREAD.time);";
+      std::cout << "}\n";
+    }
 
     emitter.emitNormalReturn();
   }
   std::cout << "}\n";
 }
 
+static bool canSpecialiseOperands(Instruction &inst)
+{
+  return inst.getSpecialiseOperands() && !inst.getCustom() &&
+         !inst.getUnimplemented();
+}
+
 static void emitInstFunctions()
 {
   std::cout << "#ifdef EMIT_INSTRUCTION_FUNCTIONS\n";
   for (Instruction *inst : instructions) {
     emitInstFunction(*inst, false);
+    if (canSpecialiseOperands(*inst))
+      emitInstFunction(*inst, false, true);
   }
   std::cout << "#endif //EMIT_INSTRUCTION_FUNCTIONS\n";
 }
@@ -1320,6 +1440,89 @@ static void emitJitInstFunctions()
   std::cout << "#endif //EMIT_JIT_INSTRUCTION_FUNCTIONS\n";
 }
 
+/// Register numbers a specialised register operand may take.
+const unsigned NUM_SPECIALISED_REGISTERS = 12;
+
+static std::vector<unsigned> getRegisterOperands(Instruction &inst)
+{
+  std::vector<unsigned> regs;
+  for (unsigned i = 0, e = inst.getNumExplicitOperands(); i != e; ++i) {
+    if (isRegisterOperand(inst, i))
+      regs.push_back(i);
+  }
+  return regs;
+}
+
+static void emitSpecialisedInstTable(Instruction &inst)
+{
+  std::vector<unsigned> regs = getRegisterOperands(inst);
+  unsigned size = 1;
+  for (unsigned i = 0, e = regs.size(); i != e; ++i)
+    size *= NUM_SPECIALISED_REGISTERS;
+  std::cout << "static OPCODE_TYPE " << getSpecialisedInstFunctionName(inst);
+  std::cout << "_table[" << size << "] = {\n";
+  for (unsigned index = 0; index != size; ++index) {
+    std::cout << "  &" << getSpecialisedInstFunctionName(inst) << "<false";
+    unsigned stride = size;
+    for (unsigned i = 0, e = regs.size(); i != e; ++i) {
+      stride /= NUM_SPECIALISED_REGISTERS;
+      std::cout << ", " << (index / stride) % NUM_SPECIALISED_REGISTERS;
+    }
+    std::cout << ">,\n";
+  }
+  std::cout << "};\n";
+}
+
+static void emitSpecialisedInstCase(Instruction &inst)
+{
+  std::vector<unsigned> regs = getRegisterOperands(inst);
+  std::cout << "  case " << inst.getName() << ":\n";
+  std::cout << "    if (";
+  for (unsigned i = 0, e = regs.size(); i != e; ++i) {
+    if (i != 0)
+      std::cout << " || ";
+    std::cout << "ops.ops[" << regs[i] << "] >= " << NUM_SPECIALISED_REGISTERS;
+  }
+  std::cout << ")\n";
+  std::cout << "      return nullptr;\n";
+  std::ostringstream index;
+  for (unsigned i = 0, e = regs.size(); i != e; ++i) {
+    if (i != 0) {
+      std::string outer = index.str();
+      index.str("");
+      index << '(' << outer << ") * " << NUM_SPECIALISED_REGISTERS << " + ";
+    }
+    index << "ops.ops[" << regs[i] << "]";
+  }
+  std::cout << "    return " << getSpecialisedInstFunctionName(inst);
+  std::cout << "_table[" << index.str() << "];\n";
+}
+
+/// Emit tables of the instantiations of each specialised function and a
+/// function that returns the instantiation matching the decoded operands or
+/// null if there is no specialised variant.
+static void emitSpecialisedInstTables()
+{
+  std::cout << "#ifdef EMIT_SPECIALISED_INSTRUCTION_TABLE\n";
+  for (Instruction *inst : instructions) {
+    if (canSpecialiseOperands(*inst))
+      emitSpecialisedInstTable(*inst);
+  }
+  std::cout << "static OPCODE_TYPE\n";
+  std::cout << "getSpecialisedInstruction(InstructionOpcode opc, ";
+  std::cout << "const Operands &ops) {\n";
+  std::cout << "  switch (opc) {\n";
+  std::cout << "  default:\n";
+  std::cout << "    return nullptr;\n";
+  for (Instruction *inst : instructions) {
+    if (canSpecialiseOperands(*inst))
+      emitSpecialisedInstCase(*inst);
+  }
+  std::cout << "  }\n";
+  std::cout << "}\n";
+  std::cout << "#endif //EMIT_SPECIALISED_INSTRUCTION_TABLE\n";
+}
+
 static void emitInstList(Instruction &instruction)
 {
   std::cout << "DO_INSTRUCTION(" << instruction.getName() << ")\n";
@@ -1358,6 +1561,22 @@ static void emitInstFlag(const char *name, bool &emittedFlag)
   emittedFlag = true;
 }
 
+/// Returns whether the instruction may access the state of the thread other
+/// than through its operands, either because it is declared to do so with
+/// setMayAccessThreadState() or because it has a special register operand.
+/// Exceptions are not included since they only access registers that are never
+/// operands of JIT compiled instructions.
+static bool mayAccessThreadState(const Instruction &inst)
+{
+  if (inst.getCustom() || inst.getMayKCall())
+    return true;
+  for (unsigned i = 0, e = inst.getNumOperands(); i != e; ++i) {
+    if (isSR(inst, i))
+      return true;
+  }
+  return inst.getMayAccessThreadState();
+}
+
 static void emitInstFlags(Instruction &inst)
 {
   bool emittedFlag = false;
@@ -1373,6 +1592,8 @@ static void emitInstFlags(Instruction &inst)
     emitInstFlag("MAY_END_TRACE", emittedFlag);
   if (inst.getEnableMemCheckOpt())
     emitInstFlag("MEM_CHECK_OPT_ENABLED", emittedFlag);
+  if (mayAccessThreadState(inst))
+    emitInstFlag("MAY_ACCESS_THREAD_STATE", emittedFlag);
   if (!emittedFlag)
     std::cout << 0;
 }
@@ -1919,7 +2140,8 @@ void add()
        "} else {\n"
        "  %exception(ET_ILLEGAL_RESOURCE, resID);\n"
        "}",
-       INSTRUCTION_CYCLES);
+       INSTRUCTION_CYCLES)
+    .setMayAccessThreadState();
   inst("TSETR_l3r", 4, ops(imm, in, in), "set t[%2]:r%0, %1",
        "ResourceID resID(%2);\n"
        "if (Thread *t = checkThread(CORE, resID)) {\n"
@@ -1927,7 +2149,8 @@ void add()
        "} else {\n"
        "  %exception(ET_ILLEGAL_RESOURCE, resID);\n"
        "}",
-       INSTRUCTION_CYCLES);
+       INSTRUCTION_CYCLES)
+    .setMayAccessThreadState();
   //fl3r("TSETR", "tsetr", "");
 
   fl3r_inout_inout("LSATS", "lsats %0, %1, %2",
@@ -2068,7 +2291,8 @@ void add()
             "} else {\n"
             "  %exception(ET_ILLEGAL_RESOURCE, resID);\n"
             "}\n")
-    .setYieldBefore();
+    .setYieldBefore()
+    .setMayAccessThreadState();
   fl2rus("INPW", "inpw %0, res[%1], %2",
          "ResourceID resID(%1);\n"
          "if (Port *res = checkPort(CORE, resID)) {\n"
@@ -2085,7 +2309,8 @@ void add()
          "} else {\n"
          "  %exception(ET_ILLEGAL_RESOURCE, resID);\n"
          "}\n")
-  .setYieldBefore();
+  .setYieldBefore()
+  .setMayAccessThreadState();
   fl3r_inout("CRC", "crc32 %0, %1, %2", "%0 = crc32(%0, %1, %2);");
   // TODO finish
   fl4r_out_out("LDD", "ldd_l4r %3, %0, %1",
@@ -2278,7 +2503,8 @@ void add()
        "if (!THREAD.setC(TIME, ResourceID(%0), %1)) {\n"
        "  %exception(ET_ILLEGAL_RESOURCE, %0)\n"
        "}\n")
-    .setYieldBefore().setCanEvent();
+    .setYieldBefore().setCanEvent()
+    .setMayAccessThreadState();
   fu6("EXTSP", "extsp %0", "%1 = %1 - %0;")
     .addImplicitOp(SP, inout)
     .transform("%0 = %0 << 2;", "%0 = %0 >> 2;");
@@ -2295,7 +2521,8 @@ void add()
     .addImplicitOp(SP, inout)
     .addImplicitOp(LR, in)
     .transform("%0 = %0 << 2;", "%0 = %0 >> 2;")
-    .setEnableMemCheckOpt();
+    .setEnableMemCheckOpt()
+    .setMayAccessThreadState();
   fu6("DUALENTSP", "dualentsp %0",
       "if (%0 > 0) {\n"
       "  uint32_t Addr = %1;\n"
@@ -2306,7 +2533,8 @@ void add()
     .addImplicitOp(SP, inout)
     .addImplicitOp(LR, in)
     .transform("%0 = %0 << 2;", "%0 = %0 >> 2;")
-    .setEnableMemCheckOpt();
+    .setEnableMemCheckOpt()
+    .setMayAccessThreadState();
   fu6("RETSP", "retsp %0",
       "if (%0 > 0) {\n"
       "  uint32_t Addr = %1 + %0;\n"
@@ -2340,7 +2568,8 @@ void add()
     .transform("%0 = %0 << 2;", "%0 = %0 >> 2;")
     .setEnableMemCheckOpt()
     // retsp always causes an fnop.
-    .setCycles(2 * INSTRUCTION_CYCLES);
+    .setCycles(2 * INSTRUCTION_CYCLES)
+    .setMayAccessThreadState();
   fu6("KRESTSP", "krestsp %0",
       "uint32_t Addr = %1 + %0;\n"
       "%load_word(%1, Addr)"
@@ -2401,20 +2630,23 @@ void add()
        "  %1 += FROM_PC(%pc) %% 4;\n"
        "}\n")
     .addImplicitOp(R11, out)
-    .transform("%0 = %0 << 1;", "%0 = %0 >> 1;");
+    .transform("%0 = %0 << 1;", "%0 = %0 >> 1;")
+    .setMayAccessThreadState();
   fu10("LDAPB", "ldap %1, -%0",
        "%1 = FROM_PC(%pc) - %0;\n"
        "if (THREAD.isDualIssue()) {\n"
        "  %1 += FROM_PC(%pc) %% 4;\n"
        "}\n")
     .addImplicitOp(R11, out)
-    .transform("%0 = %0 << 1;", "%0 = %0 >> 1;");
+    .transform("%0 = %0 << 1;", "%0 = %0 >> 1;")
+    .setMayAccessThreadState();
   fu10("BLRF", "bl %0",
        "%1 = FROM_PC(%pc);\n"
        "%1 = %1 | (THREAD.isDualIssue() ? 1 : 0);\n"
        "%write_pc_unchecked(%0);")
     .addImplicitOp(LR, out)
-    .transform("%0 = %pc + %0;", "%0 = %0 - %pc;");
+    .transform("%0 = %pc + %0;", "%0 = %0 - %pc;")
+    .setMayAccessThreadState();
   fu10("BLRF_illegal", "bl %0", "%exception(ET_ILLEGAL_PC, FROM_PC(%0))")
     .transform("%0 = %pc + %0;", "%0 = %0 - %pc;");
   fu10("BLRB", "bl -%0",
@@ -2423,7 +2655,8 @@ void add()
        "%write_pc_unchecked(%0);\n"
        "%yield")
     .addImplicitOp(LR, out)
-    .transform("%0 = %pc - %0;", "%0 = %pc - %0;");
+    .transform("%0 = %pc - %0;", "%0 = %pc - %0;")
+    .setMayAccessThreadState();
   fu10("BLRB_illegal", "bl -%0", "%exception(ET_ILLEGAL_PC, FROM_PC(%0))")
     .transform("%0 = %pc - %0;", "%0 = %pc - %0;");
   fu10("BLACP", "bla cp[%{cp}0]",
@@ -2454,7 +2687,8 @@ void add()
       "           CORE.allocResource(THREAD, (ResourceType)%1))\n"
       "  %0 = res->getID();\n"
       "else\n"
-      "  %0 = 0;\n");
+      "  %0 = 0;\n")
+    .setMayAccessThreadState();
   f2r("GETST", "getst %0, res[%1]",
       "ResourceID resID(%1);\n"
       "if (Synchroniser *sync = checkSync(CORE, resID)) {\n"
@@ -2467,7 +2701,8 @@ void add()
       "  }\n"
       "} else {\n"
       "  %exception(ET_ILLEGAL_RESOURCE, resID)\n"
-      "}\n");
+      "}\n")
+    .setMayAccessThreadState();
   f2r("PEEK", "peek %0, res[%1]",
       "ResourceID resID(%1);\n"
       "if (Port *res = checkPort(CORE, resID)) {\n"
@@ -2475,7 +2710,8 @@ void add()
       "} else {\n"
       "  %exception(ET_ILLEGAL_RESOURCE, resID);\n"
       "}\n")
-    .setYieldBefore();
+    .setYieldBefore()
+    .setMayAccessThreadState();
   f2r("ENDIN", "endin %0, res[%1]",
       "ResourceID resID(%1);\n"
       "if (Port *res = checkPort(CORE, resID)) {\n"
@@ -2491,7 +2727,8 @@ void add()
       "} else {\n"
       "  %exception(ET_ILLEGAL_RESOURCE, resID);\n"
       "}\n")
-    .setYieldBefore();
+    .setYieldBefore()
+    .setMayAccessThreadState();
   f2r_in("SETPSC", "setpsc res[%1], %0",
          "ResourceID resID(%1);\n"
          "if (Port *res = checkPort(CORE, resID)) {\n"
@@ -2507,7 +2744,8 @@ void add()
          "} else {\n"
          "  %exception(ET_ILLEGAL_RESOURCE, resID);\n"
          "}\n")
-    .setYieldBefore();
+    .setYieldBefore()
+    .setMayAccessThreadState();
   f2r("BITREV", "bitrev %0, %1", "%0 = bitReverse(%1);");
   fl2r("BITREV", "bitrev %0, %1", "%0 = bitReverse(%1);");
   f2r("BYTEREV", "byterev %0, %1", "%0 = bswap32(%1);");
@@ -2521,47 +2759,68 @@ void add()
           "  t->writeRegister(Register::LR, %0);\n"
           "} else {\n"
           "  %exception(ET_ILLEGAL_RESOURCE, resID);\n"
-          "}\n");
+          "}\n")
+    .setMayAccessThreadState();
   fl2r("GETD", "getd %0, res[%1]",
        "ResourceID resID(%1);\n"
        "Resource *res = checkResource(CORE, resID);\n"
        "if (!res || !res->getData(THREAD, %0, TIME)) {\n"
        "  %exception(ET_ILLEGAL_RESOURCE, resID);\n"
-       "};\n").setYieldBefore();
+       "};\n").setYieldBefore()
+    .setMayAccessThreadState();
   fl2r("TESTLCL", "testlcl %0, res[%1]", "").setUnimplemented();
   fl2r_in("SETN", "setn res[%1], %0", "").setUnimplemented();
   fl2r("GETN", "getn %0, res[%1]", "").setUnimplemented();
   fl2r("GETPS", "get %0, ps[%1]",
        "if (!CORE.getProcessorState(%1, %0)) {\n"
        "  %exception(ET_ILLEGAL_PS, %1)\n"
-       "}\n");
+       "}\n")
+    .setMayAccessThreadState();
   // Can't JIT SETPS as setting ram base invalidates the decode cache.
   fl2r_in("SETPS", "set %0, ps[%1]",
           "if (!setProcessorState(THREAD, %1, %0)) {\n"
           "  %exception(ET_ILLEGAL_PS, %1);\n"
-          "}\n").setDisableJit();
+          "}\n").setDisableJit()
+    .setMayAccessThreadState();
   fl2r_in("SETC", "setc res[%0], %1",
           "if (!THREAD.setC(TIME, ResourceID(%0), %1)) {\n"
           "  %exception(ET_ILLEGAL_RESOURCE, %0);\n"
-          "}\n").setYieldBefore().setCanEvent();
+          "}\n").setYieldBefore().setCanEvent()
+    .setMayAccessThreadState();
   fl2r_in("SETCLK", "setclk res[%1], %0",
           "if (!setClock(THREAD, ResourceID(%1), %0, TIME)) {\n"
           "  %exception(ET_ILLEGAL_RESOURCE, %1);\n"
-          "}\n").setYieldBefore();
+          "}\n").setYieldBefore()
+    .setMayAccessThreadState();
   fl2r_in("SETTW", "settw res[%1], %0",
           "Port *res = checkPort(CORE, ResourceID(%1));\n"
           "if (!res || !res->setTransferWidth(THREAD, %0, TIME)) {\n"
           "  %exception(ET_ILLEGAL_RESOURCE, %1);\n"
-          "}\n").setYieldBefore();
+          "}\n").setYieldBefore()
+    .setMayAccessThreadState();
   fl2r_in("SETRDY", "setrdy res[%1], %0",
           "if (!setReadyInstruction(THREAD, ResourceID(%1), %0, TIME)) {\n"
           "  %exception(ET_ILLEGAL_RESOURCE, %1);\n"
-          "}\n").setYieldBefore();
+          "}\n").setYieldBefore()
+    .setMayAccessThreadState();
   f2r("IN", "in %0, res[%1]",
       "ResourceID resID(%1);\n"
       "if (Resource *res = checkResource(CORE, resID)) {\n"
       "  uint32_t value;\n"
-      "  switch(res->in(THREAD, TIME, value)) {\n"
+      "  Resource::ResOpResult result;\n"
+      "  // Call chanends and ports directly so their fast paths are inlined.\n"
+      "  switch (res->getType()) {\n"
+      "  case RES_TYPE_CHANEND:\n"
+      "    result = static_cast<Chanend *>(res)->in(THREAD, TIME, value);\n"
+      "    break;\n"
+      "  case RES_TYPE_PORT:\n"
+      "    result = static_cast<Port *>(res)->in(THREAD, TIME, value);\n"
+      "    break;\n"
+      "  default:\n"
+      "    result = res->in(THREAD, TIME, value);\n"
+      "    break;\n"
+      "  }\n"
+      "  switch (result) {\n"
       "  case Resource::CONTINUE:\n"
       "    %0 = value;\n"
       "    break;\n"
@@ -2573,11 +2832,25 @@ void add()
       "} else {\n"
       "  %exception(ET_ILLEGAL_RESOURCE, resID);\n"
       "}\n")
-    .setYieldBefore();
+    .setYieldBefore()
+    .setMayAccessThreadState();
   f2r_in("OUT", "out res[%1], %0",
          "ResourceID resID(%1);\n"
          "if (Resource *res = checkResource(CORE, resID)) {\n"
-         "  switch (res->out(THREAD, %0, TIME)) {\n"
+         "  Resource::ResOpResult result;\n"
+         "  // Call chanends and ports directly so their fast paths are inlined.\n"
+         "  switch (res->getType()) {\n"
+         "  case RES_TYPE_CHANEND:\n"
+         "    result = static_cast<Chanend *>(res)->out(THREAD, %0, TIME);\n"
+         "    break;\n"
+         "  case RES_TYPE_PORT:\n"
+         "    result = static_cast<Port *>(res)->out(THREAD, %0, TIME);\n"
+         "    break;\n"
+         "  default:\n"
+         "    result = res->out(THREAD, %0, TIME);\n"
+         "    break;\n"
+         "  }\n"
+         "  switch (result) {\n"
          "  case Resource::CONTINUE:\n"
          "    break;\n"
          "  case Resource::DESCHEDULE:\n"
@@ -2589,7 +2862,8 @@ void add()
          "  %exception(ET_ILLEGAL_RESOURCE, resID);\n"
          "}\n")
     .setYieldBefore()
-    .setCanEvent();
+    .setCanEvent()
+    .setMayAccessThreadState();
   f2r_in("TINITPC", "init t[%1]:pc, %0",
          "ResourceID resID(%1);\n"
          "Thread *t = checkThread(CORE, resID);\n"
@@ -2607,7 +2881,8 @@ void add()
          "  }\n"
          "} else {\n"
          "  %exception(ET_ILLEGAL_RESOURCE, resID);\n"
-         "}\n");
+         "}\n")
+    .setMayAccessThreadState();
   fl2r_in("TINITPC", "init t[%1]:pc, %0",
          "ResourceID resID(%1);\n"
          "Thread *t = checkThread(CORE, resID);\n"
@@ -2625,7 +2900,8 @@ void add()
          "  }\n"
          "} else {\n"
          "  %exception(ET_ILLEGAL_RESOURCE, resID);\n"
-         "}\n");
+         "}\n")
+    .setMayAccessThreadState();
   f2r_in("TINITDP", "init t[%1]:dp, %0",
          "ResourceID resID(%1);\n"
          "Thread *t = checkThread(CORE, resID);\n"
@@ -2633,7 +2909,8 @@ void add()
          "  t->writeRegister(Register::DP, %0);\n"
          "} else {\n"
          "  %exception(ET_ILLEGAL_RESOURCE, resID);\n"
-         "}\n");
+         "}\n")
+    .setMayAccessThreadState();
   fl2r_in("TINITSP", "init t[%1]:sp, %0",
          "ResourceID resID(%1);\n"
          "Thread *t = checkThread(CORE, resID);\n"
@@ -2641,7 +2918,8 @@ void add()
          "  t->writeRegister(Register::SP, %0);\n"
          "} else {\n"
          "  %exception(ET_ILLEGAL_RESOURCE, resID);\n"
-         "}\n");
+         "}\n")
+    .setMayAccessThreadState();
   f2r_in("TINITSP", "init t[%1]:sp, %0",
          "ResourceID resID(%1);\n"
          "Thread *t = checkThread(CORE, resID);\n"
@@ -2649,7 +2927,8 @@ void add()
          "  t->writeRegister(Register::SP, %0);\n"
          "} else {\n"
          "  %exception(ET_ILLEGAL_RESOURCE, resID);\n"
-         "}\n");
+         "}\n")
+    .setMayAccessThreadState();
   f2r_in("TINITCP", "init t[%1]:cp, %0",
          "ResourceID resID(%1);\n"
          "Thread *t = checkThread(CORE, resID);\n"
@@ -2657,7 +2936,8 @@ void add()
          "  t->writeRegister(Register::CP, %0);\n"
          "} else {\n"
          "  %exception(ET_ILLEGAL_RESOURCE, resID);\n"
-         "}\n");
+         "}\n")
+    .setMayAccessThreadState();
   // TODO wrong format?
   f2r_in("TSETMR", "", "").setCustom();
 
@@ -2666,7 +2946,8 @@ void add()
          "Resource *res = checkResource(CORE, resID);\n"
          "if (!res || !res->setData(THREAD, %0, TIME)) {\n"
          "  %exception(ET_ILLEGAL_RESOURCE, resID);\n"
-         "};\n").setYieldBefore();
+         "};\n").setYieldBefore()
+    .setMayAccessThreadState();
   f2r_in("OUTCT", "outct res[%0], %1",
          "ResourceID resID(%0);\n"
          "if (Chanend *chanend = checkChanend(CORE, resID)) {\n"
@@ -2681,7 +2962,8 @@ void add()
          "  %exception(ET_ILLEGAL_RESOURCE, resID);\n"
          "}\n")
     .setYieldBefore()
-    .setCanEvent();
+    .setCanEvent()
+    .setMayAccessThreadState();
   frus_in("OUTCT", "outct res[%0], %1",
           "ResourceID resID(%0);\n"
           "if (Chanend *chanend = checkChanend(CORE, resID)) {\n"
@@ -2696,7 +2978,8 @@ void add()
           "  %exception(ET_ILLEGAL_RESOURCE, resID);\n"
           "}\n")
     .setYieldBefore()
-    .setCanEvent();
+    .setCanEvent()
+    .setMayAccessThreadState();
   f2r_in("OUTT", "outt res[%1], %0",
          "ResourceID resID(%1);\n"
          "if (Chanend *chanend = checkChanend(CORE, resID)) {\n"
@@ -2711,7 +2994,8 @@ void add()
          "  %exception(ET_ILLEGAL_RESOURCE, resID);\n"
          "}\n")
     .setYieldBefore()
-    .setCanEvent();
+    .setCanEvent()
+    .setMayAccessThreadState();
   f2r("INT", "int %0, res[%1]",
       "ResourceID resID(%1);\n"
       "if (Chanend *chanend = checkChanend(CORE, resID)) {\n"
@@ -2727,7 +3011,8 @@ void add()
       "  }\n"
       "} else {\n"
       "  %exception(ET_ILLEGAL_RESOURCE, resID);\n"
-      "}\n");
+      "}\n")
+    .setMayAccessThreadState();
   f2r("INCT", "inct %0, res[%1]",
       "ResourceID resID(%1);\n"
       "if (Chanend *chanend = checkChanend(CORE, resID)) {\n"
@@ -2744,7 +3029,8 @@ void add()
       "  }\n"
       "} else {\n"
       "  %exception(ET_ILLEGAL_RESOURCE, resID);\n"
-      "};\n");
+      "};\n")
+    .setMayAccessThreadState();
   f2r_in("CHKCT", "chkct res[%0], %1",
          "ResourceID resID(%0);\n"
          "if (Chanend *chanend = checkChanend(CORE, resID)) {\n"
@@ -2758,7 +3044,8 @@ void add()
          "  }\n"
          "} else {\n"
          "  %exception(ET_ILLEGAL_RESOURCE, resID);\n"
-         "}\n");
+         "}\n")
+    .setMayAccessThreadState();
   frus_in("CHKCT", "chkct res[%0], %1",
           "ResourceID resID(%0);\n"
           "if (Chanend *chanend = checkChanend(CORE, resID)) {\n"
@@ -2772,7 +3059,8 @@ void add()
           "  }\n"
           "} else {\n"
           "  %exception(ET_ILLEGAL_RESOURCE, resID);\n"
-          "}\n");
+          "}\n")
+    .setMayAccessThreadState();
   f2r("TESTCT", "testct %0, res[%1]",
       "ResourceID resID(%1);\n"
       "if (Chanend *chanend = checkChanend(CORE, resID)) {\n"
@@ -2784,7 +3072,8 @@ void add()
       "  }\n"
       "} else {\n"
       "  %exception(ET_ILLEGAL_RESOURCE, resID);\n"
-      "}\n");
+      "}\n")
+    .setMayAccessThreadState();
   f2r("TESTWCT", "testwct %0, res[%0]",
       "ResourceID resID(%1);\n"
       "if (Chanend *chanend = checkChanend(CORE, resID)) {\n"
@@ -2796,7 +3085,8 @@ void add()
       "  }\n"
       "} else {\n"
       "  %exception(ET_ILLEGAL_RESOURCE, resID);\n"
-      "}\n");
+      "}\n")
+    .setMayAccessThreadState();
   f2r_in("EET", "eet res[%1], %0",
          "ResourceID resID(%1);\n"
          "if (EventableResource *res = checkEventableResource(CORE, resID)) {\n"
@@ -2809,7 +3099,8 @@ void add()
          "  %exception(ET_ILLEGAL_RESOURCE, resID);\n"
          "}\n")
     .setYieldBefore()
-    .setCanEvent();
+    .setCanEvent()
+    .setMayAccessThreadState();
   f2r_in("EEF", "eef res[%1], %0",
          "ResourceID resID(%1);\n"
          "if (EventableResource *res = checkEventableResource(CORE, resID)) {\n"
@@ -2822,7 +3113,8 @@ void add()
          "  %exception(ET_ILLEGAL_RESOURCE, resID);\n"
          "}\n")
     .setYieldBefore()
-    .setCanEvent();
+    .setCanEvent()
+    .setMayAccessThreadState();
   f2r_inout("INSHR", "inshr %0, res[%1]",
             "ResourceID resID(%1);\n"
             "if (Port *res = checkPort(CORE, resID)) {\n"
@@ -2842,7 +3134,8 @@ void add()
             "} else {\n"
             "  %exception(ET_ILLEGAL_RESOURCE, resID);\n"
             "}\n")
-    .setYieldBefore();
+    .setYieldBefore()
+    .setMayAccessThreadState();
   f2r_inout("OUTSHR", "outshr %0, res[%1]",
             "ResourceID resID(%1);\n"
             "if (Port *res = checkPort(CORE, resID)) {\n"
@@ -2858,14 +3151,16 @@ void add()
             "} else {\n"
             "  %exception(ET_ILLEGAL_RESOURCE, %1);\n"
             "}\n")
-    .setYieldBefore();
+    .setYieldBefore()
+    .setMayAccessThreadState();
   f2r("GETTS", "getts %0, res[%1]",
       "ResourceID resID(%1);\n"
       "if (Port *res = checkPort(CORE, resID)) {\n"
       "  %0 = res->getTimestamp(THREAD, TIME);\n"
       "} else {\n"
       "  %exception(ET_ILLEGAL_RESOURCE, %1);\n"
-      "}\n").setYieldBefore();
+      "}\n").setYieldBefore()
+    .setMayAccessThreadState();
   f2r_in("SETPT", "setpt res[%1], %0",
          "ResourceID resID(%1);\n"
          "if (Port *res = checkPort(CORE, resID)) {\n"
@@ -2879,9 +3174,11 @@ void add()
          "  }\n"
          "} else {\n"
          "  %exception(ET_ILLEGAL_RESOURCE, %1);\n"
-         "}\n").setYieldBefore();
+         "}\n").setYieldBefore()
+    .setMayAccessThreadState();
 
-  f1r_out("GETTIME", "gettime %0", "%0 = THREAD.getReferenceTime();");
+  f1r_out("GETTIME", "gettime %0", "%0 = THREAD.getReferenceTime();")
+    .setMayAccessThreadState();
   f1r("ELATE", "gettime %0", "").setUnimplemented();
   f1r("SETSP", "set sp, %0", "%1 = %0;")
     .addImplicitOp(SP, out);
@@ -2906,11 +3203,13 @@ void add()
       "%1 = FROM_PC(%pc) | (uint32_t)THREAD.isDualIssue();\n"
       "%write_pc(%0);\n"
       "%yield\n")
-    .addImplicitOp(LR, out);
+    .addImplicitOp(LR, out)
+    .setMayAccessThreadState();
   f1r("BRU", "bru %0",
       "uint32_t target = FROM_PC(%pc + (%0 * (THREAD.isDualIssue() ? 2 : 1)));\n"
       "%write_pc(target);\n"
-      "%yield\n");
+      "%yield\n")
+    .setMayAccessThreadState();
   f1r("TSTART", "start t[%0]",
       "ResourceID resID(%0);\n"
       "Thread *t = checkThread(CORE, resID);\n"
@@ -2920,14 +3219,16 @@ void add()
       "  t->schedule();"
       "} else {\n"
       "  %exception(ET_ILLEGAL_RESOURCE, resID);\n"
-      "}\n");
+      "}\n")
+    .setMayAccessThreadState();
   f1r_out("DGETREG", "dgetreg %0", "").setUnimplemented();
   f1r("KCALL",  "kcall %0", "%kcall(%0)");
   f1r("FREER", "freer res[%0]",
       "Resource *res = checkResource(CORE, ResourceID(%0));\n"
       "if (!res || !res->free()) {\n"
       "  %exception(ET_ILLEGAL_RESOURCE, %0);\n"
-      "}\n");
+      "}\n")
+    .setMayAccessThreadState();
   f1r("MSYNC", "msync res[%0]",
       "ResourceID resID(%0);\n"
       "if (Synchroniser *sync = checkSync(CORE, resID)) {\n"
@@ -2940,7 +3241,8 @@ void add()
       "  }\n"
       "} else {\n"
       "  %exception(ET_ILLEGAL_RESOURCE, resID);\n"
-      "}\n");
+      "}\n")
+    .setMayAccessThreadState();
   f1r("MJOIN", "mjoin res[%0]",
       "ResourceID resID(%0);\n"
       "if (Synchroniser *sync = checkSync(CORE, resID)) {\n"
@@ -2954,7 +3256,8 @@ void add()
       "  }\n"
       "} else {\n"
       "  %exception(ET_ILLEGAL_RESOURCE, resID);\n"
-      "}\n");
+      "}\n")
+    .setMayAccessThreadState();
   f1r("SETV", "setv res[%0], %1",
       "ResourceID resID(%0);\n"
       "if (EventableResource *res = checkEventableResource(CORE, resID)) {\n"
@@ -2967,38 +3270,44 @@ void add()
       "  }\n"
       "} else {\n"
       "  %exception(ET_ILLEGAL_RESOURCE, resID);\n"
-      "}\n").addImplicitOp(R11, in).setYieldBefore();
+      "}\n").addImplicitOp(R11, in).setYieldBefore()
+    .setMayAccessThreadState();
   f1r("SETEV", "setev res[%0], %1",
       "ResourceID resID(%0);\n"
       "if (EventableResource *res = checkEventableResource(CORE, resID)) {\n"
       "  res->setEV(THREAD, %1);\n"
       "} else {\n"
       "  %exception(ET_ILLEGAL_RESOURCE, resID);\n"
-      "}\n").addImplicitOp(R11, in).setYieldBefore();
+      "}\n").addImplicitOp(R11, in).setYieldBefore()
+    .setMayAccessThreadState();
   f1r("EDU", "edu res[%0]",
       "ResourceID resID(%0);\n"
       "if (EventableResource *res = checkEventableResource(CORE, resID)) {\n"
       "  res->eventDisable(THREAD);\n"
       "} else {\n"
       "  %exception(ET_ILLEGAL_RESOURCE, resID);\n"
-      "}\n").setYieldBefore();
+      "}\n").setYieldBefore()
+    .setMayAccessThreadState();
   f1r("EEU", "eeu res[%0]",
       "ResourceID resID(%0);\n"
       "if (EventableResource *res = checkEventableResource(CORE, resID)) {\n"
       "  res->eventEnable(THREAD);\n"
       "} else {\n"
       "  %exception(ET_ILLEGAL_RESOURCE, resID);\n"
-      "}\n").setYieldBefore().setCanEvent();
+      "}\n").setYieldBefore().setCanEvent()
+    .setMayAccessThreadState();
   f1r("WAITET", "waitet %0",
       "if (%0) {\n"
       "  THREAD.enableEvents();\n"
       "  %deschedule\n"
-      "}\n").setYieldBefore().setCanEvent();
+      "}\n").setYieldBefore().setCanEvent()
+    .setMayAccessThreadState();
   f1r("WAITEF", "waitef %0",
       "if (!%0) {\n"
       "  THREAD.enableEvents();\n"
       "  %deschedule\n"
-      "}\n").setYieldBefore().setCanEvent();
+      "}\n").setYieldBefore().setCanEvent()
+    .setMayAccessThreadState();
   f1r("SYNCR", "syncr res[%0]",
       "ResourceID resID(%0);\n"
       "if (Port *port = checkPort(CORE, resID)) {\n"
@@ -3012,17 +3321,20 @@ void add()
       "} else {\n"
       "  %exception(ET_ILLEGAL_RESOURCE, resID);\n"
       "}\n"
-      ).setYieldBefore();
+      ).setYieldBefore()
+    .setMayAccessThreadState();
   f1r("CLRPT", "clrpt res[%0]",
       "ResourceID resID(%0);\n"
       "if (Port *res = checkPort(CORE, resID)) {\n"
       "  res->clearPortTime(THREAD, TIME);\n"
       "} else {\n"
       "  %exception(ET_ILLEGAL_RESOURCE, resID);\n"
-      "}\n").setYieldBefore();
+      "}\n").setYieldBefore()
+    .setMayAccessThreadState();
   f0r("NOP", "nop", "");
   f0r("GETID", "get %0, id", "%0 = THREAD.getNum();")
-    .addImplicitOp(R11, out);
+    .addImplicitOp(R11, out)
+    .setMayAccessThreadState();
   f0r("GETET", "get %0, %1", "%0 = %1;")
     .addImplicitOp(R11, out)
     .addImplicitOp(ET, in);
@@ -3111,14 +3423,17 @@ void add()
       "}\n"
       "THREAD.free();\n"
       "%deschedule\n"
-      );
+      )
+    .setMayAccessThreadState();
   f0r("DCALL", "dcall", "").setUnimplemented();
   f0r("DRET", "dret", "").setUnimplemented();
   f0r("DENTSP", "dentsp", "").setUnimplemented();
-  f0r("CLRE", "clre", "THREAD.clre();\n").setYieldBefore();
+  f0r("CLRE", "clre", "THREAD.clre();\n").setYieldBefore()
+    .setMayAccessThreadState();
   f0r("WAITEU", "waiteu",
       "THREAD.enableEvents();\n"
-      "%deschedule\n").setYieldBefore().setCanEvent();
+      "%deschedule\n").setYieldBefore().setCanEvent()
+    .setMayAccessThreadState();
   f0r("SSYNC", "ssync",
       "Synchroniser *sync = THREAD.getSync();\n"
       "if (!sync) {\n"
@@ -3136,10 +3451,12 @@ void add()
       "      %deschedule;\n"
       "      break;\n"
       "  }\n"
-      "}\n");
+      "}\n")
+    .setMayAccessThreadState();
   pseudoInst("ILLEGAL_PC", "", "%exception(ET_ILLEGAL_PC, FROM_PC(%pc) - 2)");
   pseudoInst("ILLEGAL_PC_THREAD", "",
-             "%exception(ET_ILLEGAL_PC, THREAD.pendingPc)");
+             "%exception(ET_ILLEGAL_PC, THREAD.pendingPc)")
+    .setMayAccessThreadState();
   pseudoInst("ILLEGAL_INSTRUCTION", "",
              "%exception(ET_ILLEGAL_INSTRUCTION, 0)");
   pseudoInst("BREAKPOINT", "", "").setCustom();
@@ -3148,13 +3465,601 @@ void add()
   pseudoInst("DECODE", "", "").setCustom();
 }
 
-int main()
+enum DecodeTarget {
+  ALL_TARGETS,
+  XS1_ONLY,
+  XS2_ONLY
+};
+
+/// The decode table entries for one major opcode.
+class DecodeMajor {
+  DecodeLayout layout;
+  std::vector<std::string> opcodes[2];
+  std::vector<std::string> operands[2];
+public:
+  DecodeMajor() : layout(DECODE_LAYOUT_NONE) {}
+  void setLayout(DecodeLayout value) { layout = value; }
+  DecodeLayout getLayout() const { return layout; }
+  void resize(unsigned size) {
+    for (unsigned i = 0; i < 2; i++) {
+      opcodes[i].resize(size);
+      operands[i].resize(size);
+    }
+  }
+  const std::string &getOpcode(unsigned target, unsigned minor) const {
+    return opcodes[target][minor];
+  }
+  const std::string &getOperands(unsigned target, unsigned minor) const {
+    return operands[target][minor];
+  }
+  DecodeMajor &add(unsigned minor, const std::string &opcode,
+                   const std::string &ops, DecodeTarget target);
+
+  // 16 bit instructions and the second word of prefixed instructions.
+  DecodeMajor &r3(const std::string &opcode, const std::string &ops,
+                  DecodeTarget target = ALL_TARGETS) {
+    return add(DECODE_MINOR_3R, opcode, ops, target);
+  }
+  DecodeMajor &r2(unsigned bit4, const std::string &opcode,
+                  const std::string &ops, DecodeTarget target = ALL_TARGETS) {
+    return add(DECODE_MINOR_2R + bit4, opcode, ops, target);
+  }
+  DecodeMajor &r1(unsigned bit4, const std::string &opcode,
+                  DecodeTarget target = ALL_TARGETS) {
+    for (unsigned reg = 0; reg < 12; reg++) {
+      add(DECODE_MINOR_1R + (bit4 << 4 | reg), opcode, "1R", target);
+    }
+    return *this;
+  }
+  DecodeMajor &r0(uint16_t encoding, const std::string &opcode,
+                  DecodeTarget target = ALL_TARGETS) {
+    return add(getShortDecodeMinor(layout, encoding), opcode, "NONE", target);
+  }
+  DecodeMajor &ru6(unsigned bit10, const std::string &opcode,
+                   const std::string &ops) {
+    return add(DECODE_MINOR_RU6 + bit10, opcode, ops, ALL_TARGETS);
+  }
+  DecodeMajor &u6(unsigned bits10To6, const std::string &opcode,
+                  const std::string &ops, DecodeTarget target = ALL_TARGETS) {
+    unsigned minor = DECODE_MINOR_U6 + ((bits10To6 >> 4) << 2 |
+                                        (bits10To6 & 3));
+    return add(minor, opcode, ops, target);
+  }
+  DecodeMajor &u10(unsigned bit10, const std::string &opcode,
+                   const std::string &ops) {
+    return add(DECODE_MINOR_U10 + bit10, opcode, ops, ALL_TARGETS);
+  }
+
+  // Extended (eopr) instructions.
+  DecodeMajor &l6r(const std::string &opcode) {
+    return add(DECODE_MINOR_L6R, opcode, "L6R", ALL_TARGETS);
+  }
+  DecodeMajor &l5r(unsigned highBit4, const std::string &opcode,
+                   DecodeTarget target = ALL_TARGETS) {
+    return add(DECODE_MINOR_L5R + highBit4, opcode, "L5R", target);
+  }
+  DecodeMajor &l4r(unsigned highBit4, const std::string &opcode,
+                   const std::string &ops, DecodeTarget target = ALL_TARGETS) {
+    for (unsigned reg = 0; reg < 12; reg++) {
+      add(DECODE_MINOR_L4R + (highBit4 << 4 | reg), opcode, ops, target);
+    }
+    return *this;
+  }
+  DecodeMajor &l3r(unsigned highBits3To0, const std::string &opcode,
+                   const std::string &ops, DecodeTarget target = ALL_TARGETS) {
+    return add(DECODE_MINOR_L4R + highBits3To0, opcode, ops, target);
+  }
+  DecodeMajor &l2r(unsigned lowBit4, unsigned highBits3To0,
+                   const std::string &opcode,
+                   DecodeTarget target = ALL_TARGETS) {
+    return add(DECODE_MINOR_L2R + (lowBit4 << 4 | highBits3To0), opcode,
+               "L2R", target);
+  }
+  DecodeMajor &l0r(const std::string &opcode) {
+    // Words which don't match the l3r encoding but do match the 3r encoding
+    // of the l4r / l3r word also decode as l0r.
+    for (unsigned bits3To0 = 12; bits3To0 < 16; bits3To0++) {
+      add(DECODE_MINOR_L4R + (1 << 4 | bits3To0), opcode, "NONE", ALL_TARGETS);
+    }
+    return add(DECODE_MINOR_L0R, opcode, "NONE", ALL_TARGETS);
+  }
+  DecodeMajor &all(const std::string &opcode, const std::string &ops,
+                   DecodeTarget target) {
+    for (unsigned minor = 0; minor < opcodes[0].size(); minor++) {
+      add(minor, opcode, ops, target);
+    }
+    return *this;
+  }
+};
+
+static Instruction *findInstruction(const std::string &name)
+{
+  for (Instruction *inst : instructions) {
+    if (inst->getName() == name)
+      return inst;
+  }
+  return nullptr;
+}
+
+static bool isInstruction(const std::string &name)
+{
+  return findInstruction(name) != nullptr;
+}
+
+DecodeMajor &DecodeMajor::
+add(unsigned minor, const std::string &opcode, const std::string &ops,
+    DecodeTarget target)
 {
+  if (!isInstruction(opcode)) {
+    std::cerr << "Unknown instruction " << opcode << " in decode table\n";
+    std::exit(1);
+  }
+  for (unsigned i = 0; i < 2; i++) {
+    if ((target == XS1_ONLY && i == 1) || (target == XS2_ONLY && i == 0))
+      continue;
+    assert(minor < opcodes[i].size());
+    if (!opcodes[i][minor].empty()) {
+      std::cerr << "Conflicting decodings " << opcodes[i][minor] << " and "
+                << opcode << " in decode table\n";
+      std::exit(1);
+    }
+    opcodes[i][minor] = opcode;
+    operands[i][minor] = ops;
+  }
+  return *this;
+}
+
+const unsigned NUM_MAJOR_OPCODES = 32;
+DecodeMajor shortDecodeTable[NUM_MAJOR_OPCODES];
+DecodeMajor pfixDecodeTable[NUM_MAJOR_OPCODES];
+DecodeMajor eoprDecodeTable[NUM_MAJOR_OPCODES];
+
+static DecodeMajor &shortMajor(unsigned opc, DecodeLayout layout)
+{
+  DecodeMajor &major = shortDecodeTable[opc];
+  major.setLayout(layout);
+  return major;
+}
+
+static DecodeMajor &pfixMajor(unsigned opc, DecodeLayout layout)
+{
+  DecodeMajor &major = pfixDecodeTable[opc];
+  major.setLayout(layout);
+  return major;
+}
+
+static DecodeMajor &eoprMajor(unsigned opc)
+{
+  return eoprDecodeTable[opc];
+}
+
+void addEncodings()
+{
+  for (unsigned i = 0; i < NUM_MAJOR_OPCODES; i++) {
+    shortDecodeTable[i].resize(DECODE_MINOR_SHORT_COUNT);
+    pfixDecodeTable[i].resize(DECODE_MINOR_SHORT_COUNT);
+    eoprDecodeTable[i].resize(DECODE_MINOR_EOPR_COUNT);
+  }
+
+  shortMajor(0x00, DECODE_LAYOUT_3R)
+    .r3("STW_2rus", "2RUS")
+    .r2(0, "TINITPC_2r", "2R", XS1_ONLY)
+    .r2(0, "BYTEREV_2r", "2R", XS2_ONLY)
+    .r2(1, "GETST_2r", "2R")
+    .r1(0, "EDU_1r")
+    .r1(1, "EEU_1r")
+    .r0(0x07ec, "WAITEU_0r")
+    .r0(0x07ed, "CLRE_0r")
+    .r0(0x07ee, "SSYNC_0r")
+    .r0(0x07ef, "FREET_0r")
+    .r0(0x07fc, "DCALL_0r")
+    .r0(0x07fd, "KRET_0r", XS1_ONLY)
+    .r0(0x07fe, "DRET_0r", XS1_ONLY)
+    .r0(0x07ff, "SETKEP_0r");
+  shortMajor(0x01, DECODE_LAYOUT_3R)
+    .r3("LDW_2rus", "2RUS")
+    .r2(0, "TINITDP_2r", "2R", XS1_ONLY)
+    .r2(0, "CLZ_2r", "2R", XS2_ONLY)
+    .r2(1, "OUTT_2r", "2R")
+    .r1(0, "WAITET_1r")
+    .r1(1, "WAITEF_1r")
+    .r0(0x0fec, "LDSPC_0r")
+    .r0(0x0fed, "STSPC_0r")
+    .r0(0x0fee, "LDSSR_0r")
+    .r0(0x0fef, "STSSR_0r")
+    .r0(0x0ffc, "STSED_0r")
+    .r0(0x0ffd, "STET_0r")
+    .r0(0x0ffe, "GETED_0r")
+    .r0(0x0fff, "GETET_0r");
+  shortMajor(0x02, DECODE_LAYOUT_3R)
+    .r3("ADD_3r", "3R")
+    .r2(0, "TINITSP_2r", "2R", XS1_ONLY)
+    .r2(0, "BITREV_2r", "2R", XS2_ONLY)
+    .r2(1, "SETD_2r", "2R")
+    .r1(0, "FREER_1r")
+    .r1(1, "MJOIN_1r")
+    .r0(0x17ec, "DENTSP_0r", XS1_ONLY)
+    .r0(0x17ed, "DRESTSP_0r", XS1_ONLY)
+    .r0(0x17ee, "GETID_0r")
+    .r0(0x17ef, "GETKEP_0r")
+    .r0(0x17fc, "GETKSP_0r")
+    .r0(0x17fd, "LDSED_0r")
+    .r0(0x17fe, "LDET_0r")
+    .r0(0x17ff, "NOP_0r", XS2_ONLY);
+  shortMajor(0x03, DECODE_LAYOUT_3R)
+    .r3("SUB_3r", "3R")
+    .r2(0, "TINITCP_2r", "2R", XS1_ONLY)
+    .r2(1, "TSETMR_2r", "2R", XS1_ONLY)
+    .r1(0, "TSTART_1r")
+    .r1(1, "MSYNC_1r");
+  shortMajor(0x04, DECODE_LAYOUT_3R)
+    .r3("SHL_3r", "3R")
+    .r2(1, "EET_2r", "2R")
+    .r1(0, "BLA_1r")
+    .r1(1, "BAU_1r");
+  shortMajor(0x05, DECODE_LAYOUT_3R)
+    .r3("SHR_3r", "3R")
+    .r2(0, "ANDNOT_2r", "2R")
+    .r2(1, "EEF_2r", "2R")
+    .r1(0, "BRU_1r")
+    .r1(1, "SETSP_1r");
+  shortMajor(0x06, DECODE_LAYOUT_3R)
+    .r3("EQ_3r", "3R")
+    .r2(0, "SEXT_2r", "2R")
+    .r2(1, "SEXT_rus", "RUS_BITP")
+    .r1(0, "SETDP_1r")
+    .r1(1, "SETCP_1r");
+  shortMajor(0x07, DECODE_LAYOUT_3R)
+    .r3("AND_3r", "3R")
+    .r2(0, "GETTS_2r", "2R")
+    .r2(1, "SETPT_2r", "2R")
+    .r1(0, "DGETREG_1r")
+    .r1(1, "SETEV_1r");
+  shortMajor(0x08, DECODE_LAYOUT_3R)
+    .r3("OR_3r", "3R")
+    .r2(0, "ZEXT_2r", "2R")
+    .r2(1, "ZEXT_rus", "RUS_BITP")
+    .r1(0, "KCALL_1r")
+    .r1(1, "SETV_1r");
+  shortMajor(0x09, DECODE_LAYOUT_3R)
+    .r3("LDW_3r", "3R")
+    .r2(0, "OUTCT_2r", "2R")
+    .r2(1, "OUTCT_rus", "RUS")
+    .r1(0, "ECALLF_1r")
+    .r1(1, "ECALLT_1r");
+  shortMajor(0x0a, DECODE_LAYOUT_RU6)
+    .ru6(0, "STWDP_ru6", "RU6")
+    .ru6(1, "STWSP_ru6", "RU6");
+  shortMajor(0x0b, DECODE_LAYOUT_RU6)
+    .ru6(0, "LDWDP_ru6", "RU6")
+    .ru6(1, "LDWSP_ru6", "RU6");
+  shortMajor(0x0c, DECODE_LAYOUT_RU6)
+    .ru6(0, "LDAWDP_ru6", "RU6")
+    .ru6(1, "LDAWSP_ru6", "RU6");
+  shortMajor(0x0d, DECODE_LAYOUT_RU6)
+    .ru6(0, "LDC_ru6", "RU6")
+    .ru6(1, "LDWCP_ru6", "RU6");
+  shortMajor(0x0e, DECODE_LAYOUT_RU6_U6)
+    .ru6(0, "BRFT_ru6", "RU6")
+    .ru6(1, "BRBT_ru6", "RU6")
+    .u6(0x0c, "BRFU_u6", "U6")
+    .u6(0x0d, "BLAT_u6", "U6")
+    .u6(0x0e, "EXTDP_u6", "U6")
+    .u6(0x0f, "KCALL_u6", "U6")
+    .u6(0x1c, "BRBU_u6", "U6")
+    .u6(0x1d, "ENTSP_u6", "U6")
+    .u6(0x1e, "EXTSP_u6", "U6")
+    .u6(0x1f, "RETSP_u6", "U6", XS1_ONLY)
+    .u6(0x1f, "RETSP_xs2a_u6", "U6", XS2_ONLY);
+  shortMajor(0x0f, DECODE_LAYOUT_RU6_U6)
+    .ru6(0, "BRFF_ru6", "RU6")
+    .ru6(1, "BRBF_ru6", "RU6")
+    .u6(0x0c, "CLRSR_u6", "U6")
+    .u6(0x0d, "SETSR_u6", "U6")
+    .u6(0x0e, "KENTSP_u6", "U6")
+    .u6(0x0f, "KRESTSP_u6", "U6", XS1_ONLY)
+    .u6(0x1c, "GETSR_u6", "U6")
+    .u6(0x1d, "LDAWCP_u6", "U6")
+    .u6(0x1e, "DUALENTSP_u6", "U6", XS2_ONLY);
+  shortMajor(0x10, DECODE_LAYOUT_3R)
+    .r3("LD16S_3r", "3R")
+    .r2(0, "GETR_rus", "RUS")
+    .r2(1, "INCT_2r", "2R")
+    .r1(0, "CLRPT_1r")
+    .r1(1, "SYNCR_1r");
+  shortMajor(0x11, DECODE_LAYOUT_3R)
+    .r3("LD8U_3r", "3R")
+    .r2(0, "NOT_2r", "2R")
+    .r2(1, "INT_2r", "2R")
+    .r1(0, "GETTIME_1r", XS2_ONLY)
+    .r1(1, "ELATE_1r", XS2_ONLY);
+  shortMajor(0x12, DECODE_LAYOUT_3R)
+    .r3("ADD_2rus", "2RUS")
+    .r2(0, "NEG_2r", "2R")
+    .r2(1, "ENDIN_2r", "2R");
+  shortMajor(0x13, DECODE_LAYOUT_3R)
+    .r3("SUB_2rus", "2RUS");
+  shortMajor(0x14, DECODE_LAYOUT_3R)
+    .r3("SHL_2rus", "2RUS_BITP")
+    .r2(0, "MKMSK_2r", "2R")
+    .r2(1, "MKMSK_rus", "RUS_BITP");
+  shortMajor(0x15, DECODE_LAYOUT_3R)
+    .r3("SHR_2rus", "2RUS_BITP")
+    .r2(0, "OUT_2r", "2R")
+    .r2(1, "OUTSHR_2r", "2R");
+  shortMajor(0x16, DECODE_LAYOUT_3R)
+    .r3("EQ_2rus", "2RUS")
+    .r2(0, "IN_2r", "2R")
+    .r2(1, "INSHR_2r", "2R");
+  shortMajor(0x17, DECODE_LAYOUT_3R)
+    .r3("TSETR_3r", "3R", XS1_ONLY)
+    .r2(0, "PEEK_2r", "2R")
+    .r2(1, "TESTCT_2r", "2R");
+  shortMajor(0x18, DECODE_LAYOUT_3R)
+    .r3("LSS_3r", "3R")
+    .r2(0, "SETPSC_2r", "2R")
+    .r2(1, "TESTWCT_2r", "2R");
+  shortMajor(0x19, DECODE_LAYOUT_3R)
+    .r3("LSU_3r", "3R")
+    .r2(0, "CHKCT_2r", "2R")
+    .r2(1, "CHKCT_rus", "RUS");
+  shortMajor(0x1a, DECODE_LAYOUT_U10)
+    .u10(0, "BLRF_u10", "U10")
+    .u10(1, "BLRB_u10", "U10");
+  shortMajor(0x1b, DECODE_LAYOUT_U10)
+    .u10(0, "LDAPF_u10", "U10")
+    .u10(1, "LDAPB_u10", "U10");
+  shortMajor(0x1c, DECODE_LAYOUT_U10)
+    .u10(0, "BLACP_u10", "U10")
+    .u10(1, "LDWCPL_u10", "U10");
+  shortMajor(0x1d, DECODE_LAYOUT_RU6_U6)
+    .ru6(0, "SETC_ru6", "RU6");
+
+  pfixMajor(0x0a, DECODE_LAYOUT_RU6)
+    .ru6(0, "STWDP_lru6", "LRU6")
+    .ru6(1, "STWSP_lru6", "LRU6");
+  pfixMajor(0x0b, DECODE_LAYOUT_RU6)
+    .ru6(0, "LDWDP_lru6", "LRU6")
+    .ru6(1, "LDWSP_lru6", "LRU6");
+  pfixMajor(0x0c, DECODE_LAYOUT_RU6)
+    .ru6(0, "LDAWDP_lru6", "LRU6")
+    .ru6(1, "LDAWSP_lru6", "LRU6");
+  pfixMajor(0x0d, DECODE_LAYOUT_RU6)
+    .ru6(0, "LDC_lru6", "LRU6")
+    .ru6(1, "LDWCP_lru6", "LRU6");
+  pfixMajor(0x0e, DECODE_LAYOUT_RU6_U6)
+    .ru6(0, "BRFT_lru6", "LRU6")
+    .ru6(1, "BRBT_lru6", "LRU6")
+    .u6(0x0c, "BRFU_lu6", "LU6")
+    .u6(0x0d, "BLAT_lu6", "LU6")
+    .u6(0x0e, "EXTDP_lu6", "LU6")
+    .u6(0x0f, "KCALL_lu6", "LU6")
+    .u6(0x1c, "BRBU_lu6", "LU6")
+    .u6(0x1d, "ENTSP_lu6", "LU6")
+    .u6(0x1e, "EXTSP_lu6", "LU6")
+    .u6(0x1f, "RETSP_lu6", "LU6", XS1_ONLY)
+    .u6(0x1f, "RETSP_xs2a_lu6", "LU6", XS2_ONLY);
+  pfixMajor(0x0f, DECODE_LAYOUT_RU6_U6)
+    .ru6(0, "BRFF_lru6", "LRU6")
+    .ru6(1, "BRBF_lru6", "LRU6")
+    .u6(0x0c, "CLRSR_lu6", "LU6")
+    .u6(0x0d, "SETSR_lu6", "LU6")
+    .u6(0x0e, "KENTSP_lu6", "LU6")
+    .u6(0x0f, "KRESTSP_lu6", "LU6")
+    .u6(0x1c, "GETSR_lu6", "LU6")
+    .u6(0x1d, "LDAWCP_lu6", "LU6")
+    .u6(0x1e, "DUALENTSP_lu6", "LU6", XS2_ONLY);
+  pfixMajor(0x1a, DECODE_LAYOUT_U10)
+    .u10(0, "BLRF_lu10", "LU10")
+    .u10(1, "BLRB_lu10", "LU10");
+  pfixMajor(0x1b, DECODE_LAYOUT_U10)
+    .u10(0, "LDAPF_lu10", "LU10")
+    .u10(1, "LDAPB_lu10", "LU10");
+  pfixMajor(0x1c, DECODE_LAYOUT_U10)
+    .u10(0, "BLACP_lu10", "LU10")
+    .u10(1, "LDWCPL_lu10", "LU10");
+  pfixMajor(0x1d, DECODE_LAYOUT_RU6_U6)
+    .ru6(0, "SETC_lru6", "LRU6");
+
+  eoprMajor(0x00)
+    .l6r("LMUL_l6r")
+    .l5r(0, "LDIVU_l5r")
+    .l5r(1, "LADD_l5r")
+    .l4r(0, "CRC8_l4r", "L4R")
+    .l4r(1, "MACCU_l4r", "L4R")
+    .l3r(0xc, "STW_l3r", "L3R")
+    .l2r(0, 0xc, "BITREV_l2r", XS1_ONLY)
+    .l2r(0, 0xc, "TINITSP_l2r", XS2_ONLY)
+    .l2r(1, 0xc, "BYTEREV_l2r", XS1_ONLY)
+    .l2r(1, 0xc, "TINITPC_l2r", XS2_ONLY)
+    .l0r("KRET_l0r");
+  eoprMajor(0x01)
+    .l5r(0, "LSUB_l5r")
+    .l5r(1, "XOR4_l5r", XS2_ONLY)
+    .l4r(0, "MACCS_l4r", "L4R")
+    .l4r(1, "CRCN_l4r", "L4R", XS2_ONLY)
+    .l3r(0xc, "XOR_l3r", "L3R")
+    .l2r(0, 0xc, "CLZ_l2r", XS1_ONLY)
+    .l2r(1, 0xc, "SETCLK_l2r");
+  eoprMajor(0x02)
+    .l4r(0, "STD_l4r", "L4R", XS2_ONLY)
+    .l4r(1, "STD_l3rus", "L3RUS", XS2_ONLY)
+    .l3r(0xc, "ASHR_l3r", "L3R")
+    .l2r(0, 0xc, "TINITLR_l2r")
+    .l2r(1, 0xc, "GETPS_l2r");
+  eoprMajor(0x03)
+    .l5r(0, "LEXTRACT_l4rus", XS2_ONLY)
+    .l3r(0xc, "LDAWF_l3r", "L3R")
+    .l2r(0, 0xc, "SETPS_l2r")
+    .l2r(1, 0xc, "GETD_l2r");
+  eoprMajor(0x04)
+    .l4r(0, "LDD_l4r", "L4R", XS2_ONLY)
+    .l4r(1, "LDD_l3rus", "L3RUS", XS2_ONLY)
+    .l3r(0xc, "LDAWB_l3r", "L3R")
+    .l2r(0, 0xc, "TESTLCL_l2r")
+    .l2r(1, 0xc, "SETTW_l2r");
+  eoprMajor(0x05)
+    .l3r(0xc, "LDA16F_l3r", "L3R")
+    .l2r(0, 0xc, "SETRDY_l2r")
+    .l2r(1, 0xc, "SETC_l2r");
+  eoprMajor(0x06)
+    .l3r(0xc, "LDA16B_l3r", "L3R")
+    .l2r(0, 0xc, "SETN_l2r")
+    .l2r(1, 0xc, "GETN_l2r");
+  eoprMajor(0x07)
+    .l3r(0xc, "MUL_l3r", "L3R");
+  eoprMajor(0x08)
+    .l3r(0xc, "DIVS_l3r", "L3R");
+  eoprMajor(0x09)
+    .l3r(0xc, "DIVU_l3r", "L3R");
+  eoprMajor(0x10)
+    .l3r(0xc, "ST16_l3r", "L3R");
+  eoprMajor(0x11)
+    .l3r(0xc, "ST8_l3r", "L3R");
+  eoprMajor(0x12)
+    .l3r(0xc, "ASHR_l2rus", "L2RUS_BITP")
+    .l3r(0xd, "OUTPW_l2rus", "L2RUS_BITP")
+    .l3r(0xe, "INPW_l2rus", "L2RUS_BITP");
+  eoprMajor(0x13)
+    .l3r(0xc, "LDAWF_l2rus", "L2RUS")
+    .l3r(0xd, "UNZIP_l2rus", "L2RUS", XS2_ONLY)
+    .l3r(0xe, "ZIP_l2rus", "L2RUS", XS2_ONLY);
+  eoprMajor(0x14)
+    .l3r(0xc, "LDAWB_l2rus", "L2RUS");
+  eoprMajor(0x15)
+    .l3r(0xc, "CRC_l3r", "L3R");
+  eoprMajor(0x16)
+    .all("TSETR_l3r", "L3R", XS2_ONLY);
+  eoprMajor(0x18)
+    .l3r(0xc, "REMS_l3r", "L3R");
+  eoprMajor(0x19)
+    .l3r(0xc, "REMU_l3r", "L3R");
+  for (unsigned bits3To0 = 0; bits3To0 < 16; bits3To0++) {
+    eoprMajor(0x1c).l3r(bits3To0, "LSATS_l3r", "L3R");
+    eoprMajor(0x1d).l3r(bits3To0, "LDDSP_l2rus", "L2RUS");
+    eoprMajor(0x1e).l3r(bits3To0, "STDSP_l2rus", "L2RUS");
+  }
+}
+
+/// Mark the most frequently executed instructions as having handlers
+/// specialised on their register operands. Each register operand multiplies the
+/// number of instantiations by 12 so only the most common 3r instructions are
+/// included.
+/// This is only done when instgen is passed --specialise-operands (the
+/// AXE_SPECIALISE_OPERANDS CMake option) since it makes Thread.cpp much slower
+/// to compile.
+void addSpecialisations()
+{
+  static const char *names[] = {
+    "ADD_3r", "SUB_3r", "LDW_3r",
+    "ADD_2rus", "ADD_mov_2rus", "SUB_2rus", "EQ_2rus", "SHL_2rus", "SHR_2rus",
+    "LDW_2rus", "STW_2rus",
+    "LDWSP_ru6", "STWSP_ru6", "LDWDP_ru6", "STWDP_ru6", "LDAWSP_ru6",
+    "LDC_ru6", "BRFT_ru6", "BRFF_ru6",
+  };
+  for (const char *name : names) {
+    Instruction *inst = findInstruction(name);
+    if (!inst) {
+      std::cerr << "Unknown instruction " << name << " in specialisations\n";
+      std::exit(1);
+    }
+    unsigned numRegs = getRegisterOperands(*inst).size();
+    if (numRegs == 0 || numRegs > 3) {
+      std::cerr << "Cannot specialise " << name << " on " << numRegs
+                << " register operands\n";
+      std::exit(1);
+    }
+    inst->setSpecialiseOperands();
+  }
+}
+
+static const char *getDecodeLayoutName(DecodeLayout layout)
+{
+  switch (layout) {
+  default:
+    assert(0 && "Unexpected layout");
+    return "?";
+  case DECODE_LAYOUT_NONE: return "DECODE_LAYOUT_NONE";
+  case DECODE_LAYOUT_3R: return "DECODE_LAYOUT_3R";
+  case DECODE_LAYOUT_RU6: return "DECODE_LAYOUT_RU6";
+  case DECODE_LAYOUT_RU6_U6: return "DECODE_LAYOUT_RU6_U6";
+  case DECODE_LAYOUT_U10: return "DECODE_LAYOUT_U10";
+  }
+}
+
+static void emitDecodeLayouts(const char *name, DecodeMajor *table)
+{
+  std::cout << "static constexpr DecodeLayout " << name;
+  std::cout << "[" << NUM_MAJOR_OPCODES << "] = {\n";
+  for (unsigned opc = 0; opc < NUM_MAJOR_OPCODES; opc++) {
+    std::cout << "  " << getDecodeLayoutName(table[opc].getLayout());
+    std::cout << (opc + 1 == NUM_MAJOR_OPCODES ? "\n" : ",\n");
+  }
+  std::cout << "};\n";
+}
+
+static void emitDecodeTable(const char *name, const char *numMinor,
+                            DecodeMajor *table, unsigned size)
+{
+  std::cout << "static constexpr DecodeTableEntry " << name;
+  std::cout << "[2][" << NUM_MAJOR_OPCODES << "][" << numMinor << "] = {\n";
+  for (unsigned target = 0; target < 2; target++) {
+    std::cout << "  {\n";
+    for (unsigned opc = 0; opc < NUM_MAJOR_OPCODES; opc++) {
+      std::cout << "    {\n";
+      for (unsigned minor = 0; minor < size; minor++) {
+        const std::string &opcode = table[opc].getOpcode(target, minor);
+        std::cout << "      { ";
+        if (opcode.empty()) {
+          std::cout << "ILLEGAL_INSTRUCTION, DECODE_OPERANDS_NONE";
+        } else {
+          std::cout << opcode << ", DECODE_OPERANDS_";
+          std::cout << table[opc].getOperands(target, minor);
+        }
+        std::cout << (minor + 1 == size ? " }\n" : " },\n");
+      }
+      std::cout << (opc + 1 == NUM_MAJOR_OPCODES ? "    }\n" : "    },\n");
+    }
+    std::cout << (target == 1 ? "  }\n" : "  },\n");
+  }
+  std::cout << "};\n";
+}
+
+static void emitDecodeTables()
+{
+  std::cout << "#ifdef EMIT_DECODE_TABLE\n";
+  emitDecodeLayouts("shortDecodeLayout", shortDecodeTable);
+  emitDecodeLayouts("pfixDecodeLayout", pfixDecodeTable);
+  emitDecodeTable("shortDecodeTable", "DECODE_MINOR_SHORT_COUNT",
+                  shortDecodeTable, DECODE_MINOR_SHORT_COUNT);
+  emitDecodeTable("pfixDecodeTable", "DECODE_MINOR_SHORT_COUNT",
+                  pfixDecodeTable, DECODE_MINOR_SHORT_COUNT);
+  emitDecodeTable("eoprDecodeTable", "DECODE_MINOR_EOPR_COUNT",
+                  eoprDecodeTable, DECODE_MINOR_EOPR_COUNT);
+  std::cout << "#endif //EMIT_DECODE_TABLE\n";
+}
+
+int main(int argc, char **argv)
+{
+  bool specialiseOperands = false;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--specialise-operands") == 0) {
+      specialiseOperands = true;
+    } else {
+      std::cerr << "Unknown option " << argv[i] << '\n';
+      return 1;
+    }
+  }
   add();
+  addEncodings();
+  if (specialiseOperands)
+    addSpecialisations();
   analyze();
   emitInstFunctions();
   emitJitInstFunctions();
   emitInstList();
   emitInstProperties();
   emitInstTraceInfo();
+  emitDecodeTables();
+  emitSpecialisedInstTables();
 }